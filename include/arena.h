@@ -0,0 +1,33 @@
+/*================================================================================
+
+File: arena.h                                                                   
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-03-09 11:37:15                                                 
+last edited: 2025-03-09 11:37:15                                                
+
+================================================================================*/
+
+#ifndef FLASHHTTP_ARENA_H
+# define FLASHHTTP_ARENA_H
+
+# include <stdint.h>
+
+# define HTTP_ARENA_ALIGNMENT 64
+
+//bump allocator over caller memory, typically a thread_local array per connection, emptied at once between messages
+typedef struct
+{
+  char *base;
+  uint32_t capacity;
+  uint32_t used;
+} http_arena_t;
+
+void http_arena_init(http_arena_t *const restrict arena, void *const memory, const uint32_t size);
+void http_arena_reset(http_arena_t *const restrict arena);
+void *http_arena_alloc(http_arena_t *const restrict arena, const uint32_t size);
+void *http_arena_tail(http_arena_t *const restrict arena, uint32_t *const restrict size);
+void http_arena_commit(http_arena_t *const restrict arena, const void *const tail, const uint32_t size);
+
+#endif
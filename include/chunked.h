@@ -0,0 +1,43 @@
+/*================================================================================
+
+File: chunked.h                                                                 
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-03-06 18:12:40                                                 
+last edited: 2025-03-15 09:47:16                                                
+
+================================================================================*/
+
+#ifndef FLASHHTTP_CHUNKED_H
+# define FLASHHTTP_CHUNKED_H
+
+# include <stdint.h>
+# include <sys/uio.h>
+
+typedef enum: uint8_t {
+  HTTP_CHUNK_SIZE,
+  HTTP_CHUNK_SIZE_WS,
+  HTTP_CHUNK_EXTENSION,
+  HTTP_CHUNK_SIZE_LF,
+  HTTP_CHUNK_DATA,
+  HTTP_CHUNK_DATA_CR,
+  HTTP_CHUNK_DATA_LF,
+  HTTP_CHUNK_TRAILER_START,
+  HTTP_CHUNK_TRAILER_NAME,
+  HTTP_CHUNK_TRAILER_VALUE,
+  HTTP_CHUNK_TRAILER_VALUE_LF,
+  HTTP_CHUNK_TRAILER_LF
+} http_chunk_stage_t;
+
+typedef struct
+{
+  uint32_t size;
+  uint8_t digits;
+  http_chunk_stage_t stage;
+} http_chunked_decoder_t;
+
+uint32_t http1_decode_chunked(http_chunked_decoder_t *const restrict decoder, char *restrict buffer, const uint32_t buffer_size, uint32_t *const restrict body_len);
+uint32_t http1_decode_chunked_iov(http_chunked_decoder_t *const restrict decoder, char *restrict buffer, const uint32_t buffer_size, struct iovec *restrict iov, uint16_t *const restrict iovcnt);
+
+#endif
@@ -5,7 +5,7 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-02-11 12:37:26                                                 
-last edited: 2025-03-03 21:42:14                                                
+last edited: 2025-03-07 11:02:44                                                
 
 ================================================================================*/
 
@@ -13,9 +13,85 @@ last edited: 2025-03-03 21:42:14
 # define FLASHFIX_DESERIALIZER_H
 
 # include <stdint.h>
+# include <sys/uio.h>
 
 # include "structs.h"
+# include "arena.h"
+
+# define HTTP_NEED_MORE UINT32_MAX
+
+# define HTTP_FILTER_MAX_HEADERS 16
+# define HTTP_FILTER_SLOTS 128
+
+# define HTTP_COMPACT_MAX_HEADERS 32
+# define HTTP_COMPACT_NONE UINT16_MAX
+
+typedef enum: uint8_t {
+  HTTP_PARSER_START_LINE,
+  HTTP_PARSER_HEADER_KEY,
+  HTTP_PARSER_HEADER_VALUE
+} http_parser_stage_t;
+
+typedef struct
+{
+  uint32_t offset;
+  uint32_t block_offset;
+  uint32_t content_length;
+  uint16_t headers_count;
+  http_parser_stage_t stage;
+  uint8_t framing_flags;
+  bool carry;
+} http_parser_t;
+
+typedef struct
+{
+  uint64_t seed;
+  const char *names[HTTP_FILTER_MAX_HEADERS];
+  uint16_t names_len[HTTP_FILTER_MAX_HEADERS];
+  uint8_t slots[HTTP_FILTER_SLOTS];
+  uint8_t names_count;
+} http_header_filter_t;
+
+typedef struct
+{
+  uint32_t hash;
+  uint16_t header;
+} http_header_slot_t;
+
+typedef struct
+{
+  http_header_slot_t *slots;
+  const http_header_t *headers;
+  uint16_t capacity;
+} http_header_index_t;
+
+//8 bytes per header instead of 24, offsets and lengths are relative to the start of the parsed buffer
+typedef struct
+{
+  uint16_t key_offsets[HTTP_COMPACT_MAX_HEADERS];
+  uint16_t key_lens[HTTP_COMPACT_MAX_HEADERS];
+  uint16_t value_offsets[HTTP_COMPACT_MAX_HEADERS];
+  uint16_t value_lens[HTTP_COMPACT_MAX_HEADERS];
+  http_header_id_t ids[HTTP_COMPACT_MAX_HEADERS];
+  uint16_t count;
+} http_compact_headers_t;
 
 uint32_t http1_deserialize(char *restrict buffer, const uint32_t buffer_size, http_response_t *const restrict response);
+uint32_t http1_deserialize_request(char *restrict buffer, const uint32_t buffer_size, http_request_t *const restrict request);
+uint32_t http1_deserialize_partial(http_parser_t *const restrict parser, char *restrict buffer, const uint32_t buffer_size, http_response_t *const restrict response);
+uint32_t http1_deserialize_request_partial(http_parser_t *const restrict parser, char *restrict buffer, const uint32_t buffer_size, http_request_t *const restrict request);
+uint32_t http1_deserialize_batch(char *restrict buffer, const uint32_t buffer_size, http_response_t *const restrict responses, uint16_t *const restrict responses_count);
+uint32_t http1_deserialize_iov(const struct iovec *restrict iov, const uint16_t iovcnt, http_response_t *const restrict response, char *restrict scratch, const uint32_t scratch_size);
+uint32_t http1_deserialize_filtered(char *restrict buffer, const uint32_t buffer_size, http_response_t *const restrict response, const http_header_filter_t *const restrict filter);
+uint32_t http1_deserialize_indexed(char *restrict buffer, const uint32_t buffer_size, http_response_t *const restrict response, http_header_index_t *const restrict index);
+uint32_t http1_deserialize_request_indexed(char *restrict buffer, const uint32_t buffer_size, http_request_t *const restrict request, http_header_index_t *const restrict index);
+uint32_t http1_deserialize_arena(char *restrict buffer, const uint32_t buffer_size, http_response_t *const restrict response, http_arena_t *const restrict arena);
+uint32_t http1_deserialize_request_arena(char *restrict buffer, const uint32_t buffer_size, http_request_t *const restrict request, http_arena_t *const restrict arena);
+uint32_t http1_deserialize_compact(char *restrict buffer, const uint32_t buffer_size, http_response_t *const restrict response, http_compact_headers_t *const restrict compact);
+uint32_t http1_deserialize_request_compact(char *restrict buffer, const uint32_t buffer_size, http_request_t *const restrict request, http_compact_headers_t *const restrict compact);
+uint16_t http_compact_find_id(const http_compact_headers_t *const restrict compact, const http_header_id_t id, const uint16_t from);
+uint16_t http_compact_find(const http_compact_headers_t *const restrict compact, const char *const restrict buffer, const char *const restrict key, const uint16_t key_len, const uint16_t from);
+const http_header_t *http_header_find(const http_header_index_t *const restrict index, const char *const restrict key, const uint16_t key_len, uint16_t *const restrict cursor);
+bool http_header_filter_compile(http_header_filter_t *const restrict filter, const char *const *restrict names, const uint8_t names_count);
 
 #endif
\ No newline at end of file
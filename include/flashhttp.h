@@ -5,7 +5,7 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-02-12 13:35:28                                                 
-last edited: 2025-03-05 21:11:45                                                
+last edited: 2025-03-14 11:52:03                                                
 
 ================================================================================*/
 
@@ -14,6 +14,14 @@ last edited: 2025-03-05 21:11:45
 
 # include "serializer.h"
 # include "deserializer.h"
+# include "chunked.h"
+# include "uring.h"
+# include "ring.h"
+# include "arena.h"
+# include "hpack.h"
+# include "http2.h"
+# include "qpack.h"
+# include "http3.h"
 
 //TODO explore <stdbit.h> for bit manipulation
 
@@ -0,0 +1,52 @@
+/*================================================================================
+
+File: hpack.h                                                                   
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-03-10 09:12:40                                                 
+last edited: 2025-03-10 09:12:40                                                
+
+================================================================================*/
+
+#ifndef FLASHHTTP_HPACK_H
+# define FLASHHTTP_HPACK_H
+
+# include <stdint.h>
+
+# include "structs.h"
+
+//SETTINGS_HEADER_TABLE_SIZE until the peer says otherwise
+# define HTTP_HPACK_DEFAULT_TABLE_SIZE 4096
+# define HTTP_HPACK_ENTRY_OVERHEAD 32
+//bytes of memory needed by a dynamic table of the given size, data and entries together
+# define HTTP_HPACK_TABLE_MEMORY(size) ((size) + ((size) / HTTP_HPACK_ENTRY_OVERHEAD) * sizeof(http_hpack_entry_t))
+
+typedef struct
+{
+  uint32_t offset;
+  uint16_t name_len;
+  uint16_t value_len;
+  http_header_id_t id;
+} http_hpack_entry_t;
+
+//names and values are stored back to back in a byte ring, the oldest entries are evicted first
+typedef struct
+{
+  http_hpack_entry_t *entries;
+  char *data;
+  uint32_t capacity;
+  uint32_t max_size;
+  uint32_t size;
+  uint32_t head;
+  uint16_t entries_capacity;
+  uint16_t first;
+  uint16_t count;
+} http_hpack_table_t;
+
+void http_hpack_table_init(http_hpack_table_t *const restrict table, void *const memory, const uint32_t size);
+uint32_t http_hpack_encode(http_hpack_table_t *const restrict table, char *restrict buffer, const http_header_t *restrict headers, const uint16_t headers_count);
+uint8_t http_hpack_encode_table_size(http_hpack_table_t *const restrict table, char *restrict buffer, const uint32_t size);
+bool http_hpack_decode(http_hpack_table_t *const restrict table, char *restrict block, const uint32_t block_len, http_header_t *restrict headers, uint16_t *const restrict headers_count, char *restrict scratch, const uint32_t scratch_size);
+
+#endif
@@ -0,0 +1,107 @@
+/*================================================================================
+
+File: http2.h                                                                   
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-03-12 18:03:51                                                 
+last edited: 2025-03-15 13:46:12                                                
+
+================================================================================*/
+
+#ifndef FLASHHTTP_HTTP2_H
+# define FLASHHTTP_HTTP2_H
+
+# include <stdint.h>
+
+# include "structs.h"
+# include "hpack.h"
+
+# define HTTP2_PREFACE "PRI * HTTP/2.0\r\n\r\nSM\r\n\r\n"
+# define HTTP2_FRAME_HEADER_SIZE 9
+//SETTINGS_MAX_FRAME_SIZE until the peer says otherwise, and the biggest value it can say
+# define HTTP2_DEFAULT_MAX_FRAME_SIZE 16384
+# define HTTP2_MAX_FRAME_SIZE 16777215
+# define HTTP2_MAX_WINDOW_SIZE 2147483647
+
+# define HTTP2_FLAG_END_STREAM 0x01
+# define HTTP2_FLAG_ACK 0x01
+# define HTTP2_FLAG_END_HEADERS 0x04
+# define HTTP2_FLAG_PADDED 0x08
+# define HTTP2_FLAG_PRIORITY 0x20
+
+//RFC 9113 section 6.5.2, UINT32_MAX stands for no limit
+# define HTTP2_DEFAULT_SETTINGS ((http2_settings_t){ 4096, 1, UINT32_MAX, 65535, HTTP2_DEFAULT_MAX_FRAME_SIZE, UINT32_MAX })
+
+typedef enum: uint8_t {
+  HTTP2_DATA,
+  HTTP2_HEADERS,
+  HTTP2_PRIORITY,
+  HTTP2_RST_STREAM,
+  HTTP2_SETTINGS,
+  HTTP2_PUSH_PROMISE,
+  HTTP2_PING,
+  HTTP2_GOAWAY,
+  HTTP2_WINDOW_UPDATE,
+  HTTP2_CONTINUATION
+} http2_frame_type_t;
+
+typedef enum: uint32_t {
+  HTTP2_NO_ERROR,
+  HTTP2_PROTOCOL_ERROR,
+  HTTP2_INTERNAL_ERROR,
+  HTTP2_FLOW_CONTROL_ERROR,
+  HTTP2_SETTINGS_TIMEOUT,
+  HTTP2_STREAM_CLOSED,
+  HTTP2_FRAME_SIZE_ERROR,
+  HTTP2_REFUSED_STREAM,
+  HTTP2_CANCEL,
+  HTTP2_COMPRESSION_ERROR,
+  HTTP2_CONNECT_ERROR,
+  HTTP2_ENHANCE_YOUR_CALM,
+  HTTP2_INADEQUATE_SECURITY,
+  HTTP2_HTTP_1_1_REQUIRED
+} http2_error_t;
+
+typedef struct
+{
+  uint32_t header_table_size;
+  uint32_t enable_push;
+  uint32_t max_concurrent_streams;
+  uint32_t initial_window_size;
+  uint32_t max_frame_size;
+  uint32_t max_header_list_size;
+} http2_settings_t;
+
+//payload points into the parsed buffer, already stripped of padding, priority fields and the promised stream id
+typedef struct
+{
+  char *payload;
+  uint32_t payload_len;
+  uint32_t stream_id;
+  uint32_t last_stream_id;
+  uint32_t promised_stream_id;
+  uint32_t error_code;
+  uint32_t window_increment;
+  http2_frame_type_t type;
+  uint8_t flags;
+} http2_frame_t;
+
+uint32_t http2_deserialize_frame(char *restrict buffer, const uint32_t buffer_size, http2_frame_t *const restrict frame, const uint32_t max_frame_size);
+bool http2_deserialize_settings(const http2_frame_t *const restrict frame, http2_settings_t *const restrict settings);
+bool http2_deserialize_request(http_hpack_table_t *const restrict table, char *restrict block, const uint32_t block_len, http_request_t *const restrict request, char *restrict scratch, const uint32_t scratch_size);
+bool http2_deserialize_response(http_hpack_table_t *const restrict table, char *restrict block, const uint32_t block_len, http_response_t *const restrict response, char *restrict scratch, const uint32_t scratch_size);
+uint32_t http2_serialize_data(char *restrict buffer, const uint32_t stream_id, const char *restrict data, const uint32_t data_len, const uint8_t pad_len, const uint8_t flags);
+uint32_t http2_serialize_headers(char *buffer, const uint32_t stream_id, const char *block, const uint32_t block_len, const uint32_t max_frame_size, const uint8_t flags);
+uint32_t http2_serialize_settings(char *restrict buffer, const http2_settings_t *restrict settings);
+uint32_t http2_serialize_settings_ack(char *restrict buffer);
+uint32_t http2_serialize_window_update(char *restrict buffer, const uint32_t stream_id, const uint32_t increment);
+uint32_t http2_serialize_ping(char *restrict buffer, const char *restrict opaque, const bool ack);
+uint32_t http2_serialize_rst_stream(char *restrict buffer, const uint32_t stream_id, const uint32_t error_code);
+uint32_t http2_serialize_goaway(char *restrict buffer, const uint32_t last_stream_id, const uint32_t error_code, const char *restrict debug, const uint32_t debug_len);
+uint32_t http2_serialize_request(char *restrict buffer, http_hpack_table_t *const restrict table, const uint32_t stream_id, const http_request_t *restrict request, const uint32_t max_frame_size);
+uint32_t http2_serialize_response(char *restrict buffer, http_hpack_table_t *const restrict table, const uint32_t stream_id, const http_response_t *restrict response, const uint32_t max_frame_size);
+int64_t http2_serialize_request_write(const int fd, http_hpack_table_t *const restrict table, const uint32_t stream_id, const http_request_t *restrict request, const uint32_t max_frame_size, const uint32_t window, uint32_t *const restrict body_sent);
+int64_t http2_serialize_response_write(const int fd, http_hpack_table_t *const restrict table, const uint32_t stream_id, const http_response_t *restrict response, const uint32_t max_frame_size, const uint32_t window, uint32_t *const restrict body_sent);
+
+#endif
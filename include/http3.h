@@ -0,0 +1,77 @@
+/*================================================================================
+
+File: http3.h                                                                   
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-03-14 10:26:18                                                 
+last edited: 2025-03-14 11:52:03                                                
+
+================================================================================*/
+
+#ifndef FLASHHTTP_HTTP3_H
+# define FLASHHTTP_HTTP3_H
+
+# include <stdint.h>
+
+# include "structs.h"
+# include "qpack.h"
+
+//biggest value of a QUIC variable-length integer
+# define HTTP3_VARINT_MAX 4611686018427387903ULL
+//a frame type and a frame length of 8 bytes each
+# define HTTP3_FRAME_HEADER_MAX_SIZE 16
+
+//RFC 9114 section 7.2.4.2, UINT64_MAX stands for no limit
+# define HTTP3_DEFAULT_SETTINGS ((http3_settings_t){ 0, UINT64_MAX, 0 })
+
+//the first varint of every unidirectional stream
+typedef enum: uint8_t {
+  HTTP3_STREAM_CONTROL,
+  HTTP3_STREAM_PUSH,
+  HTTP3_STREAM_QPACK_ENCODER,
+  HTTP3_STREAM_QPACK_DECODER
+} http3_stream_type_t;
+
+typedef enum: uint8_t {
+  HTTP3_DATA = 0x00,
+  HTTP3_HEADERS = 0x01,
+  HTTP3_CANCEL_PUSH = 0x03,
+  HTTP3_SETTINGS = 0x04,
+  HTTP3_PUSH_PROMISE = 0x05,
+  HTTP3_GOAWAY = 0x07,
+  HTTP3_MAX_PUSH_ID = 0x0D
+} http3_frame_type_t;
+
+typedef struct
+{
+  uint64_t qpack_max_table_capacity;
+  uint64_t max_field_section_size;
+  uint64_t qpack_blocked_streams;
+} http3_settings_t;
+
+//payload points into the parsed buffer. id is the stream or push ID carried by GOAWAY, CANCEL_PUSH, MAX_PUSH_ID and PUSH_PROMISE
+typedef struct
+{
+  char *payload;
+  uint64_t type;
+  uint64_t id;
+  uint32_t payload_len;
+} http3_frame_t;
+
+uint8_t http3_serialize_varint(char *restrict buffer, const uint64_t value);
+uint8_t http3_deserialize_varint(const char *restrict buffer, const uint32_t buffer_size, uint64_t *const restrict value);
+uint8_t http3_deserialize_frame_header(const char *restrict buffer, const uint32_t buffer_size, uint64_t *const restrict type, uint64_t *const restrict length);
+uint32_t http3_deserialize_frame(char *restrict buffer, const uint32_t buffer_size, http3_frame_t *const restrict frame, const uint32_t max_frame_size);
+bool http3_deserialize_settings(const http3_frame_t *const restrict frame, http3_settings_t *const restrict settings);
+uint32_t http3_deserialize_request(http_qpack_decoder_t *const restrict decoder, char *restrict block, const uint32_t block_len, http_request_t *const restrict request, char *restrict scratch, const uint32_t scratch_size);
+uint32_t http3_deserialize_response(http_qpack_decoder_t *const restrict decoder, char *restrict block, const uint32_t block_len, http_response_t *const restrict response, char *restrict scratch, const uint32_t scratch_size);
+uint8_t http3_serialize_frame_header(char *restrict buffer, const uint64_t type, const uint64_t length);
+uint32_t http3_serialize_data(char *restrict buffer, const char *restrict data, const uint32_t data_len);
+uint32_t http3_serialize_headers(char *buffer, const char *block, const uint32_t block_len);
+uint32_t http3_serialize_settings(char *restrict buffer, const http3_settings_t *restrict settings);
+uint32_t http3_serialize_goaway(char *restrict buffer, const uint64_t id);
+uint32_t http3_serialize_request(char *restrict buffer, http_qpack_encoder_t *const restrict encoder, const uint32_t stream_id, const http_request_t *restrict request, char *restrict encoder_stream, uint32_t *const restrict encoder_stream_len);
+uint32_t http3_serialize_response(char *restrict buffer, http_qpack_encoder_t *const restrict encoder, const uint32_t stream_id, const http_response_t *restrict response, char *restrict encoder_stream, uint32_t *const restrict encoder_stream_len);
+
+#endif
@@ -0,0 +1,62 @@
+/*================================================================================
+
+File: qpack.h                                                                   
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-03-14 10:26:18                                                 
+last edited: 2025-03-14 11:52:03                                                
+
+================================================================================*/
+
+#ifndef FLASHHTTP_QPACK_H
+# define FLASHHTTP_QPACK_H
+
+# include <stdint.h>
+
+# include "structs.h"
+# include "hpack.h"
+
+//the dynamic table is stored like an HPACK one, only addressed by absolute index
+# define HTTP_QPACK_TABLE_MEMORY(capacity) HTTP_HPACK_TABLE_MEMORY(capacity)
+//field sections that reference the dynamic table and wait for the peer to acknowledge them
+# define HTTP_QPACK_MAX_PENDING 16
+
+typedef struct
+{
+  uint32_t stream_id;
+  uint32_t min_index;
+} http_qpack_pending_t;
+
+//only references entries the peer acknowledged, so its streams never block
+typedef struct
+{
+  http_hpack_table_t table;
+  http_qpack_pending_t pending[HTTP_QPACK_MAX_PENDING];
+  uint32_t max_entries;
+  uint32_t insert_count;
+  uint32_t known_received_count;
+  uint8_t pending_count;
+  bool capacity_sent;
+} http_qpack_encoder_t;
+
+typedef struct
+{
+  http_hpack_table_t table;
+  uint32_t max_entries;
+  uint32_t insert_count;
+  uint32_t acknowledged_count;
+  uint32_t required_insert_count;
+} http_qpack_decoder_t;
+
+void http_qpack_encoder_init(http_qpack_encoder_t *const restrict encoder, void *const memory, const uint32_t capacity, const uint32_t max_table_capacity);
+void http_qpack_decoder_init(http_qpack_decoder_t *const restrict decoder, void *const memory, const uint32_t max_table_capacity);
+uint32_t http_qpack_encode(http_qpack_encoder_t *const restrict encoder, const uint32_t stream_id, char *restrict buffer, const http_header_t *restrict headers, const uint16_t headers_count, char *restrict encoder_stream, uint32_t *const restrict encoder_stream_len);
+uint32_t http_qpack_encoder_receive(http_qpack_encoder_t *const restrict encoder, const char *restrict buffer, const uint32_t buffer_size);
+uint32_t http_qpack_decode(http_qpack_decoder_t *const restrict decoder, char *restrict block, const uint32_t block_len, http_header_t *restrict headers, uint16_t *const restrict headers_count, char *restrict scratch, const uint32_t scratch_size);
+uint32_t http_qpack_decoder_receive(http_qpack_decoder_t *const restrict decoder, char *restrict buffer, const uint32_t buffer_size, char *restrict scratch, const uint32_t scratch_size);
+uint8_t http_qpack_encode_section_ack(http_qpack_decoder_t *const restrict decoder, char *restrict buffer, const uint32_t stream_id);
+uint8_t http_qpack_encode_insert_count(http_qpack_decoder_t *const restrict decoder, char *restrict buffer);
+uint8_t http_qpack_encode_stream_cancel(char *restrict buffer, const uint32_t stream_id);
+
+#endif
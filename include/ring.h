@@ -0,0 +1,37 @@
+/*================================================================================
+
+File: ring.h                                                                    
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-03-08 16:02:47                                                 
+last edited: 2025-03-08 16:02:47                                                
+
+================================================================================*/
+
+#ifndef FLASHHTTP_RING_H
+# define FLASHHTTP_RING_H
+
+# include <stdint.h>
+
+//the same pages are mapped twice back to back, so [head, head + readable) and [tail, tail + writable) never wrap
+typedef struct
+{
+  char *data;
+  uint32_t size;
+  uint32_t head;
+  uint32_t tail;
+} http_ring_t;
+
+int32_t http_ring_init(http_ring_t *const restrict ring, const uint32_t size);
+void http_ring_destroy(http_ring_t *const restrict ring);
+char *http_ring_read_ptr(const http_ring_t *const restrict ring);
+uint32_t http_ring_readable(const http_ring_t *const restrict ring);
+char *http_ring_write_ptr(const http_ring_t *const restrict ring);
+uint32_t http_ring_writable(const http_ring_t *const restrict ring);
+void http_ring_consume(http_ring_t *const restrict ring, const uint32_t len);
+void http_ring_produce(http_ring_t *const restrict ring, const uint32_t len);
+int64_t http_ring_recv(http_ring_t *const restrict ring, const int fd);
+int64_t http_ring_send(http_ring_t *const restrict ring, const int fd);
+
+#endif
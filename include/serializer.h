@@ -5,7 +5,7 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-02-11 12:37:26                                                 
-last edited: 2025-03-03 21:42:14                                                
+last edited: 2025-03-15 12:47:31                                                
 
 ================================================================================*/
 
@@ -13,14 +13,51 @@ last edited: 2025-03-03 21:42:14
 # define FLASHFIX_SERIALIZER_H
 
 # include <stdint.h>
+# include <sys/types.h>
+# include <sys/uio.h>
 
 # include "structs.h"
 
 # define AVG_HEADER_COUNT 8
 # define IOV_MAX __IOV_MAX
+# define HTTP_TEMPLATE_SIZE 2048
+# define HTTP_TEMPLATE_MAX_SLOTS 8
+//below this body size pinning pages costs more than copying them
+# define HTTP_ZEROCOPY_THRESHOLD 16384
+
+//constant bytes of a request, split in runs around the variable slots: run i is buffer[runs_end[i - 1], runs_end[i])
+//with content_length set, a Content-Length line built from the body length goes before the final CRLF at every send
+typedef struct
+{
+  alignas(64) char buffer[HTTP_TEMPLATE_SIZE];
+  uint16_t runs_end[HTTP_TEMPLATE_MAX_SLOTS + 1];
+  uint8_t slots_count;
+  bool content_length;
+} http_request_template_t;
+
+//completion state of the MSG_ZEROCOPY sends on a socket, every id below completed is done
+typedef struct
+{
+  uint32_t next_id;
+  uint32_t completed;
+  int fd;
+  bool copied;
+} http_zerocopy_t;
 
 uint32_t http1_serialize(char *restrict buffer, const http_request_t *restrict request);
 int32_t http1_serialize_write(const int fd, const http_request_t *restrict request);
-//TODO support for http2 and http3
+uint32_t http1_serialize_batch(char *restrict buffer, const http_request_t *restrict requests, const uint16_t requests_count);
+int64_t http1_serialize_batch_write(const int fd, const http_request_t *restrict requests, const uint16_t requests_count);
+uint32_t http1_serialize_response(char *restrict buffer, const http_response_t *restrict response);
+int32_t http1_serialize_response_write(const int fd, const http_response_t *restrict response);
+int64_t http1_serialize_write_file(const int fd, const http_request_t *restrict request, const int body_fd, const off_t body_offset, const uint32_t body_len);
+int64_t http1_serialize_response_write_file(const int fd, const http_response_t *restrict response, const int body_fd, const off_t body_offset, const uint32_t body_len);
+int32_t http_zerocopy_init(http_zerocopy_t *restrict tracker, const int fd);
+int64_t http1_serialize_write_zerocopy(http_zerocopy_t *restrict tracker, const http_request_t *restrict request, uint32_t *restrict handle);
+int32_t http_zerocopy_reap(http_zerocopy_t *restrict tracker);
+bool http_zerocopy_done(const http_zerocopy_t *restrict tracker, const uint32_t handle);
+uint16_t http1_template_compile(http_request_template_t *restrict template, const http_request_t *restrict request);
+uint32_t http1_template_serialize(char *restrict buffer, const http_request_template_t *restrict template, const struct iovec *restrict values, const char *restrict body, const uint32_t body_len);
+int32_t http1_template_write(const int fd, const http_request_template_t *restrict template, const struct iovec *restrict values, const char *restrict body, const uint32_t body_len);
 
 #endif
\ No newline at end of file
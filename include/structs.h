@@ -5,7 +5,7 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-02-13 13:38:07                                                 
-last edited: 2025-03-04 12:17:51                                                
+last edited: 2025-03-15 13:27:18                                                
 
 ================================================================================*/
 
@@ -33,14 +33,79 @@ typedef enum: uint8_t {
   HTTP_3_0
 } http_version_t;
 
+typedef enum: uint8_t {
+  HTTP_FRAMING_NONE,
+  HTTP_FRAMING_CONTENT_LENGTH,
+  HTTP_FRAMING_CHUNKED,
+  HTTP_FRAMING_CLOSE
+} http_framing_t;
+
+typedef enum: uint8_t {
+  HTTP_HEADER_UNKNOWN,
+  HTTP_HEADER_ACCEPT,
+  HTTP_HEADER_ACCEPT_CHARSET,
+  HTTP_HEADER_ACCEPT_ENCODING,
+  HTTP_HEADER_ACCEPT_LANGUAGE,
+  HTTP_HEADER_ACCEPT_RANGES,
+  HTTP_HEADER_ACCESS_CONTROL_ALLOW_ORIGIN,
+  HTTP_HEADER_AGE,
+  HTTP_HEADER_ALLOW,
+  HTTP_HEADER_AUTHORIZATION,
+  HTTP_HEADER_CACHE_CONTROL,
+  HTTP_HEADER_CONNECTION,
+  HTTP_HEADER_CONTENT_DISPOSITION,
+  HTTP_HEADER_CONTENT_ENCODING,
+  HTTP_HEADER_CONTENT_LANGUAGE,
+  HTTP_HEADER_CONTENT_LENGTH,
+  HTTP_HEADER_CONTENT_LOCATION,
+  HTTP_HEADER_CONTENT_RANGE,
+  HTTP_HEADER_CONTENT_TYPE,
+  HTTP_HEADER_COOKIE,
+  HTTP_HEADER_DATE,
+  HTTP_HEADER_ETAG,
+  HTTP_HEADER_EXPECT,
+  HTTP_HEADER_EXPIRES,
+  HTTP_HEADER_HOST,
+  HTTP_HEADER_IF_MATCH,
+  HTTP_HEADER_IF_MODIFIED_SINCE,
+  HTTP_HEADER_IF_NONE_MATCH,
+  HTTP_HEADER_IF_RANGE,
+  HTTP_HEADER_IF_UNMODIFIED_SINCE,
+  HTTP_HEADER_KEEP_ALIVE,
+  HTTP_HEADER_LAST_MODIFIED,
+  HTTP_HEADER_LINK,
+  HTTP_HEADER_LOCATION,
+  HTTP_HEADER_ORIGIN,
+  HTTP_HEADER_PRAGMA,
+  HTTP_HEADER_PROXY_AUTHENTICATE,
+  HTTP_HEADER_PROXY_AUTHORIZATION,
+  HTTP_HEADER_RANGE,
+  HTTP_HEADER_REFERER,
+  HTTP_HEADER_RETRY_AFTER,
+  HTTP_HEADER_SERVER,
+  HTTP_HEADER_SET_COOKIE,
+  HTTP_HEADER_STRICT_TRANSPORT_SECURITY,
+  HTTP_HEADER_TE,
+  HTTP_HEADER_TRAILER,
+  HTTP_HEADER_TRANSFER_ENCODING,
+  HTTP_HEADER_UPGRADE,
+  HTTP_HEADER_USER_AGENT,
+  HTTP_HEADER_VARY,
+  HTTP_HEADER_VIA,
+  HTTP_HEADER_WWW_AUTHENTICATE,
+  HTTP_HEADER_X_FORWARDED_FOR
+} http_header_id_t;
+
 //TODO alignment??
 
+//a well-known id overrides key when serializing: zero the struct, or reset id, before setting key by hand
 typedef struct
 {
   char *key;
   char *value;
   uint16_t key_len;
   uint16_t value_len;
+  http_header_id_t id;
 } http_header_t;
 
 typedef struct
@@ -53,16 +118,24 @@ typedef struct
   uint16_t headers_count;
   char *body;
   uint32_t body_len;
+  http_framing_t framing;
+  bool keep_alive;
+  bool emit_content_length;
 } http_request_t;
 
 typedef struct
 {
+  http_version_t version;
   uint16_t status_code;
   char *reason_phrase;
   uint16_t reason_phrase_len;
   http_header_t *headers;
   uint16_t headers_count;
   char *body;
+  uint32_t body_len;
+  http_framing_t framing;
+  bool keep_alive;
+  bool emit_content_length;
 } http_response_t;
 
 #endif
\ No newline at end of file
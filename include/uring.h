@@ -0,0 +1,84 @@
+/*================================================================================
+
+File: uring.h                                                                   
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-03-07 10:21:03                                                 
+last edited: 2025-03-15 13:34:46                                                
+
+================================================================================*/
+
+#ifndef FLASHHTTP_URING_H
+# define FLASHHTTP_URING_H
+
+# include <stdint.h>
+# include <sys/uio.h>
+
+# include "structs.h"
+
+# define HTTP_URING_SLOT_IOVCNT 128
+# define HTTP_URING_STAGING_SIZE 2048
+//fd is an index into the files registered with http_uring_register_files
+# define HTTP_URING_FIXED_FILE (1 << 0)
+
+//keeps the iovecs and the staged bytes of a request alive until its completion is reaped
+//buffer is the registered buffer of a fixed write, NULL for a vectored one. A short write resumes at written
+typedef struct
+{
+  struct iovec iov[HTTP_URING_SLOT_IOVCNT];
+  char staging[HTTP_URING_STAGING_SIZE];
+  char *buffer;
+  uint64_t cookie;
+  uint32_t length;
+  uint32_t written;
+  int32_t fd;
+  uint16_t iov_first;
+  uint16_t iovcnt;
+  uint16_t buffer_index;
+  uint16_t next_free;
+  uint8_t sqe_flags;
+} http_uring_slot_t;
+
+typedef struct
+{
+  struct io_uring_sqe *sqes;
+  struct io_uring_cqe *cqes;
+  uint32_t *sq_head;
+  uint32_t *sq_tail;
+  uint32_t *sq_array;
+  uint32_t *cq_head;
+  uint32_t *cq_tail;
+  void *sq_ring;
+  void *cq_ring;
+  uint32_t sq_ring_size;
+  uint32_t cq_ring_size;
+  uint32_t sqes_size;
+  uint32_t sq_mask;
+  uint32_t cq_mask;
+  uint32_t sq_entries;
+  uint32_t sq_local_tail;
+  uint32_t sq_submitted;
+  http_uring_slot_t *slots;
+  uint16_t slots_count;
+  uint16_t free_slot;
+  int fd;
+} http_uring_t;
+
+typedef struct
+{
+  uint64_t cookie;
+  int32_t result;
+  uint32_t length;
+} http_uring_completion_t;
+
+int32_t http_uring_init(http_uring_t *const restrict ring, http_uring_slot_t *restrict slots, const uint16_t slots_count);
+void http_uring_destroy(http_uring_t *const restrict ring);
+int32_t http_uring_register_buffers(http_uring_t *const restrict ring, const struct iovec *restrict buffers, const uint16_t buffers_count);
+int32_t http_uring_register_files(http_uring_t *const restrict ring, const int *restrict fds, const uint16_t fds_count);
+int32_t http1_uring_prep_write(http_uring_t *const restrict ring, const int fd, const http_request_t *restrict request, const uint64_t cookie, const uint8_t flags);
+int32_t http1_uring_prep_write_fixed(http_uring_t *const restrict ring, const int fd, const http_request_t *restrict request, char *restrict buffer, const uint32_t buffer_size, const uint16_t buffer_index, const uint64_t cookie, const uint8_t flags);
+int32_t http_uring_submit(http_uring_t *const restrict ring, const uint32_t wait_completions);
+uint16_t http_uring_reap(http_uring_t *const restrict ring, http_uring_completion_t *restrict completions, const uint16_t max_completions);
+
+#endif
@@ -0,0 +1,68 @@
+/*================================================================================
+
+File: arena.c                                                                   
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-03-09 11:37:15                                                 
+last edited: 2025-03-09 11:37:15                                                
+
+================================================================================*/
+
+#include "common.h"
+#include "arena.h"
+
+static inline uint32_t align_up(const uint32_t offset);
+
+//the base is aligned once here, so every allocation only rounds its offset
+void http_arena_init(http_arena_t *const restrict arena, void *const memory, const uint32_t size)
+{
+  const uint32_t padding = -(uintptr_t)memory & (HTTP_ARENA_ALIGNMENT - 1);
+
+  *arena = (http_arena_t){
+    .base = (char *)memory + padding,
+    .capacity = (size > padding) * (size - padding),
+    .used = 0
+  };
+}
+
+void http_arena_reset(http_arena_t *const restrict arena)
+{
+  arena->used = 0;
+}
+
+void *http_arena_alloc(http_arena_t *const restrict arena, const uint32_t size)
+{
+  const uint32_t offset = align_up(arena->used);
+  if (UNLIKELY((offset > arena->capacity) || (size > arena->capacity - offset)))
+    return NULL;
+
+  arena->used = offset + size;
+
+  return arena->base + offset;
+}
+
+//the last allocation can grow in place: tail hands out all the free space, commit keeps only what was used
+void *http_arena_tail(http_arena_t *const restrict arena, uint32_t *const restrict size)
+{
+  const uint32_t offset = align_up(arena->used);
+  if (UNLIKELY(offset > arena->capacity))
+  {
+    *size = 0;
+    return NULL;
+  }
+
+  *size = arena->capacity - offset;
+
+  return arena->base + offset;
+}
+
+void http_arena_commit(http_arena_t *const restrict arena, const void *const tail, const uint32_t size)
+{
+  arena->used = ((const char *)tail - arena->base) + size;
+}
+
+static inline uint32_t align_up(const uint32_t offset)
+{
+  return (offset + HTTP_ARENA_ALIGNMENT - 1) & ~(uint32_t)(HTTP_ARENA_ALIGNMENT - 1);
+}
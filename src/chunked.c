@@ -0,0 +1,318 @@
+/*================================================================================
+
+File: chunked.c                                                                 
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-03-06 18:12:40                                                 
+last edited: 2025-03-15 09:47:16                                                
+
+================================================================================*/
+
+#include <string.h>
+#include <stddef.h>
+
+#include "common.h"
+#include "chunked.h"
+#include "deserializer.h"
+
+# define MAX_CHUNK_SIZE_DIGITS (sizeof(uint32_t) << 1)
+
+typedef struct
+{
+  char *out;
+  struct iovec *iov;
+  uint16_t iovcnt;
+  uint16_t max_iov;
+} chunk_sink_t;
+
+static inline uint32_t decode_chunked(http_chunked_decoder_t *const restrict decoder, char *restrict buffer, const uint32_t buffer_size, chunk_sink_t *const restrict sink, const bool compact);
+static inline bool emit_data(chunk_sink_t *const restrict sink, char *restrict data, const uint32_t len, const bool compact);
+static inline uint8_t parse_hex_swar(const char *buffer, uint32_t *const restrict size);
+static inline bool is_hex(const char c);
+static inline bool is_tchar(const char c);
+static inline char *skip_field_text(char *p, const char *const end);
+static inline uint8_t hex_value(const char c);
+
+uint32_t http1_decode_chunked(http_chunked_decoder_t *const restrict decoder, char *restrict buffer, const uint32_t buffer_size, uint32_t *const restrict body_len)
+{
+  chunk_sink_t sink = { .out = buffer };
+
+  const uint32_t consumed = decode_chunked(decoder, buffer, buffer_size, &sink, true);
+  *body_len = sink.out - buffer;
+
+  return consumed;
+}
+
+uint32_t http1_decode_chunked_iov(http_chunked_decoder_t *const restrict decoder, char *restrict buffer, const uint32_t buffer_size, struct iovec *restrict iov, uint16_t *const restrict iovcnt)
+{
+  chunk_sink_t sink = { .iov = iov, .max_iov = *iovcnt };
+
+  const uint32_t consumed = decode_chunked(decoder, buffer, buffer_size, &sink, false);
+  *iovcnt = sink.iovcnt;
+
+  return consumed;
+}
+
+static inline uint32_t decode_chunked(http_chunked_decoder_t *const restrict decoder, char *restrict buffer, const uint32_t buffer_size, chunk_sink_t *const restrict sink, const bool compact)
+{
+  char *const buffer_end = buffer + buffer_size;
+  char *p = buffer;
+
+  uint32_t size = decoder->size;
+  uint8_t digits = decoder->digits;
+  http_chunk_stage_t stage = decoder->stage;
+
+  while (LIKELY(p < buffer_end))
+  {
+    switch (stage)
+    {
+      case HTTP_CHUNK_SIZE:
+      {
+        if (LIKELY((digits == 0) & (buffer_end - p > (ptrdiff_t)sizeof(uint64_t))))
+        {
+          digits = parse_hex_swar(p, &size);
+          p += digits;
+        }
+
+        while (LIKELY(p < buffer_end) && is_hex(*p))
+        {
+          if (UNLIKELY(++digits > MAX_CHUNK_SIZE_DIGITS))
+            return 0;
+          size = (size << 4) | hex_value(*p++);
+        }
+        if (UNLIKELY(p == buffer_end))
+          break;
+
+        const bool valid_size = (digits != 0) & ((*p == ';') | (*p == ' ') | (*p == '\t') | (*p == '\r'));
+        if (UNLIKELY(!valid_size))
+          return 0;
+
+        stage = HTTP_CHUNK_SIZE_WS;
+        break;
+      }
+
+      case HTTP_CHUNK_SIZE_WS:
+      {
+        while (LIKELY(p < buffer_end) && ((*p == ' ') | (*p == '\t')))
+          p++;
+        if (UNLIKELY(p == buffer_end))
+          break;
+
+        const bool valid_separator = (*p == ';') | (*p == '\r');
+        if (UNLIKELY(!valid_separator))
+          return 0;
+
+        stage = (*p++ == ';') ? HTTP_CHUNK_EXTENSION : HTTP_CHUNK_SIZE_LF;
+        break;
+      }
+
+      case HTTP_CHUNK_EXTENSION:
+      {
+        p = skip_field_text(p, buffer_end);
+        if (UNLIKELY(p == buffer_end))
+          break;
+        if (UNLIKELY(*p++ != '\r'))
+          return 0;
+
+        stage = HTTP_CHUNK_SIZE_LF;
+        break;
+      }
+
+      case HTTP_CHUNK_SIZE_LF:
+      {
+        if (UNLIKELY(*p++ != '\n'))
+          return 0;
+
+        digits = 0;
+        stage = (size == 0) ? HTTP_CHUNK_TRAILER_START : HTTP_CHUNK_DATA;
+        break;
+      }
+
+      case HTTP_CHUNK_DATA:
+      {
+        const uint32_t available = buffer_end - p;
+        const uint32_t len = (size < available) ? size : available;
+
+        if (UNLIKELY(!emit_data(sink, p, len, compact)))
+        {
+          decoder->size = size;
+          decoder->digits = digits;
+          decoder->stage = stage;
+          return p - buffer;
+        }
+        p += len;
+        size -= len;
+
+        stage = (size == 0) ? HTTP_CHUNK_DATA_CR : HTTP_CHUNK_DATA;
+        break;
+      }
+
+      case HTTP_CHUNK_DATA_CR:
+      {
+        if (UNLIKELY(*p++ != '\r'))
+          return 0;
+
+        stage = HTTP_CHUNK_DATA_LF;
+        break;
+      }
+
+      case HTTP_CHUNK_DATA_LF:
+      {
+        if (UNLIKELY(*p++ != '\n'))
+          return 0;
+
+        stage = HTTP_CHUNK_SIZE;
+        break;
+      }
+
+      case HTTP_CHUNK_TRAILER_START:
+      {
+        const bool valid_start = (*p == '\r') | is_tchar(*p);
+        if (UNLIKELY(!valid_start))
+          return 0;
+
+        stage = (*p == '\r') ? HTTP_CHUNK_TRAILER_LF : HTTP_CHUNK_TRAILER_NAME;
+        p += (*p == '\r');
+        break;
+      }
+
+      case HTTP_CHUNK_TRAILER_NAME:
+      {
+        while (LIKELY(p < buffer_end) && is_tchar(*p))
+          p++;
+        if (UNLIKELY(p == buffer_end))
+          break;
+        if (UNLIKELY(*p++ != ':'))
+          return 0;
+
+        stage = HTTP_CHUNK_TRAILER_VALUE;
+        break;
+      }
+
+      case HTTP_CHUNK_TRAILER_VALUE:
+      {
+        p = skip_field_text(p, buffer_end);
+        if (UNLIKELY(p == buffer_end))
+          break;
+        if (UNLIKELY(*p++ != '\r'))
+          return 0;
+
+        stage = HTTP_CHUNK_TRAILER_VALUE_LF;
+        break;
+      }
+
+      case HTTP_CHUNK_TRAILER_VALUE_LF:
+      {
+        if (UNLIKELY(*p++ != '\n'))
+          return 0;
+
+        stage = HTTP_CHUNK_TRAILER_START;
+        break;
+      }
+
+      case HTTP_CHUNK_TRAILER_LF:
+      {
+        if (UNLIKELY(*p++ != '\n'))
+          return 0;
+
+        *decoder = (http_chunked_decoder_t){0};
+        return p - buffer;
+      }
+
+      default:
+        UNREACHABLE;
+    }
+  }
+
+  decoder->size = size;
+  decoder->digits = digits;
+  decoder->stage = stage;
+
+  return HTTP_NEED_MORE;
+}
+
+static inline bool emit_data(chunk_sink_t *const restrict sink, char *restrict data, const uint32_t len, const bool compact)
+{
+  if (compact)
+  {
+    memmove(sink->out, data, len);
+    sink->out += len;
+    return true;
+  }
+
+  if (UNLIKELY(sink->iovcnt == sink->max_iov))
+    return false;
+
+  sink->iov[sink->iovcnt++] = (struct iovec){data, len};
+  return true;
+}
+
+//parses up to 8 leading hex digits of an 8-byte word at once, returns the number of digits
+//digits are matched on the raw bytes: the case fold would turn 0x10-0x19 into '0'-'9'
+static inline uint8_t parse_hex_swar(const char *buffer, uint32_t *const restrict size)
+{
+  constexpr uint64_t highs = 0x8080808080808080;
+  constexpr uint64_t lows = 0x7f7f7f7f7f7f7f7f;
+
+  uint64_t word;
+  memcpy8(&word, buffer);
+
+  const uint64_t ascii = ~word & highs;
+  const uint64_t raw = word & lows;
+  const uint64_t x = (word | 0x2020202020202020) & lows;
+
+  const uint64_t ge_0 = (raw + 0x5050505050505050) & highs;
+  const uint64_t gt_9 = (raw + 0x4646464646464646) & highs;
+  const uint64_t ge_a = (x + 0x1f1f1f1f1f1f1f1f) & highs;
+  const uint64_t gt_f = (x + 0x1919191919191919) & highs;
+
+  const uint64_t is_alpha = ge_a & ~gt_f;
+  const uint64_t is_hex = ((ge_0 & ~gt_9) | is_alpha) & ascii;
+
+  const uint64_t non_hex = ~is_hex & highs;
+  const uint8_t digits = non_hex ? (__builtin_ctzll(non_hex) >> 3) : (uint8_t)sizeof(uint64_t);
+  if (UNLIKELY(digits == 0))
+    return 0;
+
+  uint64_t nibbles = (x & 0x0f0f0f0f0f0f0f0f) + (is_alpha >> 7) * 9;
+  nibbles = __builtin_bswap64(nibbles) >> ((sizeof(uint64_t) - digits) << 3);
+
+  nibbles = (nibbles | (nibbles >> 4)) & 0x00ff00ff00ff00ff;
+  nibbles = (nibbles | (nibbles >> 8)) & 0x0000ffff0000ffff;
+  nibbles = (nibbles | (nibbles >> 16)) & 0x00000000ffffffff;
+
+  *size = nibbles;
+  return digits;
+}
+
+static inline bool is_hex(const char c)
+{
+  return ((uint8_t)(c - '0') < 10) | ((uint8_t)((c | 0x20) - 'a') < 6);
+}
+
+//RFC 9110 section 5.6.2, any visible character except the delimiters
+static inline bool is_tchar(const char c)
+{
+  constexpr uint64_t tchars_low = 0x03ff6cfa00000000;
+  constexpr uint64_t tchars_high = 0x57ffffffc7fffffe;
+
+  const uint8_t byte = c;
+  if (byte < 64)
+    return (tchars_low >> byte) & 1;
+  return (byte < 128) & ((tchars_high >> (byte & 63)) & 1);
+}
+
+//chunk extensions and trailer values may hold any byte but the control characters other than HTAB
+static inline char *skip_field_text(char *p, const char *const end)
+{
+  while (LIKELY(p < end) && ((((uint8_t)*p >= ' ') & (*p != 0x7f)) | (*p == '\t')))
+    p++;
+
+  return p;
+}
+
+static inline uint8_t hex_value(const char c)
+{
+  return (c & 0x0f) + ((c >> 6) & 1) * 9;
+}
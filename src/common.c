@@ -11,8 +11,153 @@ last edited: 2025-02-26 21:40:21
 
 #include "common.h"
 
+const char methods_str[][sizeof(uint64_t)] ALIGNED(64) = {
+  [HTTP_GET] = "GET",
+  [HTTP_HEAD] = "HEAD",
+  [HTTP_POST] = "POST",
+  [HTTP_PUT] = "PUT",
+  [HTTP_DELETE] = "DELETE",
+  [HTTP_OPTIONS] = "OPTIONS",
+  [HTTP_TRACE] = "TRACE",
+  [HTTP_PATCH] = "PATCH",
+  [HTTP_CONNECT] = "CONNECT"
+};
+const uint8_t methods_len[] = {
+  [HTTP_GET] = STR_LEN("GET"),
+  [HTTP_HEAD] = STR_LEN("HEAD"),
+  [HTTP_POST] = STR_LEN("POST"),
+  [HTTP_PUT] = STR_LEN("PUT"),
+  [HTTP_DELETE] = STR_LEN("DELETE"),
+  [HTTP_OPTIONS] = STR_LEN("OPTIONS"),
+  [HTTP_TRACE] = STR_LEN("TRACE"),
+  [HTTP_PATCH] = STR_LEN("PATCH"),
+  [HTTP_CONNECT] = STR_LEN("CONNECT")
+};
+
+const char versions_str[][sizeof(uint64_t)] ALIGNED(64) = {
+  [HTTP_1_0] = "HTTP/1.0",
+  [HTTP_1_1] = "HTTP/1.1",
+  [HTTP_2_0] = "HTTP/2.0",
+  [HTTP_3_0] = "HTTP/3.0"
+};
+const uint8_t versions_len[] = {
+  [HTTP_1_0] = STR_LEN("HTTP/1.0"),
+  [HTTP_1_1] = STR_LEN("HTTP/1.1"),
+  [HTTP_2_0] = STR_LEN("HTTP/2.0"),
+  [HTTP_3_0] = STR_LEN("HTTP/3.0")
+};
+
+//pre-formatted "Name: " of the well-known headers
+const char header_names_str[][32] ALIGNED(64) = {
+  [HTTP_HEADER_UNKNOWN] = "",
+  [HTTP_HEADER_ACCEPT] = "Accept: ",
+  [HTTP_HEADER_ACCEPT_CHARSET] = "Accept-Charset: ",
+  [HTTP_HEADER_ACCEPT_ENCODING] = "Accept-Encoding: ",
+  [HTTP_HEADER_ACCEPT_LANGUAGE] = "Accept-Language: ",
+  [HTTP_HEADER_ACCEPT_RANGES] = "Accept-Ranges: ",
+  [HTTP_HEADER_ACCESS_CONTROL_ALLOW_ORIGIN] = "Access-Control-Allow-Origin: ",
+  [HTTP_HEADER_AGE] = "Age: ",
+  [HTTP_HEADER_ALLOW] = "Allow: ",
+  [HTTP_HEADER_AUTHORIZATION] = "Authorization: ",
+  [HTTP_HEADER_CACHE_CONTROL] = "Cache-Control: ",
+  [HTTP_HEADER_CONNECTION] = "Connection: ",
+  [HTTP_HEADER_CONTENT_DISPOSITION] = "Content-Disposition: ",
+  [HTTP_HEADER_CONTENT_ENCODING] = "Content-Encoding: ",
+  [HTTP_HEADER_CONTENT_LANGUAGE] = "Content-Language: ",
+  [HTTP_HEADER_CONTENT_LENGTH] = "Content-Length: ",
+  [HTTP_HEADER_CONTENT_LOCATION] = "Content-Location: ",
+  [HTTP_HEADER_CONTENT_RANGE] = "Content-Range: ",
+  [HTTP_HEADER_CONTENT_TYPE] = "Content-Type: ",
+  [HTTP_HEADER_COOKIE] = "Cookie: ",
+  [HTTP_HEADER_DATE] = "Date: ",
+  [HTTP_HEADER_ETAG] = "ETag: ",
+  [HTTP_HEADER_EXPECT] = "Expect: ",
+  [HTTP_HEADER_EXPIRES] = "Expires: ",
+  [HTTP_HEADER_HOST] = "Host: ",
+  [HTTP_HEADER_IF_MATCH] = "If-Match: ",
+  [HTTP_HEADER_IF_MODIFIED_SINCE] = "If-Modified-Since: ",
+  [HTTP_HEADER_IF_NONE_MATCH] = "If-None-Match: ",
+  [HTTP_HEADER_IF_RANGE] = "If-Range: ",
+  [HTTP_HEADER_IF_UNMODIFIED_SINCE] = "If-Unmodified-Since: ",
+  [HTTP_HEADER_KEEP_ALIVE] = "Keep-Alive: ",
+  [HTTP_HEADER_LAST_MODIFIED] = "Last-Modified: ",
+  [HTTP_HEADER_LINK] = "Link: ",
+  [HTTP_HEADER_LOCATION] = "Location: ",
+  [HTTP_HEADER_ORIGIN] = "Origin: ",
+  [HTTP_HEADER_PRAGMA] = "Pragma: ",
+  [HTTP_HEADER_PROXY_AUTHENTICATE] = "Proxy-Authenticate: ",
+  [HTTP_HEADER_PROXY_AUTHORIZATION] = "Proxy-Authorization: ",
+  [HTTP_HEADER_RANGE] = "Range: ",
+  [HTTP_HEADER_REFERER] = "Referer: ",
+  [HTTP_HEADER_RETRY_AFTER] = "Retry-After: ",
+  [HTTP_HEADER_SERVER] = "Server: ",
+  [HTTP_HEADER_SET_COOKIE] = "Set-Cookie: ",
+  [HTTP_HEADER_STRICT_TRANSPORT_SECURITY] = "Strict-Transport-Security: ",
+  [HTTP_HEADER_TE] = "TE: ",
+  [HTTP_HEADER_TRAILER] = "Trailer: ",
+  [HTTP_HEADER_TRANSFER_ENCODING] = "Transfer-Encoding: ",
+  [HTTP_HEADER_UPGRADE] = "Upgrade: ",
+  [HTTP_HEADER_USER_AGENT] = "User-Agent: ",
+  [HTTP_HEADER_VARY] = "Vary: ",
+  [HTTP_HEADER_VIA] = "Via: ",
+  [HTTP_HEADER_WWW_AUTHENTICATE] = "WWW-Authenticate: ",
+  [HTTP_HEADER_X_FORWARDED_FOR] = "X-Forwarded-For: "
+};
+
+const uint8_t header_names_len[] = {
+  [HTTP_HEADER_UNKNOWN] = 0,
+  [HTTP_HEADER_ACCEPT] = STR_LEN("Accept: "),
+  [HTTP_HEADER_ACCEPT_CHARSET] = STR_LEN("Accept-Charset: "),
+  [HTTP_HEADER_ACCEPT_ENCODING] = STR_LEN("Accept-Encoding: "),
+  [HTTP_HEADER_ACCEPT_LANGUAGE] = STR_LEN("Accept-Language: "),
+  [HTTP_HEADER_ACCEPT_RANGES] = STR_LEN("Accept-Ranges: "),
+  [HTTP_HEADER_ACCESS_CONTROL_ALLOW_ORIGIN] = STR_LEN("Access-Control-Allow-Origin: "),
+  [HTTP_HEADER_AGE] = STR_LEN("Age: "),
+  [HTTP_HEADER_ALLOW] = STR_LEN("Allow: "),
+  [HTTP_HEADER_AUTHORIZATION] = STR_LEN("Authorization: "),
+  [HTTP_HEADER_CACHE_CONTROL] = STR_LEN("Cache-Control: "),
+  [HTTP_HEADER_CONNECTION] = STR_LEN("Connection: "),
+  [HTTP_HEADER_CONTENT_DISPOSITION] = STR_LEN("Content-Disposition: "),
+  [HTTP_HEADER_CONTENT_ENCODING] = STR_LEN("Content-Encoding: "),
+  [HTTP_HEADER_CONTENT_LANGUAGE] = STR_LEN("Content-Language: "),
+  [HTTP_HEADER_CONTENT_LENGTH] = STR_LEN("Content-Length: "),
+  [HTTP_HEADER_CONTENT_LOCATION] = STR_LEN("Content-Location: "),
+  [HTTP_HEADER_CONTENT_RANGE] = STR_LEN("Content-Range: "),
+  [HTTP_HEADER_CONTENT_TYPE] = STR_LEN("Content-Type: "),
+  [HTTP_HEADER_COOKIE] = STR_LEN("Cookie: "),
+  [HTTP_HEADER_DATE] = STR_LEN("Date: "),
+  [HTTP_HEADER_ETAG] = STR_LEN("ETag: "),
+  [HTTP_HEADER_EXPECT] = STR_LEN("Expect: "),
+  [HTTP_HEADER_EXPIRES] = STR_LEN("Expires: "),
+  [HTTP_HEADER_HOST] = STR_LEN("Host: "),
+  [HTTP_HEADER_IF_MATCH] = STR_LEN("If-Match: "),
+  [HTTP_HEADER_IF_MODIFIED_SINCE] = STR_LEN("If-Modified-Since: "),
+  [HTTP_HEADER_IF_NONE_MATCH] = STR_LEN("If-None-Match: "),
+  [HTTP_HEADER_IF_RANGE] = STR_LEN("If-Range: "),
+  [HTTP_HEADER_IF_UNMODIFIED_SINCE] = STR_LEN("If-Unmodified-Since: "),
+  [HTTP_HEADER_KEEP_ALIVE] = STR_LEN("Keep-Alive: "),
+  [HTTP_HEADER_LAST_MODIFIED] = STR_LEN("Last-Modified: "),
+  [HTTP_HEADER_LINK] = STR_LEN("Link: "),
+  [HTTP_HEADER_LOCATION] = STR_LEN("Location: "),
+  [HTTP_HEADER_ORIGIN] = STR_LEN("Origin: "),
+  [HTTP_HEADER_PRAGMA] = STR_LEN("Pragma: "),
+  [HTTP_HEADER_PROXY_AUTHENTICATE] = STR_LEN("Proxy-Authenticate: "),
+  [HTTP_HEADER_PROXY_AUTHORIZATION] = STR_LEN("Proxy-Authorization: "),
+  [HTTP_HEADER_RANGE] = STR_LEN("Range: "),
+  [HTTP_HEADER_REFERER] = STR_LEN("Referer: "),
+  [HTTP_HEADER_RETRY_AFTER] = STR_LEN("Retry-After: "),
+  [HTTP_HEADER_SERVER] = STR_LEN("Server: "),
+  [HTTP_HEADER_SET_COOKIE] = STR_LEN("Set-Cookie: "),
+  [HTTP_HEADER_STRICT_TRANSPORT_SECURITY] = STR_LEN("Strict-Transport-Security: "),
+  [HTTP_HEADER_TE] = STR_LEN("TE: "),
+  [HTTP_HEADER_TRAILER] = STR_LEN("Trailer: "),
+  [HTTP_HEADER_TRANSFER_ENCODING] = STR_LEN("Transfer-Encoding: "),
+  [HTTP_HEADER_UPGRADE] = STR_LEN("Upgrade: "),
+  [HTTP_HEADER_USER_AGENT] = STR_LEN("User-Agent: "),
+  [HTTP_HEADER_VARY] = STR_LEN("Vary: "),
+  [HTTP_HEADER_VIA] = STR_LEN("Via: "),
+  [HTTP_HEADER_WWW_AUTHENTICATE] = STR_LEN("WWW-Authenticate: "),
+  [HTTP_HEADER_X_FORWARDED_FOR] = STR_LEN("X-Forwarded-For: ")
+};
+
 //TODO add common functions here
-//TODO add serialize_response e deserialize_request
-//TODO SIMD vectorize headers
-//TODO hashmap with xxhash for headers
-//TODO only deserialize headers the user is intrested to. (he provides a list of expected headers beforehands)
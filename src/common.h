@@ -5,7 +5,7 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-02-11 14:56:11                                                 
-last edited: 2025-03-05 21:04:20                                                
+last edited: 2025-03-15 13:41:09                                                
 
 ================================================================================*/
 
@@ -13,13 +13,18 @@ last edited: 2025-03-05 21:04:20
 # define COMMON_H
 
 # include <stdint.h>
+# include <string.h>
 # include <immintrin.h>
+# include <sys/uio.h>
 //#TODO #include <stdbit.h>
 
 # include "extensions.h"
+# include "structs.h"
 
 # define STR_LEN(x)   (sizeof(x) - 1)
 # define ARR_SIZE(x)  (sizeof(x) / sizeof(x[0]))
+# define MIN(a, b)    (((a) < (b)) ? (a) : (b))
+# define MAX(a, b)    (((a) > (b)) ? (a) : (b))
 
 # if defined(__AVX512F__)
   # define ALIGNMENT 64
@@ -31,6 +36,30 @@ last edited: 2025-03-05 21:04:20
   # define ALIGNMENT sizeof(void *)
 # endif
 
+//method, path and version with their separators, 4 per header, the final CRLF and the body
+# define REQUEST_IOVCNT(headers_count) (6 + ((headers_count) << 2) + 1 + 1)
+//fields shorter than this are copied into the staging buffer, longer ones get their own iovec
+# define COPY_THRESHOLD 64
+# define STAGING_SIZE 8192
+//:method, :scheme, :path and :authority
+# define HTTP_REQUEST_PSEUDO_FIELDS 4
+
+INTERNAL extern const char methods_str[][sizeof(uint64_t)];
+INTERNAL extern const uint8_t methods_len[];
+INTERNAL extern const char versions_str[][sizeof(uint64_t)];
+INTERNAL extern const uint8_t versions_len[];
+INTERNAL extern const char header_names_str[][32];
+INTERNAL extern const uint8_t header_names_len[];
+
+INTERNAL bool flush_iov(const int fd, struct iovec *restrict iov, uint16_t iovcnt, const int flags, int64_t *const restrict total_written);
+INTERNAL uint64_t serialized_size(const http_request_t *restrict request);
+INTERNAL uint16_t vectorize_request(struct iovec *restrict iov, char *restrict buffer, const uint16_t buffer_size, const http_request_t *restrict request);
+INTERNAL uint8_t request_pseudo_fields(http_header_t *restrict pseudo, const http_request_t *restrict request, const http_header_t **const restrict host);
+INTERNAL bool request_from_fields(http_request_t *const restrict request, const uint16_t fields_count, const http_version_t version);
+INTERNAL bool response_from_fields(http_response_t *const restrict response, const uint16_t fields_count, const http_version_t version);
+INTERNAL bool connection_specific(const http_header_t *restrict header);
+INTERNAL http_header_id_t lookup_header_id(const char *const key, const uint16_t key_len);
+
 INTERNAL ALWAYS_INLINE inline uint8_t align_forward(const void *ptr) { return -(uintptr_t)ptr & (ALIGNMENT - 1);}
 INTERNAL ALWAYS_INLINE inline uint8_t memcmp8(const void *const ptr1, const void *const ptr2) { return *(uint64_t *)ptr1 == *(uint64_t *)ptr2; }
 INTERNAL ALWAYS_INLINE inline uint8_t memcmp4(const void *const ptr1, const void *const ptr2) { return *(uint32_t *)ptr1 == *(uint32_t *)ptr2; }
@@ -39,5 +68,88 @@ INTERNAL ALWAYS_INLINE inline void memcpy8(void *const dest, const void *const s
 INTERNAL ALWAYS_INLINE inline void memcpy4(void *const dest, const void *const src) { *(uint32_t *)dest = *(uint32_t *)src; }
 INTERNAL ALWAYS_INLINE inline void memcpy2(void *const dest, const void *const src) { *(uint16_t *)dest = *(uint16_t *)src; }
 
+//copies up to 64 bytes with at most two overlapping wide stores
+INTERNAL ALWAYS_INLINE inline void memcpy_short(void *const dest, const void *const src, const uint8_t len)
+{
+  char *const d = dest;
+  const char *const s = src;
+
+  if (len >= 32)
+  {
+    memcpy(d, s, 32);
+    memcpy(d + len - 32, s + len - 32, 32);
+  }
+  else if (len >= 16)
+  {
+    memcpy(d, s, 16);
+    memcpy(d + len - 16, s + len - 16, 16);
+  }
+  else if (len >= 8)
+  {
+    memcpy8(d, s);
+    memcpy8(d + len - 8, s + len - 8);
+  }
+  else if (len >= 4)
+  {
+    memcpy4(d, s);
+    memcpy4(d + len - 4, s + len - 4);
+  }
+  else if (len >= 2)
+  {
+    memcpy2(d, s);
+    memcpy2(d + len - 2, s + len - 2);
+  }
+  else if (len)
+    *d = *s;
+}
+
+INTERNAL ALWAYS_INLINE inline uint64_t tolower_swar(const uint64_t word)
+{
+  constexpr uint64_t ones = 0x0101010101010101;
+  constexpr uint64_t highs = 0x8080808080808080;
+
+  const uint64_t ascii = word & ~highs;
+  const uint64_t above_z = ascii + ones * (0x7F - 'Z');
+  const uint64_t from_a = ascii + ones * (0x80 - 'A');
+  const uint64_t uppers = (from_a ^ above_z) & ~word & highs;
+
+  return word | (uppers >> 2);
+}
+
+//an id outside the enum, from a header filled field by field, falls back to the key like HTTP_HEADER_UNKNOWN
+INTERNAL ALWAYS_INLINE inline http_header_id_t known_id(const http_header_id_t id)
+{
+  return (id <= HTTP_HEADER_X_FORWARDED_FOR) ? id : HTTP_HEADER_UNKNOWN;
+}
+
+//bytes that already left cannot be taken back, so a failed write only reports -1 when nothing was sent
+INTERNAL ALWAYS_INLINE inline int64_t write_result(const int64_t total_written)
+{
+  return (total_written != 0) ? total_written : -1;
+}
+
+//case-insensitive compare of two header names, 8 bytes at a time
+INTERNAL ALWAYS_INLINE inline bool equals_caseless(const char *const str1, const uint16_t len1, const char *const str2, const uint16_t len2)
+{
+  if (len1 != len2)
+    return false;
+
+  bool equal = true;
+
+  for (uint16_t i = 0; i < len1; i += sizeof(uint64_t))
+  {
+    const uint16_t remaining = len1 - i;
+    const uint8_t chunk_len = (remaining < sizeof(uint64_t)) ? remaining : sizeof(uint64_t);
+    uint64_t word1 = 0;
+    uint64_t word2 = 0;
+
+    memcpy(&word1, str1 + i, chunk_len);
+    memcpy(&word2, str2 + i, chunk_len);
+
+    equal &= (tolower_swar(word1) == tolower_swar(word2));
+  }
+
+  return equal;
+}
 
 #endif
\ No newline at end of file
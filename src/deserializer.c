@@ -5,51 +5,749 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-02-11 12:37:26                                                 
-last edited: 2025-03-05 21:04:20                                                
+last edited: 2025-03-15 13:41:09                                                
 
 ================================================================================*/
 
 #include <string.h>
+#include <stddef.h>
 
 #include "common.h"
 #include "deserializer.h"
 
-static uint32_t deserialize_status_line(char *buffer, char *const buffer_end, http_response_t *const restrict response);
+# define BLOCK_SIZE 64
+
+typedef struct
+{
+  uint64_t colons;
+  uint64_t crs;
+  uint64_t lfs;
+} block_masks_t;
+
+typedef struct
+{
+  char *block;
+  char *end;
+  uint64_t colons;
+  uint64_t eols;
+  uint64_t carry;
+} tokenizer_t;
+
+typedef enum: uint8_t {
+  FRAMING_CONTENT_LENGTH = 1 << 0,
+  FRAMING_INVALID_LENGTH = 1 << 1,
+  FRAMING_TRANSFER_ENCODING = 1 << 2,
+  FRAMING_CHUNKED = 1 << 3,
+  FRAMING_CONNECTION_CLOSE = 1 << 4,
+  FRAMING_CONNECTION_KEEP_ALIVE = 1 << 5
+} framing_flags_t;
+
+# define MAX_CONTENT_LENGTH_DIGITS 10
+
+# define FILTER_NO_SLOT UINT16_MAX
+# define FILTER_EMPTY_SLOT UINT8_MAX
+# define FILTER_MAX_SEEDS 4096
+# define FILTER_SLOT_SHIFT (64 - __builtin_ctz(HTTP_FILTER_SLOTS))
+
+# define XXH_PRIME64_1 UINT64_C(0x9e3779b185ebca87)
+# define XXH_PRIME64_2 UINT64_C(0xc2b2ae3d27d4eb4f)
+# define XXH_PRIME64_3 UINT64_C(0x165667b19e3779f9)
+# define XXH_PRIME64_4 UINT64_C(0x85ebca77c2b2ae63)
+# define XXH_PRIME64_5 UINT64_C(0x27d4eb2f165667c5)
+
+# define METHODS_HASH_SEED UINT64_C(0xc8ad434b542f3413)
+
+//perfect hash of the space-terminated method word, see deserialize_method()
+constexpr http_method_t methods_hash[16] = {
+  [6] = HTTP_GET,
+  [3] = HTTP_HEAD,
+  [11] = HTTP_POST,
+  [5] = HTTP_PUT,
+  [10] = HTTP_DELETE,
+  [14] = HTTP_OPTIONS,
+  [13] = HTTP_TRACE,
+  [2] = HTTP_PATCH,
+  [9] = HTTP_CONNECT
+};
+
+//with 128 slots a perfect hash of the ids takes ~10^6 seeds, with 256 it takes under a hundred
+# define HEADER_IDS_SLOTS 256
+# define HEADER_IDS_SLOT_SHIFT (64 - __builtin_ctz(HEADER_IDS_SLOTS))
+# define HEADER_IDS_COUNT (HTTP_HEADER_X_FORWARDED_FOR + 1)
+
+//perfect hash of the well-known header names, built by http_deserializer_init(), see match_header_id()
+static http_header_id_t header_ids_hash[HEADER_IDS_SLOTS];
+static uint64_t header_ids_seed;
+
+static block_masks_t classify_scalar(const char *block);
+static void header_ids_compile(void);
+static inline uint64_t next_seed(uint64_t *const restrict state);
+
+static block_masks_t (*classify_block)(const char *block) = classify_scalar;
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+
+static block_masks_t classify_avx512(const char *block)
+{
+  const __m512i chunk = _mm512_loadu_si512(block);
+
+  return (block_masks_t){
+    .colons = _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8(':')),
+    .crs = _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('\r')),
+    .lfs = _mm512_cmpeq_epi8_mask(chunk, _mm512_set1_epi8('\n'))
+  };
+}
+
+#endif
+
+#ifdef __AVX2__
+
+static inline uint64_t cmpeq_mask_avx2(const __m256i lo, const __m256i hi, const char c)
+{
+  const __m256i needle = _mm256_set1_epi8(c);
+  const uint32_t lo_mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(lo, needle));
+  const uint32_t hi_mask = _mm256_movemask_epi8(_mm256_cmpeq_epi8(hi, needle));
+
+  return ((uint64_t)hi_mask << 32) | lo_mask;
+}
+
+static block_masks_t classify_avx2(const char *block)
+{
+  const __m256i lo = _mm256_loadu_si256((const __m256i *)block);
+  const __m256i hi = _mm256_loadu_si256((const __m256i *)(block + 32));
+
+  return (block_masks_t){
+    .colons = cmpeq_mask_avx2(lo, hi, ':'),
+    .crs = cmpeq_mask_avx2(lo, hi, '\r'),
+    .lfs = cmpeq_mask_avx2(lo, hi, '\n')
+  };
+}
+
+#endif
+
+#ifdef __SSE2__
+
+static inline uint64_t cmpeq_mask_sse2(const __m128i chunks[4], const char c)
+{
+  const __m128i needle = _mm_set1_epi8(c);
+  uint64_t mask = 0;
+
+  for (uint8_t i = 0; i < 4; i++)
+    mask |= (uint64_t)(uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(chunks[i], needle)) << (i << 4);
+
+  return mask;
+}
+
+static block_masks_t classify_sse2(const char *block)
+{
+  const __m128i chunks[4] = {
+    _mm_loadu_si128((const __m128i *)block),
+    _mm_loadu_si128((const __m128i *)(block + 16)),
+    _mm_loadu_si128((const __m128i *)(block + 32)),
+    _mm_loadu_si128((const __m128i *)(block + 48))
+  };
+
+  return (block_masks_t){
+    .colons = cmpeq_mask_sse2(chunks, ':'),
+    .crs = cmpeq_mask_sse2(chunks, '\r'),
+    .lfs = cmpeq_mask_sse2(chunks, '\n')
+  };
+}
+
+#endif
+
+CONSTRUCTOR void http_deserializer_init(void)
+{
+  header_ids_compile();
+
+#if defined(__AVX512F__) && defined(__AVX512BW__)
+  if (__builtin_cpu_supports("avx512bw"))
+  {
+    classify_block = classify_avx512;
+    return;
+  }
+#endif
+
+#ifdef __AVX2__
+  if (__builtin_cpu_supports("avx2"))
+  {
+    classify_block = classify_avx2;
+    return;
+  }
+#endif
+
+#ifdef __SSE2__
+  if (__builtin_cpu_supports("sse2"))
+  {
+    classify_block = classify_sse2;
+    return;
+  }
+#endif
+}
+
+static uint32_t deserialize_response(tokenizer_t *const restrict tokenizer, http_parser_t *const restrict parser, char *restrict buffer, http_response_t *const restrict response, const http_header_filter_t *const restrict filter, http_header_index_t *const restrict index, http_compact_headers_t *const restrict compact);
+static uint32_t deserialize_request(http_parser_t *const restrict parser, char *restrict buffer, const uint32_t buffer_size, http_request_t *const restrict request, http_header_index_t *const restrict index, http_compact_headers_t *const restrict compact);
+static void restore_response(const http_parser_t *const restrict parser, http_response_t *const restrict response);
+static uint32_t deserialize_response_chunk(http_parser_t *const restrict parser, char *const chunk, const uint32_t chunk_len, http_response_t *const restrict response);
+static uint32_t finish_response_iov(const struct iovec *restrict iov, const uint16_t iovcnt, uint16_t segment, uint32_t segment_offset, uint32_t head_len, http_response_t *const restrict response);
+static uint32_t deserialize_status_line(char *buffer, char *const line_end, http_response_t *const restrict response);
 static uint16_t deserialize_status_code(char *buffer, char *const line_end, http_response_t *const restrict response);
 static uint16_t deserialize_reason_phrase(char *buffer, char *const line_end, http_response_t *const restrict response);
-static uint32_t deserialize_headers(char *restrict buffer, char *const buffer_end, http_response_t *const restrict response);
+static uint32_t deserialize_request_line(char *buffer, char *const line_end, http_request_t *const restrict request);
+static inline uint8_t deserialize_method(const char *buffer, http_request_t *const restrict request);
+static inline uint16_t deserialize_path(char *buffer, char *const path_end, http_request_t *const restrict request);
+static inline uint8_t deserialize_version(const char *buffer, http_version_t *const restrict version);
+static uint32_t deserialize_headers(tokenizer_t *const restrict tokenizer, http_parser_t *const restrict parser, char *const buffer_start, http_header_t *const restrict headers, const uint16_t max_headers, const http_header_filter_t *const restrict filter, http_header_index_t *const restrict index, http_compact_headers_t *const restrict compact);
+static inline uint16_t match_header(const http_header_filter_t *const restrict filter, const char *const key, const uint16_t key_len, const uint64_t hash);
+static inline http_header_id_t match_header_id(const char *const key, const uint16_t key_len, const uint64_t hash);
+static inline uint64_t hash_header_name(const char *const key, const uint16_t key_len);
+static inline bool index_reset(http_header_index_t *const restrict index, const http_header_t *const headers, const uint16_t max_headers);
+static inline void index_insert(http_header_index_t *const restrict index, const uint64_t hash, const uint16_t header);
+static inline uint64_t hash_header_key(const char *const key, const uint16_t key_len);
+static inline uint64_t xxh_round(uint64_t word);
+static inline void inspect_header(http_parser_t *const restrict parser, const http_header_id_t id, const char *const value, const uint16_t value_len);
+static inline void inspect_content_length(http_parser_t *const restrict parser, const char *const value, const char *value_end);
+static inline void inspect_transfer_encoding(http_parser_t *const restrict parser, const char *const value, const char *value_end);
+static inline void inspect_connection(http_parser_t *const restrict parser, const char *value, const char *const value_end);
+static http_framing_t resolve_framing(const http_parser_t *const restrict parser, const http_version_t version, bool *const restrict keep_alive);
+static inline bool parse_digits_swar(const char *str, const uint8_t len, uint32_t *const restrict value);
+static inline uint32_t suspend(tokenizer_t *const restrict tokenizer, http_parser_t *const restrict parser, const char *const buffer_start, const char *const buffer, const http_parser_stage_t stage);
+static inline void tokenizer_init(tokenizer_t *const restrict tokenizer, char *const block, char *const end, const bool carry);
+static inline void tokenizer_load(tokenizer_t *const restrict tokenizer);
+static inline void tokenizer_advance(tokenizer_t *const restrict tokenizer);
+static inline char *tokenizer_next(tokenizer_t *const restrict tokenizer, const char *const from, const bool colons);
+static inline void tokenizer_seek(tokenizer_t *const restrict tokenizer, char *const from);
+static inline char *skip_ows(char *buffer, const char *const buffer_end);
+static inline const char *trim_ows(const char *const buffer_start, const char *buffer);
 static uint32_t atoui(const char *str, char **endptr);
 static inline uint32_t mul10(uint32_t n);
 
 uint32_t http1_deserialize(char *restrict buffer, const uint32_t buffer_size, http_response_t *const restrict response)
+{
+  http_parser_t parser = {0};
+
+  const uint32_t parsed_bytes = http1_deserialize_partial(&parser, buffer, buffer_size, response);
+
+  return parsed_bytes * (parsed_bytes != HTTP_NEED_MORE);
+}
+
+uint32_t http1_deserialize_request(char *restrict buffer, const uint32_t buffer_size, http_request_t *const restrict request)
+{
+  http_parser_t parser = {0};
+
+  const uint32_t parsed_bytes = http1_deserialize_request_partial(&parser, buffer, buffer_size, request);
+
+  return parsed_bytes * (parsed_bytes != HTTP_NEED_MORE);
+}
+
+uint32_t http1_deserialize_partial(http_parser_t *const restrict parser, char *restrict buffer, const uint32_t buffer_size, http_response_t *const restrict response)
+{
+  tokenizer_t tokenizer;
+  tokenizer_init(&tokenizer, buffer + parser->block_offset, buffer + buffer_size, parser->carry);
+
+  return deserialize_response(&tokenizer, parser, buffer, response, NULL, NULL, NULL);
+}
+
+uint32_t http1_deserialize_request_partial(http_parser_t *const restrict parser, char *restrict buffer, const uint32_t buffer_size, http_request_t *const restrict request)
+{
+  return deserialize_request(parser, buffer, buffer_size, request, NULL, NULL);
+}
+
+uint32_t http1_deserialize_batch(char *restrict buffer, const uint32_t buffer_size, http_response_t *const restrict responses, uint16_t *const restrict responses_count)
 {
   char *const buffer_start = buffer;
   char *const buffer_end = buffer + buffer_size;
+  const uint16_t max_responses = *responses_count;
 
-  uint32_t parsed_bytes;
+  uint16_t count = 0;
+  uint32_t batch_len = 0;
 
-  parsed_bytes = deserialize_status_line(buffer, buffer_end, response);
-  if (UNLIKELY(parsed_bytes == 0))
+  tokenizer_t tokenizer;
+  tokenizer_init(&tokenizer, buffer, buffer_end, false);
+
+  while (LIKELY((count < max_responses) & (buffer < buffer_end)))
+  {
+    http_response_t *const response = &responses[count];
+    http_parser_t parser = {0};
+
+    tokenizer_seek(&tokenizer, buffer);
+    const uint32_t parsed_bytes = deserialize_response(&tokenizer, &parser, buffer, response, NULL, NULL, NULL);
+    if (UNLIKELY(parsed_bytes == 0))
+      return 0;
+    if (UNLIKELY(parsed_bytes == HTTP_NEED_MORE))
+    {
+      restore_response(&parser, response);
+      break;
+    }
+
+    char *const body = buffer + parsed_bytes;
+    const http_framing_t framing = response->framing;
+
+    //the caller has to decode these bodies itself, the batch ends where they start
+    if (UNLIKELY((framing == HTTP_FRAMING_CHUNKED) | (framing == HTTP_FRAMING_CLOSE)))
+    {
+      batch_len = body - buffer_start;
+      count++;
+      break;
+    }
+
+    if (UNLIKELY(response->body_len > (uint32_t)(buffer_end - body)))
+    {
+      restore_response(&parser, response);
+      break;
+    }
+
+    buffer = body + response->body_len;
+    batch_len = buffer - buffer_start;
+    count++;
+  }
+
+  *responses_count = count;
+
+  if (UNLIKELY(count == 0))
+    return HTTP_NEED_MORE;
+  return batch_len;
+}
+
+//lines are parsed in place inside each segment, only the ones that straddle a seam are copied into scratch
+uint32_t http1_deserialize_iov(const struct iovec *restrict iov, const uint16_t iovcnt, http_response_t *const restrict response, char *restrict scratch, const uint32_t scratch_size)
+{
+  const char *const scratch_limit = scratch + scratch_size;
+  char *pending = scratch;
+  char *scratch_end = scratch;
+
+  http_parser_t parser = {0};
+  uint32_t segment_start = 0;
+
+  for (uint16_t i = 0; LIKELY(i < iovcnt); i++)
+  {
+    char *const segment = iov[i].iov_base;
+    const uint32_t segment_len = iov[i].iov_len;
+    uint32_t offset = 0;
+
+    while (LIKELY(offset < segment_len))
+    {
+      if (LIKELY(pending == scratch_end))
+      {
+        char *const chunk = segment + offset;
+        const uint32_t chunk_len = segment_len - offset;
+
+        const uint32_t parsed_bytes = deserialize_response_chunk(&parser, chunk, chunk_len, response);
+        if (UNLIKELY(parsed_bytes == 0))
+          return 0;
+        if (LIKELY(parsed_bytes != HTTP_NEED_MORE))
+          return finish_response_iov(iov, iovcnt, i, offset + parsed_bytes, segment_start + offset + parsed_bytes, response);
+
+        const uint32_t tail_len = chunk_len - parser.offset;
+        if (UNLIKELY(tail_len > (uint32_t)(scratch_limit - scratch_end)))
+          return 0;
+        memcpy(scratch_end, chunk + parser.offset, tail_len);
+        scratch_end += tail_len;
+        offset = segment_len;
+        continue;
+      }
+
+      const char *const lf = memchr(segment + offset, '\n', segment_len - offset);
+      const uint32_t take = lf ? (uint32_t)(lf - (segment + offset)) + 1 : segment_len - offset;
+      if (UNLIKELY(take > (uint32_t)(scratch_limit - scratch_end)))
+        return 0;
+      memcpy(scratch_end, segment + offset, take);
+      scratch_end += take;
+      offset += take;
+      if (lf == NULL)
+        break;
+
+      const uint32_t pending_len = scratch_end - pending;
+      const uint32_t parsed_bytes = deserialize_response_chunk(&parser, pending, pending_len, response);
+      if (UNLIKELY(parsed_bytes == 0))
+        return 0;
+      if (LIKELY(parsed_bytes != HTTP_NEED_MORE))
+      {
+        const uint32_t body_offset = offset - (pending_len - parsed_bytes);
+        return finish_response_iov(iov, iovcnt, i, body_offset, segment_start + body_offset, response);
+      }
+      pending += parser.offset;
+    }
+
+    segment_start += segment_len;
+  }
+
+  restore_response(&parser, response);
+  return HTTP_NEED_MORE;
+}
+
+uint32_t http1_deserialize_filtered(char *restrict buffer, const uint32_t buffer_size, http_response_t *const restrict response, const http_header_filter_t *const restrict filter)
+{
+  http_parser_t parser = {0};
+
+  memset(response->headers, 0, filter->names_count * sizeof(http_header_t));
+
+  tokenizer_t tokenizer;
+  tokenizer_init(&tokenizer, buffer, buffer + buffer_size, false);
+
+  const uint32_t parsed_bytes = deserialize_response(&tokenizer, &parser, buffer, response, filter, NULL, NULL);
+
+  return parsed_bytes * (parsed_bytes != HTTP_NEED_MORE);
+}
+
+uint32_t http1_deserialize_indexed(char *restrict buffer, const uint32_t buffer_size, http_response_t *const restrict response, http_header_index_t *const restrict index)
+{
+  http_parser_t parser = {0};
+
+  if (UNLIKELY(!index_reset(index, response->headers, response->headers_count)))
     return 0;
-  buffer += parsed_bytes;
 
-  parsed_bytes = deserialize_headers(buffer, buffer_end, response);
-  if (UNLIKELY(parsed_bytes == 0))
+  tokenizer_t tokenizer;
+  tokenizer_init(&tokenizer, buffer, buffer + buffer_size, false);
+
+  const uint32_t parsed_bytes = deserialize_response(&tokenizer, &parser, buffer, response, NULL, index, NULL);
+
+  return parsed_bytes * (parsed_bytes != HTTP_NEED_MORE);
+}
+
+uint32_t http1_deserialize_request_indexed(char *restrict buffer, const uint32_t buffer_size, http_request_t *const restrict request, http_header_index_t *const restrict index)
+{
+  http_parser_t parser = {0};
+
+  if (UNLIKELY(!index_reset(index, request->headers, request->headers_count)))
     return 0;
+
+  const uint32_t parsed_bytes = deserialize_request(&parser, buffer, buffer_size, request, index, NULL);
+
+  return parsed_bytes * (parsed_bytes != HTTP_NEED_MORE);
+}
+
+//the headers array is the arena's last allocation, so it grows in place up to the arena's free space
+//a full arena has no tail, a message without headers still parses and there is nothing to commit
+uint32_t http1_deserialize_arena(char *restrict buffer, const uint32_t buffer_size, http_response_t *const restrict response, http_arena_t *const restrict arena)
+{
+  uint32_t space;
+  response->headers = http_arena_tail(arena, &space);
+  const uint32_t capacity = space / sizeof(http_header_t);
+  response->headers_count = (capacity > UINT16_MAX) ? UINT16_MAX : capacity;
+
+  const uint32_t parsed_bytes = http1_deserialize(buffer, buffer_size, response);
+  if (LIKELY((parsed_bytes != 0) & (response->headers != NULL)))
+    http_arena_commit(arena, response->headers, response->headers_count * sizeof(http_header_t));
+
+  return parsed_bytes;
+}
+
+uint32_t http1_deserialize_request_arena(char *restrict buffer, const uint32_t buffer_size, http_request_t *const restrict request, http_arena_t *const restrict arena)
+{
+  uint32_t space;
+  request->headers = http_arena_tail(arena, &space);
+  const uint32_t capacity = space / sizeof(http_header_t);
+  request->headers_count = (capacity > UINT16_MAX) ? UINT16_MAX : capacity;
+
+  const uint32_t parsed_bytes = http1_deserialize_request(buffer, buffer_size, request);
+  if (LIKELY((parsed_bytes != 0) & (request->headers != NULL)))
+    http_arena_commit(arena, request->headers, request->headers_count * sizeof(http_header_t));
+
+  return parsed_bytes;
+}
+
+//headers are stored as offsets from buffer, so the result stays valid if buffer is moved
+uint32_t http1_deserialize_compact(char *restrict buffer, const uint32_t buffer_size, http_response_t *const restrict response, http_compact_headers_t *const restrict compact)
+{
+  http_parser_t parser = {0};
+
+  response->headers = NULL;
+  response->headers_count = HTTP_COMPACT_MAX_HEADERS;
+
+  tokenizer_t tokenizer;
+  tokenizer_init(&tokenizer, buffer, buffer + buffer_size, false);
+
+  const uint32_t parsed_bytes = deserialize_response(&tokenizer, &parser, buffer, response, NULL, NULL, compact);
+  compact->count = parser.headers_count;
+
+  return parsed_bytes * (parsed_bytes != HTTP_NEED_MORE);
+}
+
+uint32_t http1_deserialize_request_compact(char *restrict buffer, const uint32_t buffer_size, http_request_t *const restrict request, http_compact_headers_t *const restrict compact)
+{
+  http_parser_t parser = {0};
+
+  request->headers = NULL;
+  request->headers_count = HTTP_COMPACT_MAX_HEADERS;
+
+  const uint32_t parsed_bytes = deserialize_request(&parser, buffer, buffer_size, request, NULL, compact);
+  compact->count = parser.headers_count;
+
+  return parsed_bytes * (parsed_bytes != HTTP_NEED_MORE);
+}
+
+//the ids of every header fit in two sse registers, one compare finds them all
+uint16_t http_compact_find_id(const http_compact_headers_t *const restrict compact, const http_header_id_t id, const uint16_t from)
+{
+#ifdef __SSE2__
+  if (UNLIKELY(from >= compact->count))
+    return HTTP_COMPACT_NONE;
+
+  const __m128i needle = _mm_set1_epi8(id);
+  const uint32_t lo_mask = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)compact->ids), needle));
+  const uint32_t hi_mask = (uint16_t)_mm_movemask_epi8(_mm_cmpeq_epi8(_mm_loadu_si128((const __m128i *)(compact->ids + 16)), needle));
+  const uint64_t valid = ((1ULL << compact->count) - 1) & ~((1ULL << from) - 1);
+  const uint64_t mask = ((hi_mask << 16) | lo_mask) & valid;
+
+  return mask ? (uint16_t)__builtin_ctzll(mask) : HTTP_COMPACT_NONE;
+#else
+  for (uint16_t i = from; LIKELY(i < compact->count); i++)
+  {
+    if (compact->ids[i] == id)
+      return i;
+  }
+
+  return HTTP_COMPACT_NONE;
+#endif
+}
+
+//lengths are compared first, so only names of the right length are ever read from the buffer
+uint16_t http_compact_find(const http_compact_headers_t *const restrict compact, const char *const restrict buffer, const char *const restrict key, const uint16_t key_len, const uint16_t from)
+{
+  for (uint16_t i = from; LIKELY(i < compact->count); i++)
+  {
+    if (compact->key_lens[i] != key_len)
+      continue;
+    if (LIKELY(equals_caseless(buffer + compact->key_offsets[i], key_len, key, key_len)))
+      return i;
+  }
+
+  return HTTP_COMPACT_NONE;
+}
+
+const http_header_t *http_header_find(const http_header_index_t *const restrict index, const char *const restrict key, const uint16_t key_len, uint16_t *const restrict cursor)
+{
+  const uint64_t hash = hash_header_key(key, key_len);
+  const uint16_t mask = index->capacity - 1;
+
+  for (uint16_t probe = *cursor; probe < index->capacity; probe++)
+  {
+    const http_header_slot_t slot = index->slots[(hash + probe) & mask];
+    if (slot.header == 0)
+      break;
+    if (slot.hash != (uint32_t)hash)
+      continue;
+
+    const http_header_t *const header = &index->headers[slot.header - 1];
+    if (LIKELY(equals_caseless(header->key, header->key_len, key, key_len)))
+    {
+      *cursor = probe + 1;
+      return header;
+    }
+  }
+
+  *cursor = index->capacity;
+  return NULL;
+}
+
+bool http_header_filter_compile(http_header_filter_t *const restrict filter, const char *const *restrict names, const uint8_t names_count)
+{
+  if (UNLIKELY(names_count > HTTP_FILTER_MAX_HEADERS))
+    return false;
+
+  uint64_t hashes[HTTP_FILTER_MAX_HEADERS];
+
+  for (uint8_t i = 0; i < names_count; i++)
+  {
+    const size_t name_len = strlen(names[i]);
+    if (UNLIKELY((name_len == 0) | (name_len > UINT16_MAX)))
+      return false;
+
+    filter->names[i] = names[i];
+    filter->names_len[i] = name_len;
+    hashes[i] = hash_header_name(names[i], name_len);
+  }
+  filter->names_count = names_count;
+
+  uint64_t state = 0;
+
+  for (uint16_t attempt = 0; attempt < FILTER_MAX_SEEDS; attempt++)
+  {
+    const uint64_t seed = next_seed(&state);
+
+    memset(filter->slots, FILTER_EMPTY_SLOT, sizeof(filter->slots));
+
+    uint8_t placed = 0;
+    while (placed < names_count)
+    {
+      uint8_t *const slot = &filter->slots[(hashes[placed] * seed) >> FILTER_SLOT_SHIFT];
+      if (*slot != FILTER_EMPTY_SLOT)
+        break;
+      *slot = placed++;
+    }
+
+    if (placed == names_count)
+    {
+      filter->seed = seed;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+static uint32_t deserialize_response(tokenizer_t *const restrict tokenizer, http_parser_t *const restrict parser, char *restrict buffer, http_response_t *const restrict response, const http_header_filter_t *const restrict filter, http_header_index_t *const restrict index, http_compact_headers_t *const restrict compact)
+{
+  char *const buffer_start = buffer;
+  char *const buffer_end = tokenizer->end;
+
+  if (parser->stage == HTTP_PARSER_START_LINE)
+  {
+    char *const line_end = tokenizer_next(tokenizer, buffer, false);
+    if (UNLIKELY(line_end == NULL))
+      return suspend(tokenizer, parser, buffer_start, buffer, HTTP_PARSER_START_LINE);
+
+    const uint32_t parsed_bytes = deserialize_status_line(buffer, line_end - STR_LEN("\r"), response);
+    if (UNLIKELY(parsed_bytes == 0))
+      return 0;
+
+    parser->offset = parsed_bytes;
+    parser->stage = HTTP_PARSER_HEADER_KEY;
+  }
+
+  const uint32_t parsed_bytes = deserialize_headers(tokenizer, parser, buffer_start, response->headers, response->headers_count, filter, index, compact);
+  if (UNLIKELY((parsed_bytes == 0) | (parsed_bytes == HTTP_NEED_MORE)))
+    return parsed_bytes;
   buffer += parsed_bytes;
 
+  response->headers_count = filter ? filter->names_count : parser->headers_count;
   response->body = (char *)((buffer < buffer_end) * (uintptr_t)buffer);
 
+  const uint16_t status_code = response->status_code;
+  const bool bodyless = (status_code < 200) | (status_code == 204) | (status_code == 304);
+
+  bool keep_alive;
+  http_framing_t framing = resolve_framing(parser, response->version, &keep_alive);
+  if (UNLIKELY(bodyless))
+    framing = HTTP_FRAMING_NONE;
+  else if (UNLIKELY(framing == HTTP_FRAMING_NONE))
+  {
+    framing = HTTP_FRAMING_CLOSE;
+    keep_alive = false;
+  }
+
+  response->framing = framing;
+  response->keep_alive = keep_alive;
+  response->emit_content_length = false;
+  response->body_len = (framing == HTTP_FRAMING_CONTENT_LENGTH) * parser->content_length;
+  response->body_len += (framing == HTTP_FRAMING_CLOSE) * (uint32_t)(buffer_end - buffer);
+
+  return buffer - buffer_start;
+}
+
+static uint32_t deserialize_request(http_parser_t *const restrict parser, char *restrict buffer, const uint32_t buffer_size, http_request_t *const restrict request, http_header_index_t *const restrict index, http_compact_headers_t *const restrict compact)
+{
+  char *const buffer_start = buffer;
+  char *const buffer_end = buffer + buffer_size;
+
+  tokenizer_t tokenizer;
+  tokenizer_init(&tokenizer, buffer + parser->block_offset, buffer_end, parser->carry);
+
+  if (parser->stage == HTTP_PARSER_START_LINE)
+  {
+    char *const line_end = tokenizer_next(&tokenizer, buffer, false);
+    if (UNLIKELY(line_end == NULL))
+      return suspend(&tokenizer, parser, buffer_start, buffer, HTTP_PARSER_START_LINE);
+
+    const uint32_t parsed_bytes = deserialize_request_line(buffer, line_end - STR_LEN("\r"), request);
+    if (UNLIKELY(parsed_bytes == 0))
+      return 0;
+
+    parser->offset = parsed_bytes;
+    parser->stage = HTTP_PARSER_HEADER_KEY;
+  }
+
+  const uint32_t parsed_bytes = deserialize_headers(&tokenizer, parser, buffer_start, request->headers, request->headers_count, NULL, index, compact);
+  if (UNLIKELY((parsed_bytes == 0) | (parsed_bytes == HTTP_NEED_MORE)))
+    return parsed_bytes;
+  buffer += parsed_bytes;
+
+  request->headers_count = parser->headers_count;
+  request->body = (char *)((buffer < buffer_end) * (uintptr_t)buffer);
+
+  bool keep_alive;
+  const http_framing_t framing = resolve_framing(parser, request->version, &keep_alive);
+  if (UNLIKELY(framing == HTTP_FRAMING_CLOSE))
+    return 0;
+
+  request->framing = framing;
+  request->keep_alive = keep_alive;
+  request->emit_content_length = false;
+  request->body_len = (framing == HTTP_FRAMING_CONTENT_LENGTH) * parser->content_length;
+
   return buffer - buffer_start;
 }
 
-static uint32_t deserialize_status_line(char *buffer, char *const buffer_end, http_response_t *const restrict response)
+//every chunk starts where the unparsed bytes start, so the parser is rewound to its beginning
+static uint32_t deserialize_response_chunk(http_parser_t *const restrict parser, char *const chunk, const uint32_t chunk_len, http_response_t *const restrict response)
+{
+  tokenizer_t tokenizer;
+  tokenizer_init(&tokenizer, chunk, chunk + chunk_len, false);
+
+  parser->offset = 0;
+  parser->block_offset = 0;
+  parser->carry = false;
+
+  return deserialize_response(&tokenizer, parser, chunk, response, NULL, NULL, NULL);
+}
+
+//the body of a scattered message starts at segment_offset, possibly at the start of a later segment
+static uint32_t finish_response_iov(const struct iovec *restrict iov, const uint16_t iovcnt, uint16_t segment, uint32_t segment_offset, uint32_t head_len, http_response_t *const restrict response)
+{
+  uint32_t available = 0;
+  for (uint16_t i = segment; LIKELY(i < iovcnt); i++)
+    available += iov[i].iov_len;
+  available -= segment_offset;
+
+  while (LIKELY(segment < iovcnt) && (segment_offset == iov[segment].iov_len))
+  {
+    segment++;
+    segment_offset = 0;
+  }
+
+  response->body = (segment < iovcnt) ? (char *)iov[segment].iov_base + segment_offset : NULL;
+  if (response->framing == HTTP_FRAMING_CLOSE)
+    response->body_len = available;
+
+  return head_len;
+}
+
+//puts back the delimiters replaced with '\0', so that an incomplete message can be parsed again once the rest arrives
+static void restore_response(const http_parser_t *const restrict parser, http_response_t *const restrict response)
+{
+  if (parser->stage == HTTP_PARSER_START_LINE)
+    return;
+
+  response->reason_phrase[response->reason_phrase_len] = '\r';
+
+  const http_header_t *const headers = response->headers;
+  const uint16_t headers_count = parser->headers_count;
+
+  for (uint16_t i = 0; i < headers_count; i++)
+  {
+    headers[i].key[headers[i].key_len] = ':';
+    headers[i].value[headers[i].value_len] = '\r';
+  }
+
+  if (parser->stage == HTTP_PARSER_HEADER_VALUE)
+    headers[headers_count].key[headers[headers_count].key_len] = ':';
+}
+
+static uint32_t deserialize_status_line(char *buffer, char *const line_end, http_response_t *const restrict response)
 {
   char *const line_start = buffer;
-  char *const line_end = memmem(buffer, buffer_end - buffer, "\r\n", STR_LEN("\r\n"));
+
+  if (UNLIKELY(line_end - line_start < (ptrdiff_t)STR_LEN("HTTP/1.1 200")))
+    return 0;
 
   uint32_t parsed_bytes;
 
+  parsed_bytes = deserialize_version(buffer, &response->version);
+  if (UNLIKELY(parsed_bytes == 0))
+    return 0;
+  buffer += parsed_bytes;
+
   parsed_bytes = deserialize_status_code(buffer, line_end, response);
   if (UNLIKELY(parsed_bytes == 0))
     return 0;
@@ -65,6 +763,15 @@ static uint32_t deserialize_status_line(char *buffer, char *const buffer_end, ht
 
 static uint16_t deserialize_status_code(char *buffer, char *const line_end, http_response_t *const restrict response)
 {
+  //the status line is almost always "HTTP/1.x DDD ...", then the three digits are decoded at once
+  uint32_t fast_code;
+  const bool fixed_shape = (buffer[0] == ' ') & ((buffer + 4 == line_end) || (buffer[4] == ' '));
+  if (LIKELY(fixed_shape && parse_digits_swar(buffer + 1, 3, &fast_code)))
+  {
+    response->status_code = fast_code;
+    return STR_LEN(" 200") * ((fast_code - 100) < 499);
+  }
+
   const char *const buffer_start = buffer;
   const char *const space = memchr(buffer, ' ', line_end - buffer);
 
@@ -98,52 +805,607 @@ static uint16_t deserialize_reason_phrase(char *buffer, char *const line_end, ht
   return (buffer - buffer_start) * valid;
 }
 
-static uint32_t deserialize_headers(char *restrict buffer, char *const buffer_end, http_response_t *const restrict response)
+static uint32_t deserialize_request_line(char *buffer, char *const line_end, http_request_t *const restrict request)
 {
-  const char *const buffer_start = buffer;
+  char *const line_start = buffer;
 
-  const uint16_t max_headers = response->headers_count;
-  http_header_t *headers = response->headers;
-  uint16_t headers_count = 0;
+  if (UNLIKELY(line_end - line_start < (ptrdiff_t)STR_LEN("GET / HTTP/1.1")))
+    return 0;
+
+  char *const version = line_end - sizeof(uint64_t);
+  char *const path_end = version - STR_LEN(" ");
+  if (UNLIKELY(*path_end != ' '))
+    return 0;
+
+  uint32_t parsed_bytes;
 
-  while (LIKELY(!memcmp2(buffer, "\r\n")))
+  parsed_bytes = deserialize_method(buffer, request);
+  if (UNLIKELY(parsed_bytes == 0))
+    return 0;
+  buffer += parsed_bytes;
+
+  parsed_bytes = deserialize_path(buffer, path_end, request);
+  if (UNLIKELY(parsed_bytes == 0))
+    return 0;
+  buffer += parsed_bytes;
+
+  parsed_bytes = deserialize_version(buffer, &request->version);
+  if (UNLIKELY(parsed_bytes == 0))
+    return 0;
+  buffer += parsed_bytes;
+
+  buffer += STR_LEN("\r\n");
+
+  return buffer - line_start;
+}
+
+static inline uint8_t deserialize_method(const char *buffer, http_request_t *const restrict request)
+{
+  constexpr uint64_t ones = 0x0101010101010101;
+  constexpr uint64_t highs = 0x8080808080808080;
+  constexpr uint64_t spaces = 0x2020202020202020;
+
+  uint64_t word;
+  memcpy8(&word, buffer);
+
+  const uint64_t x = word ^ spaces;
+  const uint64_t space_bytes = (x - ones) & ~x & highs;
+  if (UNLIKELY(space_bytes == 0))
+    return 0;
+
+  const uint8_t method_len = __builtin_ctzll(space_bytes) >> 3;
+  word &= (UINT64_C(1) << (method_len << 3)) - 1;
+
+  const http_method_t method = methods_hash[(word * METHODS_HASH_SEED) >> 60];
+  request->method = method;
+
+  const bool valid = memcmp8(&word, methods_str[method]);
+
+  return (method_len + STR_LEN(" ")) * valid;
+}
+
+static inline uint16_t deserialize_path(char *buffer, char *const path_end, http_request_t *const restrict request)
+{
+  char *const path = buffer;
+  const uint32_t path_len = path_end - path;
+
+  request->path = path;
+  request->path_len = path_len;
+  *path_end = '\0';
+
+  const bool valid = (path_len != 0) & (path_len <= UINT16_MAX);
+
+  return (path_len + STR_LEN(" ")) * valid;
+}
+
+static inline uint8_t deserialize_version(const char *buffer, http_version_t *const restrict version)
+{
+  const bool is_1_0 = memcmp8(buffer, versions_str[HTTP_1_0]);
+  const bool is_1_1 = memcmp8(buffer, versions_str[HTTP_1_1]);
+
+  *version = HTTP_1_0 + is_1_1;
+
+  return sizeof(uint64_t) * (is_1_0 | is_1_1);
+}
+
+//without a filter every header is stored in order, with one only the wanted ones are, in the slots of their ids. The others are left untouched
+static uint32_t deserialize_headers(tokenizer_t *const restrict tokenizer, http_parser_t *const restrict parser, char *const buffer_start, http_header_t *const restrict headers, const uint16_t max_headers, const http_header_filter_t *const restrict filter, http_header_index_t *const restrict index, http_compact_headers_t *const restrict compact)
+{
+  const char *const buffer_end = tokenizer->end;
+
+  char *buffer = buffer_start + parser->offset;
+  http_parser_stage_t stage = parser->stage;
+  uint16_t count = parser->headers_count;
+
+  uint16_t slot = count;
+  const char *key = NULL;
+  uint16_t key_len = 0;
+  http_header_id_t id = HTTP_HEADER_UNKNOWN;
+
+  if (UNLIKELY((stage == HTTP_PARSER_HEADER_VALUE) & (compact != NULL)))
   {
-    char *const key = buffer;
-    buffer = memchr(buffer, ':', buffer_end - buffer);
-    bool valid_header = (buffer != NULL) & (headers_count < max_headers);
-    if (UNLIKELY(!valid_header))
-      return 0;
-    uint32_t key_len = buffer - key;
-    *buffer++ = '\0';
-    buffer += strspn(buffer, " \t");
-    const bool valid_key = (key_len != 0) & (key_len <= UINT16_MAX);
+    key = buffer_start + compact->key_offsets[slot];
+    key_len = compact->key_lens[slot];
+    id = compact->ids[slot];
+  }
+  else if (UNLIKELY(stage == HTTP_PARSER_HEADER_VALUE))
+  {
+    key = headers[slot].key;
+    key_len = headers[slot].key_len;
+    id = headers[slot].id;
+  }
+
+  while (true)
+  {
+    if (LIKELY(stage == HTTP_PARSER_HEADER_KEY))
+    {
+      if (UNLIKELY(buffer_end - buffer < (ptrdiff_t)STR_LEN("\r\n")))
+        break;
+      if (memcmp2(buffer, "\r\n"))
+      {
+        buffer += STR_LEN("\r\n");
+        parser->headers_count = count;
+        return buffer - buffer_start;
+      }
+
+      char *const name = buffer;
+      buffer = tokenizer_next(tokenizer, buffer, true);
+      if (UNLIKELY(buffer == NULL))
+      {
+        buffer = name;
+        break;
+      }
+      const bool valid_header = (*buffer == ':') & ((filter != NULL) | (count < max_headers));
+      if (UNLIKELY(!valid_header))
+        return 0;
+      const uint32_t name_len = buffer - name;
+      const bool valid_key = (name_len != 0) & (name_len <= UINT16_MAX);
+      if (UNLIKELY(!valid_key))
+        return 0;
+
+      key = name;
+      key_len = name_len;
+      const uint64_t name_hash = hash_header_name(key, key_len);
+      id = match_header_id(key, key_len, name_hash);
+      slot = filter ? match_header(filter, key, key_len, name_hash) : count;
+      if (LIKELY(slot != FILTER_NO_SLOT))
+      {
+        *buffer = '\0';
+        if (compact)
+        {
+          compact->key_offsets[slot] = name - buffer_start;
+          compact->key_lens[slot] = key_len;
+          compact->ids[slot] = id;
+        }
+        else
+        {
+          headers[slot].key = name;
+          headers[slot].key_len = key_len;
+          headers[slot].id = id;
+        }
+      }
+      if (index)
+        index_insert(index, hash_header_key(key, key_len), slot);
+      buffer++;
+      stage = HTTP_PARSER_HEADER_VALUE;
+    }
+
+    buffer = skip_ows(buffer, buffer_end);
 
     char *const value = buffer;
-    buffer = memmem(buffer, buffer_end - buffer, "\r\n", STR_LEN("\r\n"));
+    buffer = tokenizer_next(tokenizer, buffer, false);
     if (UNLIKELY(buffer == NULL))
-      return 0;
-    uint32_t value_len = buffer - value;
-    *buffer = '\0';
-    buffer += STR_LEN("\r\n");
+    {
+      buffer = value;
+      break;
+    }
+    buffer -= STR_LEN("\r");
+    const uint32_t value_len = buffer - value;
     const bool valid_value = (value_len != 0) & (value_len <= UINT16_MAX);
+    if (UNLIKELY(!valid_value))
+      return 0;
 
-    valid_header = valid_key & valid_value;
-    if (UNLIKELY(!valid_header))
+    inspect_header(parser, id, value, value_len);
+    //the value ends after its key, so checking its end also covers the key offset stored before
+    if (UNLIKELY((compact != NULL) && (buffer - buffer_start > UINT16_MAX)))
       return 0;
+    if (LIKELY(slot != FILTER_NO_SLOT))
+    {
+      *buffer = '\0';
+      if (compact)
+      {
+        compact->value_offsets[slot] = value - buffer_start;
+        compact->value_lens[slot] = value_len;
+      }
+      else
+      {
+        headers[slot].value = value;
+        headers[slot].value_len = value_len;
+      }
+    }
+    buffer += STR_LEN("\r\n");
+    count += (filter == NULL);
+    stage = HTTP_PARSER_HEADER_KEY;
+  }
+
+  parser->headers_count = count;
+  return suspend(tokenizer, parser, buffer_start, buffer, stage);
+}
+
+//names are told apart by their hash, the slot is then confirmed with a full compare
+static inline uint16_t match_header(const http_header_filter_t *const restrict filter, const char *const key, const uint16_t key_len, const uint64_t hash)
+{
+  const uint8_t id = filter->slots[(hash * filter->seed) >> FILTER_SLOT_SHIFT];
+  if (LIKELY(id == FILTER_EMPTY_SLOT))
+    return FILTER_NO_SLOT;
+
+  const bool match = equals_caseless(key, key_len, filter->names[id], filter->names_len[id]);
+
+  return match ? id : FILTER_NO_SLOT;
+}
+
+static inline http_header_id_t match_header_id(const char *const key, const uint16_t key_len, const uint64_t hash)
+{
+  const http_header_id_t id = header_ids_hash[(hash * header_ids_seed) >> HEADER_IDS_SLOT_SHIFT];
+  const uint8_t name_len = header_names_len[id] - STR_LEN(": ");
+
+  const bool match = (id != HTTP_HEADER_UNKNOWN) && equals_caseless(key, key_len, header_names_str[id], name_len);
+
+  return match ? id : HTTP_HEADER_UNKNOWN;
+}
 
-    *headers++ = (http_header_t) {
-      .key = key,
-      .key_len = key_len,
-      .value = value,
-      .value_len = value_len
-    };
-    headers_count++;
+//shared with HPACK and QPACK: literal names get the same id as names taken from a table
+http_header_id_t lookup_header_id(const char *const key, const uint16_t key_len)
+{
+  return match_header_id(key, key_len, hash_header_name(key, key_len));
+}
+
+//the seeds are tried in a fixed order, so every process ends up with the same table
+static void header_ids_compile(void)
+{
+  uint64_t hashes[HEADER_IDS_COUNT];
+
+  for (uint8_t id = HTTP_HEADER_UNKNOWN + 1; id < HEADER_IDS_COUNT; id++)
+    hashes[id] = hash_header_name(header_names_str[id], header_names_len[id] - STR_LEN(": "));
+
+  uint64_t state = 0;
+
+  for (uint16_t attempt = 0; attempt < FILTER_MAX_SEEDS; attempt++)
+  {
+    const uint64_t seed = next_seed(&state);
+
+    memset(header_ids_hash, HTTP_HEADER_UNKNOWN, sizeof(header_ids_hash));
+
+    uint8_t id = HTTP_HEADER_UNKNOWN + 1;
+    while (id < HEADER_IDS_COUNT)
+    {
+      http_header_id_t *const slot = &header_ids_hash[(hashes[id] * seed) >> HEADER_IDS_SLOT_SHIFT];
+      if (*slot != HTTP_HEADER_UNKNOWN)
+        break;
+      *slot = id++;
+    }
+
+    if (id == HEADER_IDS_COUNT)
+    {
+      header_ids_seed = seed;
+      return;
+    }
   }
+}
 
-  buffer += STR_LEN("\r\n");
-  response->headers_count = headers_count;
+//splitmix64, any odd multiplier that spreads the names over distinct slots will do
+static inline uint64_t next_seed(uint64_t *const restrict state)
+{
+  *state += UINT64_C(0x9e3779b97f4a7c15);
 
-  return buffer - buffer_start;
+  uint64_t seed = *state;
+  seed = (seed ^ (seed >> 30)) * UINT64_C(0xbf58476d1ce4e5b9);
+  seed = (seed ^ (seed >> 27)) * UINT64_C(0x94d049bb133111eb);
+
+  return (seed ^ (seed >> 31)) | 1;
+}
+
+//every lowercased word is folded in, so names of the same length that differ anywhere get different hashes
+static inline uint64_t hash_header_name(const char *const key, const uint16_t key_len)
+{
+  uint64_t hash = key_len;
+
+  for (uint16_t i = 0; i < key_len; i += sizeof(uint64_t))
+  {
+    const uint16_t remaining = key_len - i;
+    const uint8_t chunk_len = (remaining < sizeof(uint64_t)) ? remaining : sizeof(uint64_t);
+    uint64_t word = 0;
+
+    memcpy(&word, key + i, chunk_len);
+
+    hash = ((hash << 29) | (hash >> 35)) ^ tolower_swar(word);
+  }
+
+  return hash;
+}
+
+static inline bool index_reset(http_header_index_t *const restrict index, const http_header_t *const headers, const uint16_t max_headers)
+{
+  const uint16_t capacity = index->capacity;
+
+  //a free slot always ends the probing, even when every header has been stored
+  const bool valid = ((capacity & (capacity - 1)) == 0) & (capacity > max_headers);
+  if (UNLIKELY(!valid))
+    return false;
+
+  memset(index->slots, 0, capacity * sizeof(http_header_slot_t));
+  index->headers = headers;
+
+  return true;
+}
+
+//duplicates are stored one after the other along the probe sequence, see http_header_find()
+static inline void index_insert(http_header_index_t *const restrict index, const uint64_t hash, const uint16_t header)
+{
+  const uint16_t mask = index->capacity - 1;
+  uint16_t position = hash & mask;
+
+  while (index->slots[position].header != 0)
+    position = (position + 1) & mask;
+
+  index->slots[position] = (http_header_slot_t){
+    .hash = hash,
+    .header = header + 1
+  };
+}
+
+//xxhash64 over the lowercased key, 8 bytes per round
+static inline uint64_t hash_header_key(const char *const key, const uint16_t key_len)
+{
+  uint64_t hash = XXH_PRIME64_5 + key_len;
+
+  for (uint16_t i = 0; i < key_len; i += sizeof(uint64_t))
+  {
+    const uint16_t remaining = key_len - i;
+    const uint8_t chunk_len = (remaining < sizeof(uint64_t)) ? remaining : sizeof(uint64_t);
+    uint64_t word = 0;
+
+    memcpy(&word, key + i, chunk_len);
+
+    hash ^= xxh_round(tolower_swar(word));
+    hash = ((hash << 27) | (hash >> 37)) * XXH_PRIME64_1 + XXH_PRIME64_4;
+  }
+
+  hash ^= hash >> 33;
+  hash *= XXH_PRIME64_2;
+  hash ^= hash >> 29;
+  hash *= XXH_PRIME64_3;
+  hash ^= hash >> 32;
+
+  return hash;
+}
+
+static inline uint64_t xxh_round(uint64_t word)
+{
+  word *= XXH_PRIME64_2;
+  word = (word << 31) | (word >> 33);
+
+  return word * XXH_PRIME64_1;
+}
+
+//records the headers which decide where the body ends
+static inline void inspect_header(http_parser_t *const restrict parser, const http_header_id_t id, const char *const value, const uint16_t value_len)
+{
+  const char *const value_end = value + value_len;
+
+  switch (id)
+  {
+    case HTTP_HEADER_CONTENT_LENGTH:
+      inspect_content_length(parser, value, value_end);
+      break;
+    case HTTP_HEADER_TRANSFER_ENCODING:
+      inspect_transfer_encoding(parser, value, value_end);
+      break;
+    case HTTP_HEADER_CONNECTION:
+      inspect_connection(parser, value, value_end);
+      break;
+    default:
+      break;
+  }
+}
+
+static inline void inspect_content_length(http_parser_t *const restrict parser, const char *const value, const char *value_end)
+{
+  value_end = trim_ows(value, value_end);
+  const uint16_t value_len = value_end - value;
+
+  uint32_t content_length = 0;
+  uint32_t low_digits = 0;
+  const uint8_t high_len = (value_len > sizeof(uint64_t)) * (value_len - sizeof(uint64_t));
+
+  bool valid = (value_len != 0) & (value_len <= MAX_CONTENT_LENGTH_DIGITS);
+  if (LIKELY(valid))
+  {
+    valid &= (high_len == 0) || parse_digits_swar(value, high_len, &content_length);
+    valid &= parse_digits_swar(value + high_len, value_len - high_len, &low_digits);
+  }
+
+  const uint64_t length = (uint64_t)content_length * 100'000'000 + low_digits;
+  valid &= (length <= UINT32_MAX);
+
+  const bool seen = parser->framing_flags & FRAMING_CONTENT_LENGTH;
+  valid &= !seen | (parser->content_length == length);
+
+  parser->content_length = length * valid;
+  parser->framing_flags |= valid ? FRAMING_CONTENT_LENGTH : FRAMING_INVALID_LENGTH;
+}
+
+//only the last transfer coding matters, the body is chunked when it is "chunked"
+static inline void inspect_transfer_encoding(http_parser_t *const restrict parser, const char *const value, const char *value_end)
+{
+  value_end = trim_ows(value, value_end);
+  const char *const coding = value_end - STR_LEN("chunked");
+
+  bool chunked = (value_end - value >= (ptrdiff_t)STR_LEN("chunked"));
+  chunked = chunked && equals_caseless(coding, STR_LEN("chunked"), "chunked", STR_LEN("chunked"));
+  chunked = chunked && ((coding == value) || (coding[-1] == ',') | (coding[-1] == ' ') | (coding[-1] == '\t'));
+
+  parser->framing_flags |= FRAMING_TRANSFER_ENCODING;
+  parser->framing_flags &= ~FRAMING_CHUNKED;
+  parser->framing_flags |= FRAMING_CHUNKED * chunked;
+}
+
+static inline void inspect_connection(http_parser_t *const restrict parser, const char *value, const char *const value_end)
+{
+  while (value < value_end)
+  {
+    const char *const token = skip_ows((char *)value, value_end);
+    const uint16_t remaining = value_end - token;
+    const char *const comma = memchr(token, ',', remaining);
+    const char *const token_end = comma ? comma : value_end;
+    const uint16_t token_len = trim_ows(token, token_end) - token;
+
+    parser->framing_flags |= FRAMING_CONNECTION_CLOSE * equals_caseless(token, token_len, "close", STR_LEN("close"));
+    parser->framing_flags |= FRAMING_CONNECTION_KEEP_ALIVE * equals_caseless(token, token_len, "keep-alive", STR_LEN("keep-alive"));
+
+    value = token_end + STR_LEN(",");
+  }
+}
+
+//NONE means no framing header was found, the caller decides what that implies for its message kind
+static http_framing_t resolve_framing(const http_parser_t *const restrict parser, const http_version_t version, bool *const restrict keep_alive)
+{
+  const uint8_t flags = parser->framing_flags;
+
+  bool persistent = (version == HTTP_1_1) | !!(flags & FRAMING_CONNECTION_KEEP_ALIVE);
+  persistent &= !(flags & FRAMING_CONNECTION_CLOSE);
+
+  if (UNLIKELY(flags & FRAMING_TRANSFER_ENCODING))
+  {
+    const bool chunked = flags & FRAMING_CHUNKED;
+    const bool smuggled = flags & (FRAMING_CONTENT_LENGTH | FRAMING_INVALID_LENGTH);
+
+    *keep_alive = persistent & chunked & !smuggled;
+    return chunked ? HTTP_FRAMING_CHUNKED : HTTP_FRAMING_CLOSE;
+  }
+
+  if (UNLIKELY(flags & FRAMING_INVALID_LENGTH))
+  {
+    *keep_alive = false;
+    return HTTP_FRAMING_CLOSE;
+  }
+
+  *keep_alive = persistent;
+  return (flags & FRAMING_CONTENT_LENGTH) ? HTTP_FRAMING_CONTENT_LENGTH : HTTP_FRAMING_NONE;
+}
+
+//parses up to 8 decimal digits at once, the word is left-padded with '0's so the digits land in the low bytes
+static inline bool parse_digits_swar(const char *str, const uint8_t len, uint32_t *const restrict value)
+{
+  constexpr uint64_t zeros = 0x3030303030303030;
+  constexpr uint64_t high_nibbles = 0xF0F0F0F0F0F0F0F0;
+
+  uint64_t word = zeros;
+  memcpy((char *)&word + sizeof(uint64_t) - len, str, len);
+
+  bool valid = ((word & high_nibbles) == zeros);
+  valid &= (((word + 0x0606060606060606) & high_nibbles) == zeros);
+
+  word -= zeros;
+  word = (word * 10 + (word >> 8)) & 0x00FF00FF00FF00FF;
+  word = (word * 100 + (word >> 16)) & 0x0000FFFF0000FFFF;
+  word = (word * 10000 + (word >> 32)) & 0x00000000FFFFFFFF;
+
+  *value = word;
+  return valid;
+}
+
+static inline uint32_t suspend(tokenizer_t *const restrict tokenizer, http_parser_t *const restrict parser, const char *const buffer_start, const char *const buffer, const http_parser_stage_t stage)
+{
+  parser->offset = buffer - buffer_start;
+  parser->block_offset = tokenizer->block - buffer_start;
+  parser->carry = tokenizer->carry;
+  parser->stage = stage;
+
+  return HTTP_NEED_MORE;
+}
+
+static inline void tokenizer_init(tokenizer_t *const restrict tokenizer, char *const block, char *const end, const bool carry)
+{
+  *tokenizer = (tokenizer_t){
+    .block = block,
+    .end = end,
+    .carry = carry
+  };
+
+  tokenizer_load(tokenizer);
+}
+
+static inline void tokenizer_load(tokenizer_t *const restrict tokenizer)
+{
+  const ptrdiff_t remaining = tokenizer->end - tokenizer->block;
+  block_masks_t masks;
+
+  if (LIKELY(remaining >= BLOCK_SIZE))
+    masks = classify_block(tokenizer->block);
+  else
+  {
+    char tail[BLOCK_SIZE] ALIGNED(BLOCK_SIZE) = {0};
+    memcpy(tail, tokenizer->block, remaining * (remaining > 0));
+    masks = classify_block(tail);
+  }
+
+  tokenizer->colons = masks.colons;
+  tokenizer->eols = masks.lfs & ((masks.crs << 1) | tokenizer->carry);
+}
+
+static inline void tokenizer_advance(tokenizer_t *const restrict tokenizer)
+{
+  tokenizer->carry = (tokenizer->block[BLOCK_SIZE - 1] == '\r');
+  tokenizer->block += BLOCK_SIZE;
+  tokenizer_load(tokenizer);
+}
+
+//returns the first '\n' of a CRLF (or the first ':' when colons is set) at or after from, NULL if the buffer ends first
+static inline char *tokenizer_next(tokenizer_t *const restrict tokenizer, const char *const from, const bool colons)
+{
+  const uint64_t colons_mask = -(uint64_t)colons;
+
+  while (UNLIKELY(from >= tokenizer->block + BLOCK_SIZE))
+  {
+    if (UNLIKELY(tokenizer->block + BLOCK_SIZE >= tokenizer->end))
+      return NULL;
+    tokenizer_advance(tokenizer);
+  }
+
+  const ptrdiff_t shift = from - tokenizer->block;
+  uint64_t events = (tokenizer->eols | (tokenizer->colons & colons_mask)) & (UINT64_MAX << (shift * (shift > 0)));
+
+  while (UNLIKELY(events == 0))
+  {
+    if (UNLIKELY(tokenizer->block + BLOCK_SIZE >= tokenizer->end))
+      return NULL;
+    tokenizer_advance(tokenizer);
+    events = tokenizer->eols | (tokenizer->colons & colons_mask);
+  }
+
+  return tokenizer->block + __builtin_ctzll(events);
+}
+
+//moves the tokenizer to a block starting at from, unless from is still inside the current one
+static inline void tokenizer_seek(tokenizer_t *const restrict tokenizer, char *const from)
+{
+  if (LIKELY(from < tokenizer->block + BLOCK_SIZE))
+    return;
+
+  tokenizer->carry = (from[-1] == '\r');
+  tokenizer->block = from;
+  tokenizer_load(tokenizer);
+}
+
+static inline char *skip_ows(char *buffer, const char *const buffer_end)
+{
+  while (LIKELY(buffer < buffer_end) && ((*buffer == ' ') | (*buffer == '\t')))
+    buffer++;
+
+  return buffer;
+}
+
+static inline const char *trim_ows(const char *const buffer_start, const char *buffer)
+{
+  while (LIKELY(buffer > buffer_start) && ((buffer[-1] == ' ') | (buffer[-1] == '\t')))
+    buffer--;
+
+  return buffer;
+}
+
+static block_masks_t classify_scalar(const char *block)
+{
+  block_masks_t masks = {0};
+
+  for (uint8_t i = 0; i < BLOCK_SIZE; i++)
+  {
+    masks.colons |= (uint64_t)(block[i] == ':') << i;
+    masks.crs |= (uint64_t)(block[i] == '\r') << i;
+    masks.lfs |= (uint64_t)(block[i] == '\n') << i;
+  }
+
+  return masks;
 }
 
 static uint32_t atoui(const char *str, char **endptr)
@@ -0,0 +1,796 @@
+/*================================================================================
+
+File: hpack.c                                                                   
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-03-10 09:12:40                                                 
+last edited: 2025-03-15 13:41:09                                                
+
+================================================================================*/
+
+#include <string.h>
+
+#include "common.h"
+#include "hpack_internal.h"
+#include "hpack.h"
+
+# define STATIC_TABLE_SIZE 61
+# define HUFFMAN_EOS 256
+# define HUFFMAN_EMIT (1 << 0)
+# define HUFFMAN_FAIL (1 << 1)
+# define HUFFMAN_ACCEPT (1 << 2)
+
+typedef struct
+{
+  const char *name;
+  const char *value;
+  uint8_t name_len;
+  uint8_t value_len;
+  http_header_id_t id;
+} static_entry_t;
+
+//state after feeding 4 bits to the decoder from a node of the code tree, with the symbol completed on the way if any
+typedef struct
+{
+  uint8_t state;
+  uint8_t flags;
+  uint8_t symbol;
+} huffman_transition_t;
+
+# define STATIC_ENTRY(n, v, i) { n, v, STR_LEN(n), STR_LEN(v), i }
+
+//RFC 7541 Appendix A, index 0 is unused
+constexpr static_entry_t static_table[STATIC_TABLE_SIZE + 1] = {
+  STATIC_ENTRY("", "", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":authority", "", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":method", "GET", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":method", "POST", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":path", "/", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":path", "/index.html", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":scheme", "http", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":scheme", "https", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "200", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "204", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "206", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "304", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "400", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "404", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "500", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("accept-charset", "", HTTP_HEADER_ACCEPT_CHARSET),
+  STATIC_ENTRY("accept-encoding", "gzip, deflate", HTTP_HEADER_ACCEPT_ENCODING),
+  STATIC_ENTRY("accept-language", "", HTTP_HEADER_ACCEPT_LANGUAGE),
+  STATIC_ENTRY("accept-ranges", "", HTTP_HEADER_ACCEPT_RANGES),
+  STATIC_ENTRY("accept", "", HTTP_HEADER_ACCEPT),
+  STATIC_ENTRY("access-control-allow-origin", "", HTTP_HEADER_ACCESS_CONTROL_ALLOW_ORIGIN),
+  STATIC_ENTRY("age", "", HTTP_HEADER_AGE),
+  STATIC_ENTRY("allow", "", HTTP_HEADER_ALLOW),
+  STATIC_ENTRY("authorization", "", HTTP_HEADER_AUTHORIZATION),
+  STATIC_ENTRY("cache-control", "", HTTP_HEADER_CACHE_CONTROL),
+  STATIC_ENTRY("content-disposition", "", HTTP_HEADER_CONTENT_DISPOSITION),
+  STATIC_ENTRY("content-encoding", "", HTTP_HEADER_CONTENT_ENCODING),
+  STATIC_ENTRY("content-language", "", HTTP_HEADER_CONTENT_LANGUAGE),
+  STATIC_ENTRY("content-length", "", HTTP_HEADER_CONTENT_LENGTH),
+  STATIC_ENTRY("content-location", "", HTTP_HEADER_CONTENT_LOCATION),
+  STATIC_ENTRY("content-range", "", HTTP_HEADER_CONTENT_RANGE),
+  STATIC_ENTRY("content-type", "", HTTP_HEADER_CONTENT_TYPE),
+  STATIC_ENTRY("cookie", "", HTTP_HEADER_COOKIE),
+  STATIC_ENTRY("date", "", HTTP_HEADER_DATE),
+  STATIC_ENTRY("etag", "", HTTP_HEADER_ETAG),
+  STATIC_ENTRY("expect", "", HTTP_HEADER_EXPECT),
+  STATIC_ENTRY("expires", "", HTTP_HEADER_EXPIRES),
+  STATIC_ENTRY("from", "", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("host", "", HTTP_HEADER_HOST),
+  STATIC_ENTRY("if-match", "", HTTP_HEADER_IF_MATCH),
+  STATIC_ENTRY("if-modified-since", "", HTTP_HEADER_IF_MODIFIED_SINCE),
+  STATIC_ENTRY("if-none-match", "", HTTP_HEADER_IF_NONE_MATCH),
+  STATIC_ENTRY("if-range", "", HTTP_HEADER_IF_RANGE),
+  STATIC_ENTRY("if-unmodified-since", "", HTTP_HEADER_IF_UNMODIFIED_SINCE),
+  STATIC_ENTRY("last-modified", "", HTTP_HEADER_LAST_MODIFIED),
+  STATIC_ENTRY("link", "", HTTP_HEADER_LINK),
+  STATIC_ENTRY("location", "", HTTP_HEADER_LOCATION),
+  STATIC_ENTRY("max-forwards", "", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("proxy-authenticate", "", HTTP_HEADER_PROXY_AUTHENTICATE),
+  STATIC_ENTRY("proxy-authorization", "", HTTP_HEADER_PROXY_AUTHORIZATION),
+  STATIC_ENTRY("range", "", HTTP_HEADER_RANGE),
+  STATIC_ENTRY("referer", "", HTTP_HEADER_REFERER),
+  STATIC_ENTRY("refresh", "", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("retry-after", "", HTTP_HEADER_RETRY_AFTER),
+  STATIC_ENTRY("server", "", HTTP_HEADER_SERVER),
+  STATIC_ENTRY("set-cookie", "", HTTP_HEADER_SET_COOKIE),
+  STATIC_ENTRY("strict-transport-security", "", HTTP_HEADER_STRICT_TRANSPORT_SECURITY),
+  STATIC_ENTRY("transfer-encoding", "", HTTP_HEADER_TRANSFER_ENCODING),
+  STATIC_ENTRY("user-agent", "", HTTP_HEADER_USER_AGENT),
+  STATIC_ENTRY("vary", "", HTTP_HEADER_VARY),
+  STATIC_ENTRY("via", "", HTTP_HEADER_VIA),
+  STATIC_ENTRY("www-authenticate", "", HTTP_HEADER_WWW_AUTHENTICATE)
+};
+
+//first static index with the name of a well-known header, 0 if the static table does not have it
+constexpr uint8_t static_index_by_id[] = {
+  [HTTP_HEADER_ACCEPT] = 19,
+  [HTTP_HEADER_ACCEPT_CHARSET] = 15,
+  [HTTP_HEADER_ACCEPT_ENCODING] = 16,
+  [HTTP_HEADER_ACCEPT_LANGUAGE] = 17,
+  [HTTP_HEADER_ACCEPT_RANGES] = 18,
+  [HTTP_HEADER_ACCESS_CONTROL_ALLOW_ORIGIN] = 20,
+  [HTTP_HEADER_AGE] = 21,
+  [HTTP_HEADER_ALLOW] = 22,
+  [HTTP_HEADER_AUTHORIZATION] = 23,
+  [HTTP_HEADER_CACHE_CONTROL] = 24,
+  [HTTP_HEADER_CONTENT_DISPOSITION] = 25,
+  [HTTP_HEADER_CONTENT_ENCODING] = 26,
+  [HTTP_HEADER_CONTENT_LANGUAGE] = 27,
+  [HTTP_HEADER_CONTENT_LENGTH] = 28,
+  [HTTP_HEADER_CONTENT_LOCATION] = 29,
+  [HTTP_HEADER_CONTENT_RANGE] = 30,
+  [HTTP_HEADER_CONTENT_TYPE] = 31,
+  [HTTP_HEADER_COOKIE] = 32,
+  [HTTP_HEADER_DATE] = 33,
+  [HTTP_HEADER_ETAG] = 34,
+  [HTTP_HEADER_EXPECT] = 35,
+  [HTTP_HEADER_EXPIRES] = 36,
+  [HTTP_HEADER_HOST] = 38,
+  [HTTP_HEADER_IF_MATCH] = 39,
+  [HTTP_HEADER_IF_MODIFIED_SINCE] = 40,
+  [HTTP_HEADER_IF_NONE_MATCH] = 41,
+  [HTTP_HEADER_IF_RANGE] = 42,
+  [HTTP_HEADER_IF_UNMODIFIED_SINCE] = 43,
+  [HTTP_HEADER_LAST_MODIFIED] = 44,
+  [HTTP_HEADER_LINK] = 45,
+  [HTTP_HEADER_LOCATION] = 46,
+  [HTTP_HEADER_PROXY_AUTHENTICATE] = 48,
+  [HTTP_HEADER_PROXY_AUTHORIZATION] = 49,
+  [HTTP_HEADER_RANGE] = 50,
+  [HTTP_HEADER_REFERER] = 51,
+  [HTTP_HEADER_RETRY_AFTER] = 53,
+  [HTTP_HEADER_SERVER] = 54,
+  [HTTP_HEADER_SET_COOKIE] = 55,
+  [HTTP_HEADER_STRICT_TRANSPORT_SECURITY] = 56,
+  [HTTP_HEADER_TRANSFER_ENCODING] = 57,
+  [HTTP_HEADER_USER_AGENT] = 58,
+  [HTTP_HEADER_VARY] = 59,
+  [HTTP_HEADER_VIA] = 60,
+  [HTTP_HEADER_WWW_AUTHENTICATE] = 61,
+  [HTTP_HEADER_X_FORWARDED_FOR] = 0
+};
+
+//RFC 7541 Appendix B, the last one is EOS
+constexpr uint32_t huffman_codes[257] = {
+  0x1ff8, 0x7fffd8, 0xfffffe2, 0xfffffe3, 0xfffffe4, 0xfffffe5, 0xfffffe6, 0xfffffe7,
+  0xfffffe8, 0xffffea, 0x3ffffffc, 0xfffffe9, 0xfffffea, 0x3ffffffd, 0xfffffeb, 0xfffffec,
+  0xfffffed, 0xfffffee, 0xfffffef, 0xffffff0, 0xffffff1, 0xffffff2, 0x3ffffffe, 0xffffff3,
+  0xffffff4, 0xffffff5, 0xffffff6, 0xffffff7, 0xffffff8, 0xffffff9, 0xffffffa, 0xffffffb,
+  0x14, 0x3f8, 0x3f9, 0xffa, 0x1ff9, 0x15, 0xf8, 0x7fa,
+  0x3fa, 0x3fb, 0xf9, 0x7fb, 0xfa, 0x16, 0x17, 0x18,
+  0x0, 0x1, 0x2, 0x19, 0x1a, 0x1b, 0x1c, 0x1d,
+  0x1e, 0x1f, 0x5c, 0xfb, 0x7ffc, 0x20, 0xffb, 0x3fc,
+  0x1ffa, 0x21, 0x5d, 0x5e, 0x5f, 0x60, 0x61, 0x62,
+  0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a,
+  0x6b, 0x6c, 0x6d, 0x6e, 0x6f, 0x70, 0x71, 0x72,
+  0xfc, 0x73, 0xfd, 0x1ffb, 0x7fff0, 0x1ffc, 0x3ffc, 0x22,
+  0x7ffd, 0x3, 0x23, 0x4, 0x24, 0x5, 0x25, 0x26,
+  0x27, 0x6, 0x74, 0x75, 0x28, 0x29, 0x2a, 0x7,
+  0x2b, 0x76, 0x2c, 0x8, 0x9, 0x2d, 0x77, 0x78,
+  0x79, 0x7a, 0x7b, 0x7ffe, 0x7fc, 0x3ffd, 0x1ffd, 0xffffffc,
+  0xfffe6, 0x3fffd2, 0xfffe7, 0xfffe8, 0x3fffd3, 0x3fffd4, 0x3fffd5, 0x7fffd9,
+  0x3fffd6, 0x7fffda, 0x7fffdb, 0x7fffdc, 0x7fffdd, 0x7fffde, 0xffffeb, 0x7fffdf,
+  0xffffec, 0xffffed, 0x3fffd7, 0x7fffe0, 0xffffee, 0x7fffe1, 0x7fffe2, 0x7fffe3,
+  0x7fffe4, 0x1fffdc, 0x3fffd8, 0x7fffe5, 0x3fffd9, 0x7fffe6, 0x7fffe7, 0xffffef,
+  0x3fffda, 0x1fffdd, 0xfffe9, 0x3fffdb, 0x3fffdc, 0x7fffe8, 0x7fffe9, 0x1fffde,
+  0x7fffea, 0x3fffdd, 0x3fffde, 0xfffff0, 0x1fffdf, 0x3fffdf, 0x7fffeb, 0x7fffec,
+  0x1fffe0, 0x1fffe1, 0x3fffe0, 0x1fffe2, 0x7fffed, 0x3fffe1, 0x7fffee, 0x7fffef,
+  0xfffea, 0x3fffe2, 0x3fffe3, 0x3fffe4, 0x7ffff0, 0x3fffe5, 0x3fffe6, 0x7ffff1,
+  0x3ffffe0, 0x3ffffe1, 0xfffeb, 0x7fff1, 0x3fffe7, 0x7ffff2, 0x3fffe8, 0x1ffffec,
+  0x3ffffe2, 0x3ffffe3, 0x3ffffe4, 0x7ffffde, 0x7ffffdf, 0x3ffffe5, 0xfffff1, 0x1ffffed,
+  0x7fff2, 0x1fffe3, 0x3ffffe6, 0x7ffffe0, 0x7ffffe1, 0x3ffffe7, 0x7ffffe2, 0xfffff2,
+  0x1fffe4, 0x1fffe5, 0x3ffffe8, 0x3ffffe9, 0xffffffd, 0x7ffffe3, 0x7ffffe4, 0x7ffffe5,
+  0xfffec, 0xfffff3, 0xfffed, 0x1fffe6, 0x3fffe9, 0x1fffe7, 0x1fffe8, 0x7ffff3,
+  0x3fffea, 0x3fffeb, 0x1ffffee, 0x1ffffef, 0xfffff4, 0xfffff5, 0x3ffffea, 0x7ffff4,
+  0x3ffffeb, 0x7ffffe6, 0x3ffffec, 0x3ffffed, 0x7ffffe7, 0x7ffffe8, 0x7ffffe9, 0x7ffffea,
+  0x7ffffeb, 0xffffffe, 0x7ffffec, 0x7ffffed, 0x7ffffee, 0x7ffffef, 0x7fffff0, 0x3ffffee,
+  0x3fffffff
+};
+
+constexpr uint8_t huffman_lens[257] = {
+  13, 23, 28, 28, 28, 28, 28, 28, 28, 24, 30, 28, 28, 30, 28, 28,
+  28, 28, 28, 28, 28, 28, 30, 28, 28, 28, 28, 28, 28, 28, 28, 28,
+  6, 10, 10, 12, 13, 6, 8, 11, 10, 10, 8, 11, 8, 6, 6, 6,
+  5, 5, 5, 6, 6, 6, 6, 6, 6, 6, 7, 8, 15, 6, 12, 10,
+  13, 6, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7, 7,
+  7, 7, 7, 7, 7, 7, 7, 7, 8, 7, 8, 13, 19, 13, 14, 6,
+  15, 5, 6, 5, 6, 5, 6, 6, 6, 5, 7, 7, 6, 6, 6, 5,
+  6, 7, 6, 5, 5, 6, 7, 7, 7, 7, 7, 15, 11, 14, 13, 28,
+  20, 22, 20, 20, 22, 22, 22, 23, 22, 23, 23, 23, 23, 23, 24, 23,
+  24, 24, 22, 23, 24, 23, 23, 23, 23, 21, 22, 23, 22, 23, 23, 24,
+  22, 21, 20, 22, 22, 23, 23, 21, 23, 22, 22, 24, 21, 22, 23, 23,
+  21, 21, 22, 21, 23, 22, 23, 23, 20, 22, 22, 22, 23, 22, 22, 23,
+  26, 26, 20, 19, 22, 23, 22, 25, 26, 26, 26, 27, 27, 26, 24, 25,
+  19, 21, 26, 27, 27, 26, 27, 24, 21, 21, 26, 26, 28, 27, 27, 27,
+  20, 24, 20, 21, 22, 21, 21, 23, 22, 22, 25, 25, 24, 24, 26, 23,
+  26, 27, 26, 26, 27, 27, 27, 27, 27, 28, 27, 27, 27, 27, 27, 26,
+  30
+};
+
+static huffman_transition_t huffman_transitions[256][16];
+
+static uint32_t encode_header(http_hpack_table_t *const restrict table, char *restrict buffer, const http_header_t *restrict header);
+static uint32_t huffman_encoded_len(const char *restrict str, const uint16_t len, const bool lowercase);
+static void huffman_encode(char *restrict buffer, const char *restrict str, const uint16_t len, const bool lowercase);
+static bool huffman_decode(const char *restrict src, const uint32_t src_len, char **const restrict str, uint16_t *const restrict len, scratch_t *const restrict scratch);
+static bool lookup(const http_hpack_table_t *const restrict table, const uint32_t index, http_header_t *const restrict header, const bool name_only, scratch_t *const restrict scratch);
+static uint8_t find_static(const http_header_id_t id, const char *const name, const uint16_t name_len, const char *const value, const uint16_t value_len, uint8_t *const restrict name_index);
+static void ring_write(http_hpack_table_t *const restrict table, const char *restrict src, const uint32_t len, const bool lowercase);
+static bool ring_equals(const http_hpack_table_t *const restrict table, const uint32_t offset, const char *restrict str, const uint32_t len, const bool caseless);
+static inline void copy_lowercase(char *restrict dst, const char *restrict src, const uint32_t len);
+
+//walks the code tree 4 bits at a time from every internal node, so decoding never looks at single bits
+CONSTRUCTOR void http_hpack_init(void)
+{
+  int16_t children[256][2] = {0};
+  bool accepting[256] = {0};
+  uint16_t nodes_count = 1;
+
+  for (uint16_t symbol = 0; symbol <= HUFFMAN_EOS; symbol++)
+  {
+    const uint32_t code = huffman_codes[symbol];
+    uint16_t node = 0;
+
+    for (uint8_t bit = huffman_lens[symbol] - 1; bit > 0; bit--)
+    {
+      int16_t *const child = &children[node][(code >> bit) & 1];
+      if (*child == 0)
+        *child = nodes_count++;
+      node = *child;
+    }
+    children[node][code & 1] = -(symbol + 1);
+  }
+
+  //padding is at most 7 bits, all ones: a prefix of EOS
+  uint16_t node = 0;
+  accepting[node] = true;
+  for (uint8_t depth = 0; depth < 7; depth++)
+  {
+    node = children[node][1];
+    accepting[node] = true;
+  }
+
+  for (uint16_t state = 0; state < nodes_count; state++)
+  {
+    for (uint8_t nibble = 0; nibble < 16; nibble++)
+    {
+      huffman_transition_t transition = {0};
+      node = state;
+
+      for (int8_t bit = 3; bit >= 0; bit--)
+      {
+        const int16_t child = children[node][(nibble >> bit) & 1];
+        if (child > 0)
+        {
+          node = child;
+          continue;
+        }
+
+        const uint16_t symbol = -child - 1;
+        transition.flags |= (symbol == HUFFMAN_EOS) ? HUFFMAN_FAIL : HUFFMAN_EMIT;
+        transition.symbol = symbol;
+        node = 0;
+      }
+
+      transition.state = node;
+      transition.flags |= accepting[node] * HUFFMAN_ACCEPT;
+      huffman_transitions[state][nibble] = transition;
+    }
+  }
+}
+
+void http_hpack_table_init(http_hpack_table_t *const restrict table, void *const memory, const uint32_t size)
+{
+  const uint16_t entries_capacity = size / HTTP_HPACK_ENTRY_OVERHEAD;
+
+  *table = (http_hpack_table_t){
+    .entries = memory,
+    .data = (char *)memory + entries_capacity * sizeof(http_hpack_entry_t),
+    .capacity = size,
+    .max_size = size,
+    .entries_capacity = entries_capacity
+  };
+}
+
+uint32_t http_hpack_encode(http_hpack_table_t *const restrict table, char *restrict buffer, const http_header_t *restrict headers, const uint16_t headers_count)
+{
+  const char *const buffer_start = buffer;
+
+  for (uint16_t i = 0; LIKELY(i < headers_count); i++)
+    buffer += encode_header(table, buffer, &headers[i]);
+
+  return buffer - buffer_start;
+}
+
+//must start a header block, the peer applies it before the headers that follow
+uint8_t http_hpack_encode_table_size(http_hpack_table_t *const restrict table, char *restrict buffer, const uint32_t size)
+{
+  if (UNLIKELY(size > table->capacity))
+    return 0;
+
+  table->max_size = size;
+  hpack_table_evict(table, size);
+
+  return hpack_encode_integer(buffer, size, 5, 0x20);
+}
+
+//literals that are not huffman encoded are left in the block, everything else is written to scratch
+bool http_hpack_decode(http_hpack_table_t *const restrict table, char *restrict block, const uint32_t block_len, http_header_t *restrict headers, uint16_t *const restrict headers_count, char *restrict scratch, const uint32_t scratch_size)
+{
+  const char *cursor = block;
+  const char *const end = block + block_len;
+  scratch_t scratch_space = { scratch, scratch + scratch_size };
+  const uint16_t max_headers = *headers_count;
+  uint16_t count = 0;
+
+  while (LIKELY(cursor < end))
+  {
+    const uint8_t byte = *cursor;
+    uint32_t index;
+
+    if ((byte & 0xE0) == 0x20)
+    {
+      const bool valid = hpack_decode_integer(&cursor, end, 5, &index) && (count == 0) && (index <= table->capacity);
+      if (UNLIKELY(!valid))
+        return false;
+
+      table->max_size = index;
+      hpack_table_evict(table, index);
+      continue;
+    }
+
+    if (UNLIKELY(count == max_headers))
+      return false;
+    http_header_t *const header = &headers[count++];
+
+    if (byte & 0x80)
+    {
+      const bool valid = hpack_decode_integer(&cursor, end, 7, &index) && lookup(table, index, header, false, &scratch_space);
+      if (UNLIKELY(!valid))
+        return false;
+      continue;
+    }
+
+    const bool indexing = byte & 0x40;
+    if (UNLIKELY(!hpack_decode_integer(&cursor, end, indexing ? 6 : 4, &index)))
+      return false;
+
+    *header = (http_header_t){ .id = HTTP_HEADER_UNKNOWN };
+    bool valid = (index != 0) ? lookup(table, index, header, true, &scratch_space) : hpack_decode_string(&cursor, end, 7, &header->key, &header->key_len, &scratch_space);
+    valid = valid && hpack_decode_string(&cursor, end, 7, &header->value, &header->value_len, &scratch_space);
+    if (UNLIKELY(!valid))
+      return false;
+    if (index == 0)
+      header->id = lookup_header_id(header->key, header->key_len);
+
+    if (indexing)
+      hpack_table_insert(table, header->key, header->key_len, header->value, header->value_len, header->id, false);
+  }
+
+  *headers_count = count;
+  return true;
+}
+
+//fully indexed when possible, otherwise a literal added to the dynamic table whenever it fits, except for credentials
+static uint32_t encode_header(http_hpack_table_t *const restrict table, char *restrict buffer, const http_header_t *restrict header)
+{
+  const char *const buffer_start = buffer;
+  const http_header_id_t id = known_id(header->id);
+
+  const char *name = header->key;
+  uint16_t name_len = header->key_len;
+  if (LIKELY(id != HTTP_HEADER_UNKNOWN))
+  {
+    name = header_names_str[id];
+    name_len = header_names_len[id] - STR_LEN(": ");
+  }
+
+  uint8_t static_name_index;
+  const uint8_t static_index = find_static(id, name, name_len, header->value, header->value_len, &static_name_index);
+  if (static_index != 0)
+    return hpack_encode_integer(buffer, static_index, 7, 0x80);
+
+  uint16_t dynamic_name_index;
+  const uint16_t dynamic_index = hpack_find_dynamic(table, name, name_len, header->value, header->value_len, &dynamic_name_index);
+  if (dynamic_index != 0)
+    return hpack_encode_integer(buffer, STATIC_TABLE_SIZE + dynamic_index, 7, 0x80);
+
+  uint32_t name_index = static_name_index;
+  if ((name_index == 0) & (dynamic_name_index != 0))
+    name_index = STATIC_TABLE_SIZE + dynamic_name_index;
+
+  const bool never_indexed = hpack_never_indexed(id);
+  const bool indexing = !never_indexed & ((uint32_t)(name_len + header->value_len + HTTP_HPACK_ENTRY_OVERHEAD) <= table->max_size);
+  if (indexing)
+    buffer += hpack_encode_integer(buffer, name_index, 6, 0x40);
+  else
+    buffer += hpack_encode_integer(buffer, name_index, 4, never_indexed ? 0x10 : 0x00);
+
+  if (name_index == 0)
+    buffer += hpack_encode_string(buffer, name, name_len, true, 7, 0x00);
+  buffer += hpack_encode_string(buffer, header->value, header->value_len, false, 7, 0x00);
+
+  if (indexing)
+    hpack_table_insert(table, name, name_len, header->value, header->value_len, id, true);
+
+  return buffer - buffer_start;
+}
+
+uint8_t hpack_encode_integer(char *restrict buffer, uint32_t value, const uint8_t prefix_bits, const uint8_t pattern)
+{
+  const uint8_t max_prefix = (1 << prefix_bits) - 1;
+
+  if (LIKELY(value < max_prefix))
+  {
+    *buffer = pattern | value;
+    return 1;
+  }
+
+  const char *const buffer_start = buffer;
+
+  *buffer++ = pattern | max_prefix;
+  value -= max_prefix;
+  while (value >= 0x80)
+  {
+    *buffer++ = (value & 0x7F) | 0x80;
+    value >>= 7;
+  }
+  *buffer++ = value;
+
+  return buffer - buffer_start;
+}
+
+//huffman is used only when it is shorter, names are lowercased as HTTP/2 requires. The H bit sits right above the prefix
+uint32_t hpack_encode_string(char *restrict buffer, const char *restrict str, const uint16_t len, const bool lowercase, const uint8_t prefix_bits, const uint8_t pattern)
+{
+  const char *const buffer_start = buffer;
+  const uint32_t huffman_len = huffman_encoded_len(str, len, lowercase);
+
+  if (huffman_len < len)
+  {
+    buffer += hpack_encode_integer(buffer, huffman_len, prefix_bits, pattern | (1 << prefix_bits));
+    huffman_encode(buffer, str, len, lowercase);
+    buffer += huffman_len;
+  }
+  else
+  {
+    buffer += hpack_encode_integer(buffer, len, prefix_bits, pattern);
+    if (lowercase)
+      copy_lowercase(buffer, str, len);
+    else
+      memcpy(buffer, str, len);
+    buffer += len;
+  }
+
+  return buffer - buffer_start;
+}
+
+static uint32_t huffman_encoded_len(const char *restrict str, const uint16_t len, const bool lowercase)
+{
+  uint32_t bits = 0;
+
+  for (uint16_t i = 0; LIKELY(i < len); i++)
+  {
+    uint8_t symbol = str[i];
+    symbol |= (lowercase & ((uint8_t)(symbol - 'A') < 26)) << 5;
+    bits += huffman_lens[symbol];
+  }
+
+  return (bits + 7) >> 3;
+}
+
+static void huffman_encode(char *restrict buffer, const char *restrict str, const uint16_t len, const bool lowercase)
+{
+  uint64_t bits = 0;
+  uint8_t pending = 0;
+
+  for (uint16_t i = 0; LIKELY(i < len); i++)
+  {
+    uint8_t symbol = str[i];
+    symbol |= (lowercase & ((uint8_t)(symbol - 'A') < 26)) << 5;
+
+    bits = (bits << huffman_lens[symbol]) | huffman_codes[symbol];
+    pending += huffman_lens[symbol];
+    while (pending >= 8)
+    {
+      pending -= 8;
+      *buffer++ = bits >> pending;
+    }
+  }
+
+  if (pending)
+    *buffer = (bits << (8 - pending)) | (0xFF >> pending);
+}
+
+bool hpack_decode_integer(const char **const restrict cursor, const char *const end, const uint8_t prefix_bits, uint32_t *const restrict value)
+{
+  const char *str = *cursor;
+  if (UNLIKELY(str == end))
+    return false;
+
+  const uint8_t max_prefix = (1 << prefix_bits) - 1;
+  uint32_t result = (uint8_t)*str++ & max_prefix;
+
+  if (UNLIKELY(result == max_prefix))
+  {
+    uint8_t shift = 0;
+    uint8_t byte;
+    do
+    {
+      //4 continuation bytes are enough for anything that fits the structs
+      if (UNLIKELY((str == end) | (shift > 21)))
+        return false;
+      byte = *str++;
+      result += (uint32_t)(byte & 0x7F) << shift;
+      shift += 7;
+    }
+    while (byte & 0x80);
+  }
+
+  *cursor = str;
+  *value = result;
+  return true;
+}
+
+bool hpack_decode_string(const char **const restrict cursor, const char *const end, const uint8_t prefix_bits, char **const restrict str, uint16_t *const restrict len, scratch_t *const restrict scratch)
+{
+  if (UNLIKELY(*cursor == end))
+    return false;
+
+  const bool huffman = **cursor & (1 << prefix_bits);
+  uint32_t length;
+  if (UNLIKELY(!hpack_decode_integer(cursor, end, prefix_bits, &length) || (length > (uint32_t)(end - *cursor))))
+    return false;
+
+  const char *const src = *cursor;
+  *cursor += length;
+
+  if (huffman)
+    return huffman_decode(src, length, str, len, scratch);
+
+  *str = (char *)src;
+  *len = length;
+  return length <= UINT16_MAX;
+}
+
+static bool huffman_decode(const char *restrict src, const uint32_t src_len, char **const restrict str, uint16_t *const restrict len, scratch_t *const restrict scratch)
+{
+  char *const out_start = scratch->cursor;
+  char *out = out_start;
+  uint8_t state = 0;
+  uint8_t flags = HUFFMAN_ACCEPT;
+
+  for (uint32_t i = 0; LIKELY(i < src_len); i++)
+  {
+    const uint8_t byte = src[i];
+    const uint8_t nibbles[2] = { byte >> 4, byte & 0x0F };
+
+    for (uint8_t j = 0; j < 2; j++)
+    {
+      const huffman_transition_t transition = huffman_transitions[state][nibbles[j]];
+      if (UNLIKELY(transition.flags & HUFFMAN_FAIL))
+        return false;
+      if (transition.flags & HUFFMAN_EMIT)
+      {
+        if (UNLIKELY(out == scratch->end))
+          return false;
+        *out++ = transition.symbol;
+      }
+      state = transition.state;
+      flags = transition.flags;
+    }
+  }
+
+  const uint32_t out_len = out - out_start;
+  if (UNLIKELY(!(flags & HUFFMAN_ACCEPT) | (out_len > UINT16_MAX)))
+    return false;
+
+  scratch->cursor = out;
+  *str = out_start;
+  *len = out_len;
+  return true;
+}
+
+//dynamic entries are copied out: a later header of the same block may evict them
+static bool lookup(const http_hpack_table_t *const restrict table, const uint32_t index, http_header_t *const restrict header, const bool name_only, scratch_t *const restrict scratch)
+{
+  if (LIKELY((index - 1) < STATIC_TABLE_SIZE))
+  {
+    const static_entry_t *const entry = &static_table[index];
+    header->key = (char *)entry->name;
+    header->key_len = entry->name_len;
+    header->id = entry->id;
+    if (!name_only)
+    {
+      header->value = (char *)entry->value;
+      header->value_len = entry->value_len;
+    }
+    return true;
+  }
+
+  const uint32_t dynamic_index = index - STATIC_TABLE_SIZE;
+  if (UNLIKELY((index == 0) | (dynamic_index > table->count)))
+    return false;
+
+  const http_hpack_entry_t entry = *hpack_table_entry(table, dynamic_index);
+  const uint32_t len = entry.name_len + (!name_only * entry.value_len);
+  if (UNLIKELY(len > (uint32_t)(scratch->end - scratch->cursor)))
+    return false;
+
+  char *const copy = scratch->cursor;
+  hpack_ring_read(table, copy, entry.offset, len);
+  scratch->cursor += len;
+
+  header->key = copy;
+  header->key_len = entry.name_len;
+  header->id = entry.id;
+  if (!name_only)
+  {
+    header->value = copy + entry.name_len;
+    header->value_len = entry.value_len;
+  }
+  return true;
+}
+
+//entries sharing a name are adjacent in the static table, so the value is only searched among them
+static uint8_t find_static(const http_header_id_t id, const char *const name, const uint16_t name_len, const char *const value, const uint16_t value_len, uint8_t *const restrict name_index)
+{
+  uint8_t first = static_index_by_id[id];
+
+  if (id == HTTP_HEADER_UNKNOWN)
+  {
+    for (uint8_t i = 1; i <= STATIC_TABLE_SIZE; i++)
+    {
+      if (equals_caseless(name, name_len, static_table[i].name, static_table[i].name_len))
+      {
+        first = i;
+        break;
+      }
+    }
+  }
+
+  *name_index = first;
+  if (first == 0)
+    return 0;
+
+  const static_entry_t *const named = &static_table[first];
+  for (uint8_t i = first; (i <= STATIC_TABLE_SIZE) && (static_table[i].name_len == named->name_len) && (memcmp(static_table[i].name, named->name, named->name_len) == 0); i++)
+  {
+    const static_entry_t *const entry = &static_table[i];
+    if ((entry->value_len == value_len) && (memcmp(entry->value, value, value_len) == 0))
+      return i;
+  }
+
+  return 0;
+}
+
+//newest entries first, they are the most likely to be repeated
+uint16_t hpack_find_dynamic(const http_hpack_table_t *const restrict table, const char *const name, const uint16_t name_len, const char *const value, const uint16_t value_len, uint16_t *const restrict name_index)
+{
+  *name_index = 0;
+
+  for (uint16_t i = 1; LIKELY(i <= table->count); i++)
+  {
+    const http_hpack_entry_t *const entry = hpack_table_entry(table, i);
+    if ((entry->name_len != name_len) || !ring_equals(table, entry->offset, name, name_len, true))
+      continue;
+
+    if (*name_index == 0)
+      *name_index = i;
+    if ((entry->value_len == value_len) && ring_equals(table, entry->offset + name_len, value, value_len, false))
+      return i;
+  }
+
+  return 0;
+}
+
+//an entry bigger than the whole table empties it without being added
+void hpack_table_insert(http_hpack_table_t *const restrict table, const char *const name, const uint16_t name_len, const char *const value, const uint16_t value_len, const http_header_id_t id, const bool lowercase)
+{
+  const uint32_t entry_size = name_len + value_len + HTTP_HPACK_ENTRY_OVERHEAD;
+  if (UNLIKELY(entry_size > table->max_size))
+  {
+    hpack_table_evict(table, 0);
+    return;
+  }
+
+  hpack_table_evict(table, table->max_size - entry_size);
+
+  uint32_t slot = table->first + table->count;
+  slot -= (slot >= table->entries_capacity) * table->entries_capacity;
+  table->entries[slot] = (http_hpack_entry_t){
+    .offset = table->head,
+    .name_len = name_len,
+    .value_len = value_len,
+    .id = id
+  };
+
+  ring_write(table, name, name_len, lowercase);
+  ring_write(table, value, value_len, false);
+  table->count++;
+  table->size += entry_size;
+}
+
+void hpack_table_evict(http_hpack_table_t *const restrict table, const uint32_t limit)
+{
+  while (table->size > limit)
+  {
+    const http_hpack_entry_t *const entry = &table->entries[table->first];
+    table->size -= entry->name_len + entry->value_len + HTTP_HPACK_ENTRY_OVERHEAD;
+    table->first++;
+    table->first *= (table->first != table->entries_capacity);
+    table->count--;
+  }
+}
+
+//index 1 is the newest entry
+const http_hpack_entry_t *hpack_table_entry(const http_hpack_table_t *const restrict table, const uint16_t index)
+{
+  uint32_t slot = table->first + table->count - index;
+  slot -= (slot >= table->entries_capacity) * table->entries_capacity;
+
+  return &table->entries[slot];
+}
+
+//credentials stay out of the tables, and intermediaries are told to keep them out too (RFC 7541 section 7.1.3)
+bool hpack_never_indexed(const http_header_id_t id)
+{
+  return (id == HTTP_HEADER_AUTHORIZATION) | (id == HTTP_HEADER_PROXY_AUTHORIZATION) | (id == HTTP_HEADER_COOKIE) | (id == HTTP_HEADER_SET_COOKIE);
+}
+
+static void ring_write(http_hpack_table_t *const restrict table, const char *restrict src, const uint32_t len, const bool lowercase)
+{
+  const uint32_t tail_len = table->capacity - table->head;
+  const uint32_t first_len = (len < tail_len) ? len : tail_len;
+
+  if (lowercase)
+  {
+    copy_lowercase(table->data + table->head, src, first_len);
+    copy_lowercase(table->data, src + first_len, len - first_len);
+  }
+  else
+  {
+    memcpy(table->data + table->head, src, first_len);
+    memcpy(table->data, src + first_len, len - first_len);
+  }
+
+  table->head += len;
+  table->head -= (table->head >= table->capacity) * table->capacity;
+}
+
+void hpack_ring_read(const http_hpack_table_t *const restrict table, char *restrict dst, const uint32_t offset, const uint32_t len)
+{
+  const uint32_t start = offset - (offset >= table->capacity) * table->capacity;
+  const uint32_t tail_len = table->capacity - start;
+  const uint32_t first_len = (len < tail_len) ? len : tail_len;
+
+  memcpy(dst, table->data + start, first_len);
+  memcpy(dst + first_len, table->data, len - first_len);
+}
+
+static bool ring_equals(const http_hpack_table_t *const restrict table, const uint32_t offset, const char *restrict str, const uint32_t len, const bool caseless)
+{
+  const uint32_t start = offset - (offset >= table->capacity) * table->capacity;
+  const uint32_t tail_len = table->capacity - start;
+  const uint32_t first_len = (len < tail_len) ? len : tail_len;
+  const uint32_t second_len = len - first_len;
+
+  if (caseless)
+    return equals_caseless(table->data + start, first_len, str, first_len) && equals_caseless(table->data, second_len, str + first_len, second_len);
+
+  return (memcmp(table->data + start, str, first_len) == 0) && (memcmp(table->data, str + first_len, second_len) == 0);
+}
+
+static inline void copy_lowercase(char *restrict dst, const char *restrict src, const uint32_t len)
+{
+  for (uint32_t i = 0; LIKELY(i < len); i++)
+  {
+    const uint8_t c = src[i];
+    dst[i] = c | (((uint8_t)(c - 'A') < 26) << 5);
+  }
+}
@@ -0,0 +1,55 @@
+/*================================================================================
+
+File: hpack_internal.h                                                          
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-03-15 13:09:52                                                 
+last edited: 2025-03-15 13:09:52                                                
+
+================================================================================*/
+
+#ifndef HPACK_INTERNAL_H
+# define HPACK_INTERNAL_H
+
+# include <stdint.h>
+
+# include "extensions.h"
+# include "structs.h"
+# include "hpack.h"
+# include "qpack.h"
+
+//bytes handed out for the strings that cannot point into the block
+typedef struct
+{
+  char *cursor;
+  const char *end;
+} scratch_t;
+
+//a QPACK field section being encoded, its lines are written after room for the prefix
+typedef struct
+{
+  char *buffer;
+  char *cursor;
+  char *instructions;
+  const char *instructions_start;
+  uint32_t base;
+  uint32_t min_index;
+  uint32_t required_insert_count;
+} qpack_section_t;
+
+INTERNAL uint8_t hpack_encode_integer(char *restrict buffer, uint32_t value, const uint8_t prefix_bits, const uint8_t pattern);
+INTERNAL uint32_t hpack_encode_string(char *restrict buffer, const char *restrict str, const uint16_t len, const bool lowercase, const uint8_t prefix_bits, const uint8_t pattern);
+INTERNAL bool hpack_decode_integer(const char **const restrict cursor, const char *const end, const uint8_t prefix_bits, uint32_t *const restrict value);
+INTERNAL bool hpack_decode_string(const char **const restrict cursor, const char *const end, const uint8_t prefix_bits, char **const restrict str, uint16_t *const restrict len, scratch_t *const restrict scratch);
+INTERNAL uint16_t hpack_find_dynamic(const http_hpack_table_t *const restrict table, const char *const name, const uint16_t name_len, const char *const value, const uint16_t value_len, uint16_t *const restrict name_index);
+INTERNAL void hpack_table_insert(http_hpack_table_t *const restrict table, const char *const name, const uint16_t name_len, const char *const value, const uint16_t value_len, const http_header_id_t id, const bool lowercase);
+INTERNAL void hpack_table_evict(http_hpack_table_t *const restrict table, const uint32_t limit);
+INTERNAL const http_hpack_entry_t *hpack_table_entry(const http_hpack_table_t *const restrict table, const uint16_t index);
+INTERNAL bool hpack_never_indexed(const http_header_id_t id);
+INTERNAL void qpack_section_begin(http_qpack_encoder_t *const restrict encoder, qpack_section_t *const restrict section, char *restrict buffer, char *restrict encoder_stream);
+INTERNAL void qpack_section_encode(http_qpack_encoder_t *const restrict encoder, qpack_section_t *const restrict section, const http_header_t *restrict header);
+INTERNAL uint32_t qpack_section_end(http_qpack_encoder_t *const restrict encoder, qpack_section_t *const restrict section, const uint32_t stream_id, uint32_t *const restrict encoder_stream_len);
+INTERNAL void hpack_ring_read(const http_hpack_table_t *const restrict table, char *restrict dst, const uint32_t offset, const uint32_t len);
+
+#endif
@@ -0,0 +1,836 @@
+/*================================================================================
+
+File: http2.c                                                                   
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-03-12 18:03:51                                                 
+last edited: 2025-03-15 13:46:12                                                
+
+================================================================================*/
+
+#include <string.h>
+#include <sys/uio.h>
+
+#include "common.h"
+#include "http2.h"
+#include "serializer.h"
+#include "deserializer.h"
+
+# define SETTINGS_COUNT 6
+# define SETTING_SIZE (sizeof(uint16_t) + sizeof(uint32_t))
+# define PRIORITY_SIZE 5
+# define PING_SIZE 8
+# define STREAM_ID_MASK 0x7FFFFFFF
+//one frame header per body chunk, each followed by the iovec of the chunk itself
+# define DATA_FRAMES_PER_WRITE ((IOV_MAX - 1) / 2)
+//:method, :scheme, :path and :authority, with the worst case integer and string prefixes of each
+# define REQUEST_PSEUDO_BOUND (STR_LEN(":method") + STR_LEN("OPTIONS") + STR_LEN(":scheme") + STR_LEN("https") + STR_LEN(":path") + STR_LEN(":authority") + 4 * 12)
+# define RESPONSE_PSEUDO_BOUND (STR_LEN(":status") + 3 + 12)
+
+# define PSEUDO(name, value, value_len) ((http_header_t){ (char *)(name), (char *)(value), STR_LEN(name), (value_len), HTTP_HEADER_UNKNOWN })
+
+//identifiers of the SETTINGS parameters, in the order of http2_settings_t
+typedef enum: uint16_t {
+  SETTINGS_HEADER_TABLE_SIZE = 1,
+  SETTINGS_ENABLE_PUSH,
+  SETTINGS_MAX_CONCURRENT_STREAMS,
+  SETTINGS_INITIAL_WINDOW_SIZE,
+  SETTINGS_MAX_FRAME_SIZE,
+  SETTINGS_MAX_HEADER_LIST_SIZE
+} setting_t;
+
+typedef enum: uint8_t {
+  PSEUDO_METHOD,
+  PSEUDO_SCHEME,
+  PSEUDO_PATH,
+  PSEUDO_AUTHORITY,
+  PSEUDO_STATUS
+} pseudo_t;
+
+constexpr char pseudo_str[][16] = {
+  [PSEUDO_METHOD] = ":method",
+  [PSEUDO_SCHEME] = ":scheme",
+  [PSEUDO_PATH] = ":path",
+  [PSEUDO_AUTHORITY] = ":authority",
+  [PSEUDO_STATUS] = ":status"
+};
+constexpr uint8_t pseudo_len[] = {
+  [PSEUDO_METHOD] = STR_LEN(":method"),
+  [PSEUDO_SCHEME] = STR_LEN(":scheme"),
+  [PSEUDO_PATH] = STR_LEN(":path"),
+  [PSEUDO_AUTHORITY] = STR_LEN(":authority"),
+  [PSEUDO_STATUS] = STR_LEN(":status")
+};
+
+//headers that only make sense on a single HTTP/1 connection, RFC 9113 section 8.2.2
+constexpr char connection_specific_str[][24] = {
+  "connection",
+  "keep-alive",
+  "proxy-connection",
+  "transfer-encoding",
+  "upgrade"
+};
+constexpr uint8_t connection_specific_len[] = {
+  STR_LEN("connection"),
+  STR_LEN("keep-alive"),
+  STR_LEN("proxy-connection"),
+  STR_LEN("transfer-encoding"),
+  STR_LEN("upgrade")
+};
+
+static inline uint32_t load_be32(const char *const src);
+static inline void store_be32(char *const dest, const uint32_t value);
+static inline void serialize_frame_header(char *restrict buffer, const uint32_t length, const http2_frame_type_t type, const uint8_t flags, const uint32_t stream_id);
+static uint32_t serialize_header_block(char *buffer, const uint32_t stream_id, const uint32_t block_len, const uint32_t max_frame_size, const uint8_t flags);
+static uint32_t serialize_body(char *restrict buffer, const uint32_t stream_id, const char *restrict body, const uint32_t body_len, const uint32_t max_frame_size);
+static uint32_t serialize_request_head(char *restrict buffer, http_hpack_table_t *const restrict table, const uint32_t stream_id, const http_request_t *restrict request, const uint32_t max_frame_size);
+static uint32_t serialize_response_head(char *restrict buffer, http_hpack_table_t *const restrict table, const uint32_t stream_id, const http_response_t *restrict response, const uint32_t max_frame_size);
+static uint32_t encode_headers(http_hpack_table_t *const restrict table, char *restrict buffer, const http_header_t *restrict headers, const uint16_t headers_count, const bool skip_host);
+static int64_t write_message(const int fd, struct iovec *restrict iov, const char *restrict head, const uint32_t head_len, const uint32_t stream_id, const char *restrict body, const uint32_t body_len, const uint32_t max_frame_size, const uint32_t window, uint32_t *const restrict body_sent);
+static inline uint32_t body_written(const int64_t total_written, const uint32_t head_len, const uint32_t max_frame_size);
+static inline uint32_t head_size(const uint32_t block_bound, const uint32_t max_frame_size);
+static uint32_t headers_bound(const http_header_t *restrict headers, const uint16_t headers_count);
+static bool strip_padding(http2_frame_t *const restrict frame);
+static bool lowercase_name(const http_header_t *restrict header);
+static int8_t find_pseudo(const http_header_t *restrict header);
+static bool deserialize_method(const http_header_t *restrict header, http_method_t *const restrict method);
+static bool deserialize_content_length(const http_header_t *restrict header, uint32_t *const restrict content_length);
+
+uint32_t http2_deserialize_frame(char *restrict buffer, const uint32_t buffer_size, http2_frame_t *const restrict frame, const uint32_t max_frame_size)
+{
+  if (UNLIKELY(buffer_size < HTTP2_FRAME_HEADER_SIZE))
+    return HTTP_NEED_MORE;
+
+  const uint32_t length_type = load_be32(buffer);
+  const uint32_t length = length_type >> 8;
+  if (UNLIKELY(length > max_frame_size))
+    return 0;
+  if (UNLIKELY(buffer_size - HTTP2_FRAME_HEADER_SIZE < length))
+    return HTTP_NEED_MORE;
+
+  *frame = (http2_frame_t){
+    .payload = buffer + HTTP2_FRAME_HEADER_SIZE,
+    .payload_len = length,
+    .stream_id = load_be32(buffer + 5) & STREAM_ID_MASK,
+    .type = length_type & 0xFF,
+    .flags = buffer[4]
+  };
+
+  const bool on_stream = (frame->stream_id != 0);
+  bool valid;
+
+  switch (frame->type)
+  {
+    case HTTP2_DATA:
+      valid = on_stream && strip_padding(frame);
+      break;
+    case HTTP2_HEADERS:
+      valid = on_stream && strip_padding(frame);
+      if (valid && (frame->flags & HTTP2_FLAG_PRIORITY))
+      {
+        valid = (frame->payload_len >= PRIORITY_SIZE);
+        frame->payload += PRIORITY_SIZE;
+        frame->payload_len -= PRIORITY_SIZE;
+      }
+      break;
+    case HTTP2_PRIORITY:
+      valid = on_stream && (length == PRIORITY_SIZE);
+      break;
+    case HTTP2_RST_STREAM:
+      valid = on_stream && (length == sizeof(uint32_t));
+      if (valid)
+        frame->error_code = load_be32(frame->payload);
+      break;
+    case HTTP2_SETTINGS:
+      valid = !on_stream && (length % SETTING_SIZE == 0) && (!(frame->flags & HTTP2_FLAG_ACK) || (length == 0));
+      break;
+    case HTTP2_PUSH_PROMISE:
+      valid = on_stream && strip_padding(frame) && (frame->payload_len >= sizeof(uint32_t));
+      if (valid)
+      {
+        frame->promised_stream_id = load_be32(frame->payload) & STREAM_ID_MASK;
+        frame->payload += sizeof(uint32_t);
+        frame->payload_len -= sizeof(uint32_t);
+      }
+      break;
+    case HTTP2_PING:
+      valid = !on_stream && (length == PING_SIZE);
+      break;
+    case HTTP2_GOAWAY:
+      valid = !on_stream && (length >= 2 * sizeof(uint32_t));
+      if (valid)
+      {
+        frame->last_stream_id = load_be32(frame->payload) & STREAM_ID_MASK;
+        frame->error_code = load_be32(frame->payload + sizeof(uint32_t));
+        frame->payload += 2 * sizeof(uint32_t);
+        frame->payload_len -= 2 * sizeof(uint32_t);
+      }
+      break;
+    case HTTP2_WINDOW_UPDATE:
+      valid = (length == sizeof(uint32_t));
+      if (valid)
+      {
+        frame->window_increment = load_be32(frame->payload) & STREAM_ID_MASK;
+        valid = (frame->window_increment != 0);
+      }
+      break;
+    case HTTP2_CONTINUATION:
+      valid = on_stream;
+      break;
+    default:
+      //unknown frame types must be ignored, the caller skips them
+      valid = true;
+  }
+
+  if (UNLIKELY(!valid))
+    return 0;
+
+  return HTTP2_FRAME_HEADER_SIZE + length;
+}
+
+//applies the parameters of a SETTINGS frame over the current ones, unknown parameters are ignored
+bool http2_deserialize_settings(const http2_frame_t *const restrict frame, http2_settings_t *const restrict settings)
+{
+  const char *cursor = frame->payload;
+  const char *const end = frame->payload + frame->payload_len;
+
+  for (; cursor < end; cursor += SETTING_SIZE)
+  {
+    const uint16_t id = ((uint8_t)cursor[0] << 8) | (uint8_t)cursor[1];
+    const uint32_t value = load_be32(cursor + sizeof(uint16_t));
+
+    switch (id)
+    {
+      case SETTINGS_HEADER_TABLE_SIZE:
+        settings->header_table_size = value;
+        break;
+      case SETTINGS_ENABLE_PUSH:
+        if (UNLIKELY(value > 1))
+          return false;
+        settings->enable_push = value;
+        break;
+      case SETTINGS_MAX_CONCURRENT_STREAMS:
+        settings->max_concurrent_streams = value;
+        break;
+      case SETTINGS_INITIAL_WINDOW_SIZE:
+        if (UNLIKELY(value > HTTP2_MAX_WINDOW_SIZE))
+          return false;
+        settings->initial_window_size = value;
+        break;
+      case SETTINGS_MAX_FRAME_SIZE:
+        if (UNLIKELY((value < HTTP2_DEFAULT_MAX_FRAME_SIZE) || (value > HTTP2_MAX_FRAME_SIZE)))
+          return false;
+        settings->max_frame_size = value;
+        break;
+      case SETTINGS_MAX_HEADER_LIST_SIZE:
+        settings->max_header_list_size = value;
+        break;
+    }
+  }
+
+  return true;
+}
+
+//pseudo-headers are moved into the request fields, :authority becomes the Host header
+bool http2_deserialize_request(http_hpack_table_t *const restrict table, char *restrict block, const uint32_t block_len, http_request_t *const restrict request, char *restrict scratch, const uint32_t scratch_size)
+{
+  uint16_t headers_count = request->headers_count;
+  if (UNLIKELY(!http_hpack_decode(table, block, block_len, request->headers, &headers_count, scratch, scratch_size)))
+    return false;
+
+  return request_from_fields(request, headers_count, HTTP_2_0);
+}
+
+bool http2_deserialize_response(http_hpack_table_t *const restrict table, char *restrict block, const uint32_t block_len, http_response_t *const restrict response, char *restrict scratch, const uint32_t scratch_size)
+{
+  uint16_t headers_count = response->headers_count;
+  if (UNLIKELY(!http_hpack_decode(table, block, block_len, response->headers, &headers_count, scratch, scratch_size)))
+    return false;
+
+  return response_from_fields(response, headers_count, HTTP_2_0);
+}
+
+uint32_t http2_serialize_data(char *restrict buffer, const uint32_t stream_id, const char *restrict data, const uint32_t data_len, const uint8_t pad_len, const uint8_t flags)
+{
+  if (pad_len == 0)
+  {
+    serialize_frame_header(buffer, data_len, HTTP2_DATA, flags, stream_id);
+    memcpy(buffer + HTTP2_FRAME_HEADER_SIZE, data, data_len);
+    return HTTP2_FRAME_HEADER_SIZE + data_len;
+  }
+
+  const uint32_t length = sizeof(uint8_t) + data_len + pad_len;
+  serialize_frame_header(buffer, length, HTTP2_DATA, flags | HTTP2_FLAG_PADDED, stream_id);
+  buffer[HTTP2_FRAME_HEADER_SIZE] = pad_len;
+  memcpy(buffer + HTTP2_FRAME_HEADER_SIZE + sizeof(uint8_t), data, data_len);
+  memset(buffer + HTTP2_FRAME_HEADER_SIZE + sizeof(uint8_t) + data_len, 0, pad_len);
+
+  return HTTP2_FRAME_HEADER_SIZE + length;
+}
+
+//block may already be in buffer, it is moved to make room for the frame headers
+uint32_t http2_serialize_headers(char *buffer, const uint32_t stream_id, const char *block, const uint32_t block_len, const uint32_t max_frame_size, const uint8_t flags)
+{
+  memmove(buffer + HTTP2_FRAME_HEADER_SIZE, block, block_len);
+  return serialize_header_block(buffer, stream_id, block_len, max_frame_size, flags);
+}
+
+//only the parameters that differ from the defaults of the protocol are sent
+uint32_t http2_serialize_settings(char *restrict buffer, const http2_settings_t *restrict settings)
+{
+  const http2_settings_t defaults = HTTP2_DEFAULT_SETTINGS;
+  const uint32_t values[SETTINGS_COUNT] = {
+    settings->header_table_size,
+    settings->enable_push,
+    settings->max_concurrent_streams,
+    settings->initial_window_size,
+    settings->max_frame_size,
+    settings->max_header_list_size
+  };
+  const uint32_t default_values[SETTINGS_COUNT] = {
+    defaults.header_table_size,
+    defaults.enable_push,
+    defaults.max_concurrent_streams,
+    defaults.initial_window_size,
+    defaults.max_frame_size,
+    defaults.max_header_list_size
+  };
+
+  char *cursor = buffer + HTTP2_FRAME_HEADER_SIZE;
+  for (uint8_t i = 0; i < SETTINGS_COUNT; i++)
+  {
+    if (values[i] == default_values[i])
+      continue;
+    cursor[0] = 0;
+    cursor[1] = SETTINGS_HEADER_TABLE_SIZE + i;
+    store_be32(cursor + sizeof(uint16_t), values[i]);
+    cursor += SETTING_SIZE;
+  }
+
+  const uint32_t length = cursor - buffer - HTTP2_FRAME_HEADER_SIZE;
+  serialize_frame_header(buffer, length, HTTP2_SETTINGS, 0, 0);
+
+  return HTTP2_FRAME_HEADER_SIZE + length;
+}
+
+uint32_t http2_serialize_settings_ack(char *restrict buffer)
+{
+  serialize_frame_header(buffer, 0, HTTP2_SETTINGS, HTTP2_FLAG_ACK, 0);
+  return HTTP2_FRAME_HEADER_SIZE;
+}
+
+uint32_t http2_serialize_window_update(char *restrict buffer, const uint32_t stream_id, const uint32_t increment)
+{
+  serialize_frame_header(buffer, sizeof(uint32_t), HTTP2_WINDOW_UPDATE, 0, stream_id);
+  store_be32(buffer + HTTP2_FRAME_HEADER_SIZE, increment & STREAM_ID_MASK);
+  return HTTP2_FRAME_HEADER_SIZE + sizeof(uint32_t);
+}
+
+uint32_t http2_serialize_ping(char *restrict buffer, const char *restrict opaque, const bool ack)
+{
+  serialize_frame_header(buffer, PING_SIZE, HTTP2_PING, ack ? HTTP2_FLAG_ACK : 0, 0);
+  memcpy8(buffer + HTTP2_FRAME_HEADER_SIZE, opaque);
+  return HTTP2_FRAME_HEADER_SIZE + PING_SIZE;
+}
+
+uint32_t http2_serialize_rst_stream(char *restrict buffer, const uint32_t stream_id, const uint32_t error_code)
+{
+  serialize_frame_header(buffer, sizeof(uint32_t), HTTP2_RST_STREAM, 0, stream_id);
+  store_be32(buffer + HTTP2_FRAME_HEADER_SIZE, error_code);
+  return HTTP2_FRAME_HEADER_SIZE + sizeof(uint32_t);
+}
+
+uint32_t http2_serialize_goaway(char *restrict buffer, const uint32_t last_stream_id, const uint32_t error_code, const char *restrict debug, const uint32_t debug_len)
+{
+  const uint32_t length = 2 * sizeof(uint32_t) + debug_len;
+
+  serialize_frame_header(buffer, length, HTTP2_GOAWAY, 0, 0);
+  store_be32(buffer + HTTP2_FRAME_HEADER_SIZE, last_stream_id & STREAM_ID_MASK);
+  store_be32(buffer + HTTP2_FRAME_HEADER_SIZE + sizeof(uint32_t), error_code);
+  memcpy(buffer + HTTP2_FRAME_HEADER_SIZE + 2 * sizeof(uint32_t), debug, debug_len);
+
+  return HTTP2_FRAME_HEADER_SIZE + length;
+}
+
+uint32_t http2_serialize_request(char *restrict buffer, http_hpack_table_t *const restrict table, const uint32_t stream_id, const http_request_t *restrict request, const uint32_t max_frame_size)
+{
+  const char *const buffer_start = buffer;
+
+  buffer += serialize_request_head(buffer, table, stream_id, request, max_frame_size);
+  buffer += serialize_body(buffer, stream_id, request->body, request->body_len, max_frame_size);
+
+  return buffer - buffer_start;
+}
+
+uint32_t http2_serialize_response(char *restrict buffer, http_hpack_table_t *const restrict table, const uint32_t stream_id, const http_response_t *restrict response, const uint32_t max_frame_size)
+{
+  const char *const buffer_start = buffer;
+
+  buffer += serialize_response_head(buffer, table, stream_id, response, max_frame_size);
+  buffer += serialize_body(buffer, stream_id, response->body, response->body_len, max_frame_size);
+
+  return buffer - buffer_start;
+}
+
+//the header block is staged, the body is sent from the caller's memory between the DATA frame headers, as far as the send window allows
+int64_t http2_serialize_request_write(const int fd, http_hpack_table_t *const restrict table, const uint32_t stream_id, const http_request_t *restrict request, const uint32_t max_frame_size, const uint32_t window, uint32_t *const restrict body_sent)
+{
+  const uint32_t block_bound = REQUEST_PSEUDO_BOUND + request->path_len + headers_bound(request->headers, request->headers_count);
+  if (UNLIKELY(head_size(block_bound, max_frame_size) > STAGING_SIZE))
+    return -1;
+
+  struct iovec iov[IOV_MAX] ALIGNED(64);
+  char buffer[STAGING_SIZE] ALIGNED(64);
+  const uint32_t head_len = serialize_request_head(buffer, table, stream_id, request, max_frame_size);
+
+  return write_message(fd, iov, buffer, head_len, stream_id, request->body, request->body_len, max_frame_size, window, body_sent);
+}
+
+int64_t http2_serialize_response_write(const int fd, http_hpack_table_t *const restrict table, const uint32_t stream_id, const http_response_t *restrict response, const uint32_t max_frame_size, const uint32_t window, uint32_t *const restrict body_sent)
+{
+  const uint32_t block_bound = RESPONSE_PSEUDO_BOUND + headers_bound(response->headers, response->headers_count);
+  if (UNLIKELY(head_size(block_bound, max_frame_size) > STAGING_SIZE))
+    return -1;
+
+  struct iovec iov[IOV_MAX] ALIGNED(64);
+  char buffer[STAGING_SIZE] ALIGNED(64);
+  const uint32_t head_len = serialize_response_head(buffer, table, stream_id, response, max_frame_size);
+
+  return write_message(fd, iov, buffer, head_len, stream_id, response->body, response->body_len, max_frame_size, window, body_sent);
+}
+
+//shared with HTTP/3: validates the decoded fields and moves the pseudo-headers into the request, :authority becomes the Host header
+bool request_from_fields(http_request_t *const restrict request, const uint16_t fields_count, const http_version_t version)
+{
+  http_header_t *const headers = request->headers;
+  http_header_t pseudo[PSEUDO_AUTHORITY + 1] = {0};
+  uint32_t content_length = 0;
+  bool has_content_length = false;
+  uint16_t count = 0;
+
+  for (uint16_t i = 0; LIKELY(i < fields_count); i++)
+  {
+    const http_header_t header = headers[i];
+    if (UNLIKELY(!lowercase_name(&header)))
+      return false;
+
+    if ((header.key_len != 0) && (header.key[0] == ':'))
+    {
+      const int8_t index = find_pseudo(&header);
+      const bool valid = (count == 0) && (index >= 0) && (index <= PSEUDO_AUTHORITY) && (pseudo[index].key == NULL);
+      if (UNLIKELY(!valid))
+        return false;
+      pseudo[index] = header;
+      continue;
+    }
+
+    if (UNLIKELY(connection_specific(&header)))
+      return false;
+    if ((header.id == HTTP_HEADER_HOST) && (pseudo[PSEUDO_AUTHORITY].key != NULL))
+      continue;
+    if (header.id == HTTP_HEADER_CONTENT_LENGTH)
+    {
+      uint32_t value;
+      if (UNLIKELY(!deserialize_content_length(&header, &value) || (has_content_length && (value != content_length))))
+        return false;
+      content_length = value;
+      has_content_length = true;
+    }
+
+    headers[count++] = header;
+  }
+
+  if (UNLIKELY((pseudo[PSEUDO_METHOD].key == NULL) || !deserialize_method(&pseudo[PSEUDO_METHOD], &request->method)))
+    return false;
+
+  const bool connect = (request->method == HTTP_CONNECT);
+  const bool valid = connect ?
+    (pseudo[PSEUDO_AUTHORITY].key != NULL) && (pseudo[PSEUDO_SCHEME].key == NULL) && (pseudo[PSEUDO_PATH].key == NULL) :
+    (pseudo[PSEUDO_SCHEME].key != NULL) && (pseudo[PSEUDO_PATH].key != NULL) && (pseudo[PSEUDO_PATH].value_len != 0);
+  if (UNLIKELY(!valid))
+    return false;
+
+  if (pseudo[PSEUDO_AUTHORITY].key != NULL)
+  {
+    memmove(headers + 1, headers, count * sizeof(http_header_t));
+    headers[0] = (http_header_t){
+      .key = (char *)header_names_str[HTTP_HEADER_HOST],
+      .value = pseudo[PSEUDO_AUTHORITY].value,
+      .key_len = header_names_len[HTTP_HEADER_HOST] - STR_LEN(": "),
+      .value_len = pseudo[PSEUDO_AUTHORITY].value_len,
+      .id = HTTP_HEADER_HOST
+    };
+    count++;
+  }
+
+  request->path = pseudo[PSEUDO_PATH].value;
+  request->path_len = pseudo[PSEUDO_PATH].value_len;
+  request->version = version;
+  request->headers_count = count;
+  request->body = NULL;
+  request->body_len = content_length;
+  request->framing = has_content_length ? HTTP_FRAMING_CONTENT_LENGTH : HTTP_FRAMING_NONE;
+  request->keep_alive = true;
+  request->emit_content_length = false;
+
+  return true;
+}
+
+bool response_from_fields(http_response_t *const restrict response, const uint16_t fields_count, const http_version_t version)
+{
+  http_header_t *const headers = response->headers;
+  const char *status = NULL;
+  uint32_t content_length = 0;
+  bool has_content_length = false;
+  uint16_t count = 0;
+
+  for (uint16_t i = 0; LIKELY(i < fields_count); i++)
+  {
+    const http_header_t header = headers[i];
+    if (UNLIKELY(!lowercase_name(&header)))
+      return false;
+
+    if ((header.key_len != 0) && (header.key[0] == ':'))
+    {
+      const bool valid = (count == 0) && (status == NULL) && (find_pseudo(&header) == PSEUDO_STATUS) && (header.value_len == 3);
+      if (UNLIKELY(!valid))
+        return false;
+      status = header.value;
+      continue;
+    }
+
+    if (UNLIKELY(connection_specific(&header)))
+      return false;
+    if (header.id == HTTP_HEADER_CONTENT_LENGTH)
+    {
+      uint32_t value;
+      if (UNLIKELY(!deserialize_content_length(&header, &value) || (has_content_length && (value != content_length))))
+        return false;
+      content_length = value;
+      has_content_length = true;
+    }
+    headers[count++] = header;
+  }
+
+  if (UNLIKELY(status == NULL))
+    return false;
+
+  const uint8_t hundreds = status[0] - '0';
+  const uint8_t tens = status[1] - '0';
+  const uint8_t units = status[2] - '0';
+  if (UNLIKELY((hundreds < 1) || (hundreds > 9) || (tens > 9) || (units > 9)))
+    return false;
+
+  response->version = version;
+  response->status_code = hundreds * 100 + tens * 10 + units;
+  response->reason_phrase = NULL;
+  response->reason_phrase_len = 0;
+  response->headers_count = count;
+  response->body = NULL;
+  response->body_len = content_length;
+  response->framing = has_content_length ? HTTP_FRAMING_CONTENT_LENGTH : HTTP_FRAMING_NONE;
+  response->keep_alive = true;
+  response->emit_content_length = false;
+
+  return true;
+}
+
+//shared with HTTP/3: :scheme is always https, :authority comes from the Host header
+uint8_t request_pseudo_fields(http_header_t *restrict pseudo, const http_request_t *restrict request, const http_header_t **const restrict host)
+{
+  *host = NULL;
+  for (uint16_t i = 0; (i < request->headers_count) && (*host == NULL); i++)
+    *host = (request->headers[i].id == HTTP_HEADER_HOST) ? &request->headers[i] : NULL;
+
+  uint8_t count = 0;
+  pseudo[count++] = PSEUDO(":method", methods_str[request->method], methods_len[request->method]);
+  if (request->method != HTTP_CONNECT)
+  {
+    pseudo[count++] = PSEUDO(":scheme", "https", STR_LEN("https"));
+    pseudo[count++] = PSEUDO(":path", request->path, request->path_len);
+  }
+  if (*host != NULL)
+    pseudo[count++] = PSEUDO(":authority", (*host)->value, (*host)->value_len);
+
+  return count;
+}
+
+static inline uint32_t load_be32(const char *const src)
+{
+  uint32_t value;
+  memcpy4(&value, src);
+  return __builtin_bswap32(value);
+}
+
+static inline void store_be32(char *const dest, const uint32_t value)
+{
+  const uint32_t swapped = __builtin_bswap32(value);
+  memcpy4(dest, &swapped);
+}
+
+static inline void serialize_frame_header(char *restrict buffer, const uint32_t length, const http2_frame_type_t type, const uint8_t flags, const uint32_t stream_id)
+{
+  store_be32(buffer, (length << 8) | type);
+  buffer[4] = flags;
+  store_be32(buffer + 5, stream_id & STREAM_ID_MASK);
+}
+
+//the block is at buffer + HTTP2_FRAME_HEADER_SIZE, its tail is spread backwards into CONTINUATION frames
+static uint32_t serialize_header_block(char *buffer, const uint32_t stream_id, const uint32_t block_len, const uint32_t max_frame_size, const uint8_t flags)
+{
+  const uint32_t frames = (block_len != 0) ? (block_len - 1) / max_frame_size + 1 : 1;
+
+  for (uint32_t i = frames - 1; i > 0; i--)
+  {
+    const uint32_t fragment_len = MIN(max_frame_size, block_len - i * max_frame_size);
+    char *const frame = buffer + i * (HTTP2_FRAME_HEADER_SIZE + max_frame_size);
+
+    memmove(frame + HTTP2_FRAME_HEADER_SIZE, buffer + HTTP2_FRAME_HEADER_SIZE + i * max_frame_size, fragment_len);
+    serialize_frame_header(frame, fragment_len, HTTP2_CONTINUATION, (i == frames - 1) ? HTTP2_FLAG_END_HEADERS : 0, stream_id);
+  }
+
+  const uint8_t end_headers = (frames == 1) ? HTTP2_FLAG_END_HEADERS : 0;
+  serialize_frame_header(buffer, MIN(block_len, max_frame_size), HTTP2_HEADERS, flags | end_headers, stream_id);
+
+  return frames * HTTP2_FRAME_HEADER_SIZE + block_len;
+}
+
+static uint32_t serialize_body(char *restrict buffer, const uint32_t stream_id, const char *restrict body, const uint32_t body_len, const uint32_t max_frame_size)
+{
+  const char *const buffer_start = buffer;
+
+  for (uint32_t offset = 0; offset < body_len;)
+  {
+    const uint32_t chunk_len = MIN(max_frame_size, body_len - offset);
+    const uint8_t flags = (offset + chunk_len == body_len) ? HTTP2_FLAG_END_STREAM : 0;
+
+    buffer += http2_serialize_data(buffer, stream_id, body + offset, chunk_len, 0, flags);
+    offset += chunk_len;
+  }
+
+  return buffer - buffer_start;
+}
+
+static uint32_t serialize_request_head(char *restrict buffer, http_hpack_table_t *const restrict table, const uint32_t stream_id, const http_request_t *restrict request, const uint32_t max_frame_size)
+{
+  const http_header_t *host;
+  http_header_t pseudo[HTTP_REQUEST_PSEUDO_FIELDS];
+  const uint8_t pseudo_count = request_pseudo_fields(pseudo, request, &host);
+
+  char *const block = buffer + HTTP2_FRAME_HEADER_SIZE;
+  uint32_t block_len = http_hpack_encode(table, block, pseudo, pseudo_count);
+  block_len += encode_headers(table, block + block_len, request->headers, request->headers_count, host != NULL);
+
+  const uint8_t flags = (request->body_len == 0) ? HTTP2_FLAG_END_STREAM : 0;
+  return serialize_header_block(buffer, stream_id, block_len, max_frame_size, flags);
+}
+
+static uint32_t serialize_response_head(char *restrict buffer, http_hpack_table_t *const restrict table, const uint32_t stream_id, const http_response_t *restrict response, const uint32_t max_frame_size)
+{
+  const uint16_t status_code = response->status_code;
+  const char status[3] = { '0' + status_code / 100, '0' + (status_code / 10) % 10, '0' + status_code % 10 };
+  const http_header_t pseudo = PSEUDO(":status", status, sizeof(status));
+
+  char *const block = buffer + HTTP2_FRAME_HEADER_SIZE;
+  uint32_t block_len = http_hpack_encode(table, block, &pseudo, 1);
+  block_len += encode_headers(table, block + block_len, response->headers, response->headers_count, false);
+
+  const uint8_t flags = (response->body_len == 0) ? HTTP2_FLAG_END_STREAM : 0;
+  return serialize_header_block(buffer, stream_id, block_len, max_frame_size, flags);
+}
+
+//headers of the HTTP/1 connection are dropped, and Host when it was sent as :authority
+static uint32_t encode_headers(http_hpack_table_t *const restrict table, char *restrict buffer, const http_header_t *restrict headers, const uint16_t headers_count, const bool skip_host)
+{
+  const char *const buffer_start = buffer;
+
+  for (uint16_t i = 0; LIKELY(i < headers_count); i++)
+  {
+    const http_header_t *const header = &headers[i];
+    const bool skip = (skip_host && (header->id == HTTP_HEADER_HOST)) || connection_specific(header);
+    if (UNLIKELY(skip))
+      continue;
+    buffer += http_hpack_encode(table, buffer, header, 1);
+  }
+
+  return buffer - buffer_start;
+}
+
+//only END_STREAM tells the peer the body is complete, so it is left out when the window cuts the body short
+static int64_t write_message(const int fd, struct iovec *restrict iov, const char *restrict head, const uint32_t head_len, const uint32_t stream_id, const char *restrict body, const uint32_t body_len, const uint32_t max_frame_size, const uint32_t window, uint32_t *const restrict body_sent)
+{
+  char frame_headers[DATA_FRAMES_PER_WRITE * HTTP2_FRAME_HEADER_SIZE] ALIGNED(64);
+  const uint32_t send_len = MIN(body_len, window);
+  int64_t total_written = 0;
+  uint16_t iovcnt = 0;
+  uint16_t frames = 0;
+
+  iov[iovcnt++] = (struct iovec){ (char *)head, head_len };
+
+  for (uint32_t offset = 0; offset < send_len;)
+  {
+    if (UNLIKELY(frames == DATA_FRAMES_PER_WRITE))
+    {
+      const bool flushed = flush_iov(fd, iov, iovcnt, 0, &total_written);
+      *body_sent = body_written(total_written, head_len, max_frame_size);
+      if (UNLIKELY(!flushed))
+        return write_result(total_written);
+      iovcnt = 0;
+      frames = 0;
+    }
+
+    const uint32_t chunk_len = MIN(max_frame_size, send_len - offset);
+    const uint8_t flags = (offset + chunk_len == body_len) ? HTTP2_FLAG_END_STREAM : 0;
+    char *const frame_header = frame_headers + frames++ * HTTP2_FRAME_HEADER_SIZE;
+
+    serialize_frame_header(frame_header, chunk_len, HTTP2_DATA, flags, stream_id);
+    iov[iovcnt++] = (struct iovec){ frame_header, HTTP2_FRAME_HEADER_SIZE };
+    iov[iovcnt++] = (struct iovec){ (char *)body + offset, chunk_len };
+    offset += chunk_len;
+  }
+
+  const bool flushed = flush_iov(fd, iov, iovcnt, 0, &total_written);
+  *body_sent = body_written(total_written, head_len, max_frame_size);
+  if (UNLIKELY(!flushed))
+    return write_result(total_written);
+
+  return total_written;
+}
+
+//every DATA frame but the last is a frame header followed by max_frame_size bytes
+static inline uint32_t body_written(const int64_t total_written, const uint32_t head_len, const uint32_t max_frame_size)
+{
+  if (total_written <= head_len)
+    return 0;
+
+  const uint64_t data_len = total_written - head_len;
+  const uint64_t frame_len = HTTP2_FRAME_HEADER_SIZE + max_frame_size;
+  const uint64_t last_len = data_len % frame_len;
+
+  return (data_len / frame_len) * max_frame_size + ((last_len > HTTP2_FRAME_HEADER_SIZE) ? last_len - HTTP2_FRAME_HEADER_SIZE : 0);
+}
+
+static inline uint32_t head_size(const uint32_t block_bound, const uint32_t max_frame_size)
+{
+  return (block_bound / max_frame_size + 1) * HTTP2_FRAME_HEADER_SIZE + block_bound;
+}
+
+static uint32_t headers_bound(const http_header_t *restrict headers, const uint16_t headers_count)
+{
+  uint32_t bound = 0;
+
+  for (uint16_t i = 0; LIKELY(i < headers_count); i++)
+    bound += headers[i].key_len + headers[i].value_len + 12;
+
+  return bound;
+}
+
+static bool strip_padding(http2_frame_t *const restrict frame)
+{
+  if (!(frame->flags & HTTP2_FLAG_PADDED))
+    return true;
+  if (UNLIKELY(frame->payload_len == 0))
+    return false;
+
+  const uint8_t pad_len = frame->payload[0];
+  if (UNLIKELY(pad_len >= frame->payload_len))
+    return false;
+
+  frame->payload++;
+  frame->payload_len -= sizeof(uint8_t) + pad_len;
+  return true;
+}
+
+bool connection_specific(const http_header_t *restrict header)
+{
+  switch (header->id)
+  {
+    case HTTP_HEADER_CONNECTION:
+    case HTTP_HEADER_KEEP_ALIVE:
+    case HTTP_HEADER_TRANSFER_ENCODING:
+    case HTTP_HEADER_UPGRADE:
+      return true;
+    case HTTP_HEADER_TE:
+      //only "TE: trailers" is allowed through
+      return !equals_caseless(header->value, header->value_len, "trailers", STR_LEN("trailers"));
+    case HTTP_HEADER_UNKNOWN:
+      break;
+    default:
+      return false;
+  }
+
+  for (uint8_t i = 0; i < ARR_SIZE(connection_specific_len); i++)
+  {
+    if (equals_caseless(header->key, header->key_len, connection_specific_str[i], connection_specific_len[i]))
+      return true;
+  }
+  if (equals_caseless(header->key, header->key_len, "te", STR_LEN("te")))
+    return !equals_caseless(header->value, header->value_len, "trailers", STR_LEN("trailers"));
+
+  return false;
+}
+
+static int8_t find_pseudo(const http_header_t *restrict header)
+{
+  for (uint8_t i = 0; i < ARR_SIZE(pseudo_len); i++)
+  {
+    if ((header->key_len == pseudo_len[i]) && (memcmp(header->key, pseudo_str[i], pseudo_len[i]) == 0))
+      return i;
+  }
+
+  return -1;
+}
+
+static bool deserialize_method(const http_header_t *restrict header, http_method_t *const restrict method)
+{
+  for (uint8_t i = 0; i <= HTTP_CONNECT; i++)
+  {
+    if ((header->value_len == methods_len[i]) && (memcmp(header->value, methods_str[i], methods_len[i]) == 0))
+    {
+      *method = i;
+      return true;
+    }
+  }
+
+  return false;
+}
+
+//RFC 9113 section 8.2.1: names are lowercase on the wire, so the static and dynamic tables match them exactly
+static bool lowercase_name(const http_header_t *restrict header)
+{
+  bool lowercase = true;
+
+  for (uint16_t i = 0; i < header->key_len; i += sizeof(uint64_t))
+  {
+    const uint16_t remaining = header->key_len - i;
+    const uint8_t chunk_len = (remaining < sizeof(uint64_t)) ? remaining : sizeof(uint64_t);
+    uint64_t word = 0;
+
+    memcpy(&word, header->key + i, chunk_len);
+    lowercase &= (tolower_swar(word) == word);
+  }
+
+  return lowercase;
+}
+
+static bool deserialize_content_length(const http_header_t *restrict header, uint32_t *const restrict content_length)
+{
+  if (UNLIKELY((header->value_len == 0) || (header->value_len > STR_LEN("4294967295"))))
+    return false;
+
+  uint64_t value = 0;
+  for (uint16_t i = 0; i < header->value_len; i++)
+  {
+    const uint8_t digit = header->value[i] - '0';
+    if (UNLIKELY(digit > 9))
+      return false;
+    value = value * 10 + digit;
+  }
+
+  if (UNLIKELY(value > UINT32_MAX))
+    return false;
+
+  *content_length = value;
+  return true;
+}
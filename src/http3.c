@@ -0,0 +1,387 @@
+/*================================================================================
+
+File: http3.c                                                                   
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-03-14 10:26:18                                                 
+last edited: 2025-03-15 13:47:40                                                
+
+================================================================================*/
+
+#include <string.h>
+
+#include "common.h"
+#include "hpack_internal.h"
+#include "http3.h"
+#include "deserializer.h"
+
+# define PSEUDO(name, value, value_len) ((http_header_t){ (char *)(name), (char *)(value), STR_LEN(name), (value_len), HTTP_HEADER_UNKNOWN })
+
+//identifiers of the SETTINGS parameters, those HTTP/2 had and HTTP/3 dropped are reserved
+typedef enum: uint8_t {
+  SETTINGS_HTTP2_RESERVED = 0x00,
+  SETTINGS_QPACK_MAX_TABLE_CAPACITY = 0x01,
+  SETTINGS_HTTP2_ENABLE_PUSH,
+  SETTINGS_HTTP2_MAX_CONCURRENT_STREAMS,
+  SETTINGS_HTTP2_INITIAL_WINDOW_SIZE,
+  SETTINGS_HTTP2_MAX_FRAME_SIZE,
+  SETTINGS_MAX_FIELD_SECTION_SIZE,
+  SETTINGS_QPACK_BLOCKED_STREAMS
+} setting_t;
+
+//frame types of HTTP/2 that have no HTTP/3 counterpart, RFC 9114 section 7.2.8
+typedef enum: uint8_t {
+  HTTP2_PRIORITY = 0x02,
+  HTTP2_PING = 0x06,
+  HTTP2_WINDOW_UPDATE = 0x08,
+  HTTP2_CONTINUATION = 0x09
+} reserved_frame_t;
+
+static inline uint8_t varint_size(const uint64_t value);
+static bool settings_valid(const http3_frame_t *const restrict frame);
+static uint32_t encode_message(char *restrict buffer, http_qpack_encoder_t *const restrict encoder, const uint32_t stream_id, const http_header_t *restrict pseudo, const uint8_t pseudo_count, const http_header_t *restrict headers, const uint16_t headers_count, const bool skip_host, char *restrict encoder_stream, uint32_t *const restrict encoder_stream_len);
+
+//the two top bits of the first byte give the length: 1, 2, 4 or 8 bytes
+uint8_t http3_serialize_varint(char *restrict buffer, const uint64_t value)
+{
+  if (LIKELY(value < (1 << 6)))
+  {
+    *buffer = value;
+    return 1;
+  }
+  if (LIKELY(value < (1 << 14)))
+  {
+    const uint16_t word = __builtin_bswap16(value | 0x4000);
+    memcpy2(buffer, &word);
+    return 2;
+  }
+  if (value < (1 << 30))
+  {
+    const uint32_t word = __builtin_bswap32(value | 0x80000000);
+    memcpy4(buffer, &word);
+    return 4;
+  }
+
+  const uint64_t word = __builtin_bswap64(value | 0xC000000000000000);
+  memcpy8(buffer, &word);
+  return 8;
+}
+
+//0 if the integer is cut short
+uint8_t http3_deserialize_varint(const char *restrict buffer, const uint32_t buffer_size, uint64_t *const restrict value)
+{
+  if (UNLIKELY(buffer_size == 0))
+    return 0;
+
+  const uint8_t len = 1 << ((uint8_t)buffer[0] >> 6);
+  if (UNLIKELY(buffer_size < len))
+    return 0;
+
+  switch (len)
+  {
+    case 1:
+      *value = (uint8_t)buffer[0];
+      break;
+    case 2:
+    {
+      uint16_t word;
+      memcpy2(&word, buffer);
+      *value = __builtin_bswap16(word) & 0x3FFF;
+      break;
+    }
+    case 4:
+    {
+      uint32_t word;
+      memcpy4(&word, buffer);
+      *value = __builtin_bswap32(word) & 0x3FFFFFFF;
+      break;
+    }
+    default:
+    {
+      uint64_t word;
+      memcpy8(&word, buffer);
+      *value = __builtin_bswap64(word) & HTTP3_VARINT_MAX;
+    }
+  }
+
+  return len;
+}
+
+//lets DATA payloads bigger than any buffer be streamed, 0 if the header is cut short
+uint8_t http3_deserialize_frame_header(const char *restrict buffer, const uint32_t buffer_size, uint64_t *const restrict type, uint64_t *const restrict length)
+{
+  const uint8_t type_len = http3_deserialize_varint(buffer, buffer_size, type);
+  if (UNLIKELY(type_len == 0))
+    return 0;
+
+  const uint8_t length_len = http3_deserialize_varint(buffer + type_len, buffer_size - type_len, length);
+  if (UNLIKELY(length_len == 0))
+    return 0;
+
+  return type_len + length_len;
+}
+
+//unknown frame types are returned as they are, the caller must ignore them
+uint32_t http3_deserialize_frame(char *restrict buffer, const uint32_t buffer_size, http3_frame_t *const restrict frame, const uint32_t max_frame_size)
+{
+  uint64_t type;
+  uint64_t length;
+  const uint8_t header_len = http3_deserialize_frame_header(buffer, buffer_size, &type, &length);
+  if (UNLIKELY(header_len == 0))
+    return HTTP_NEED_MORE;
+  if (UNLIKELY(length > max_frame_size))
+    return 0;
+  if (UNLIKELY(buffer_size - header_len < length))
+    return HTTP_NEED_MORE;
+
+  *frame = (http3_frame_t){
+    .payload = buffer + header_len,
+    .type = type,
+    .payload_len = length
+  };
+
+  uint8_t id_len;
+  bool valid;
+
+  switch (type)
+  {
+    case HTTP3_CANCEL_PUSH:
+    case HTTP3_GOAWAY:
+    case HTTP3_MAX_PUSH_ID:
+      id_len = http3_deserialize_varint(frame->payload, frame->payload_len, &frame->id);
+      valid = (id_len != 0) && (id_len == frame->payload_len);
+      break;
+    case HTTP3_PUSH_PROMISE:
+      id_len = http3_deserialize_varint(frame->payload, frame->payload_len, &frame->id);
+      valid = (id_len != 0);
+      frame->payload += id_len;
+      frame->payload_len -= id_len;
+      break;
+    case HTTP3_SETTINGS:
+      valid = settings_valid(frame);
+      break;
+    case HTTP2_PRIORITY:
+    case HTTP2_PING:
+    case HTTP2_WINDOW_UPDATE:
+    case HTTP2_CONTINUATION:
+      valid = false;
+      break;
+    default:
+      valid = true;
+  }
+
+  if (UNLIKELY(!valid))
+    return 0;
+
+  return header_len + length;
+}
+
+//applies the parameters of a SETTINGS frame over the current ones, unknown parameters are ignored
+bool http3_deserialize_settings(const http3_frame_t *const restrict frame, http3_settings_t *const restrict settings)
+{
+  const char *cursor = frame->payload;
+  const char *const end = frame->payload + frame->payload_len;
+  uint8_t seen = 0;
+
+  while (cursor < end)
+  {
+    uint64_t id;
+    uint64_t value;
+    const uint8_t id_len = http3_deserialize_varint(cursor, end - cursor, &id);
+    const uint8_t value_len = (id_len != 0) ? http3_deserialize_varint(cursor + id_len, end - cursor - id_len, &value) : 0;
+    if (UNLIKELY(value_len == 0))
+      return false;
+    cursor += id_len + value_len;
+
+    if (id > SETTINGS_QPACK_BLOCKED_STREAMS)
+      continue;
+    if (UNLIKELY(seen & (1 << id)))
+      return false;
+    seen |= 1 << id;
+
+    switch (id)
+    {
+      case SETTINGS_QPACK_MAX_TABLE_CAPACITY:
+        settings->qpack_max_table_capacity = value;
+        break;
+      case SETTINGS_MAX_FIELD_SECTION_SIZE:
+        settings->max_field_section_size = value;
+        break;
+      case SETTINGS_QPACK_BLOCKED_STREAMS:
+        settings->qpack_blocked_streams = value;
+        break;
+      case SETTINGS_HTTP2_RESERVED:
+      case SETTINGS_HTTP2_ENABLE_PUSH:
+      case SETTINGS_HTTP2_MAX_CONCURRENT_STREAMS:
+      case SETTINGS_HTTP2_INITIAL_WINDOW_SIZE:
+      case SETTINGS_HTTP2_MAX_FRAME_SIZE:
+        return false;
+    }
+  }
+
+  return true;
+}
+
+//HTTP_NEED_MORE while the section references entries the encoder stream has not delivered yet
+uint32_t http3_deserialize_request(http_qpack_decoder_t *const restrict decoder, char *restrict block, const uint32_t block_len, http_request_t *const restrict request, char *restrict scratch, const uint32_t scratch_size)
+{
+  uint16_t headers_count = request->headers_count;
+  const uint32_t result = http_qpack_decode(decoder, block, block_len, request->headers, &headers_count, scratch, scratch_size);
+  if (UNLIKELY((result == 0) | (result == HTTP_NEED_MORE)))
+    return result;
+
+  return request_from_fields(request, headers_count, HTTP_3_0) ? result : 0;
+}
+
+uint32_t http3_deserialize_response(http_qpack_decoder_t *const restrict decoder, char *restrict block, const uint32_t block_len, http_response_t *const restrict response, char *restrict scratch, const uint32_t scratch_size)
+{
+  uint16_t headers_count = response->headers_count;
+  const uint32_t result = http_qpack_decode(decoder, block, block_len, response->headers, &headers_count, scratch, scratch_size);
+  if (UNLIKELY((result == 0) | (result == HTTP_NEED_MORE)))
+    return result;
+
+  return response_from_fields(response, headers_count, HTTP_3_0) ? result : 0;
+}
+
+uint8_t http3_serialize_frame_header(char *restrict buffer, const uint64_t type, const uint64_t length)
+{
+  const uint8_t type_len = http3_serialize_varint(buffer, type);
+  return type_len + http3_serialize_varint(buffer + type_len, length);
+}
+
+//there is no END_STREAM flag, the message ends when the caller closes the QUIC stream
+uint32_t http3_serialize_data(char *restrict buffer, const char *restrict data, const uint32_t data_len)
+{
+  const uint8_t header_len = http3_serialize_frame_header(buffer, HTTP3_DATA, data_len);
+  memcpy(buffer + header_len, data, data_len);
+
+  return header_len + data_len;
+}
+
+//block may already be in buffer, it is moved to make room for the frame header
+uint32_t http3_serialize_headers(char *buffer, const char *block, const uint32_t block_len)
+{
+  const uint8_t header_len = 1 + varint_size(block_len);
+  memmove(buffer + header_len, block, block_len);
+  http3_serialize_frame_header(buffer, HTTP3_HEADERS, block_len);
+
+  return header_len + block_len;
+}
+
+//only the parameters that differ from the defaults of the protocol are sent
+uint32_t http3_serialize_settings(char *restrict buffer, const http3_settings_t *restrict settings)
+{
+  const http3_settings_t defaults = HTTP3_DEFAULT_SETTINGS;
+  char payload[3 * 2 * sizeof(uint64_t)];
+  uint8_t payload_len = 0;
+
+  if (settings->qpack_max_table_capacity != defaults.qpack_max_table_capacity)
+  {
+    payload_len += http3_serialize_varint(payload + payload_len, SETTINGS_QPACK_MAX_TABLE_CAPACITY);
+    payload_len += http3_serialize_varint(payload + payload_len, settings->qpack_max_table_capacity);
+  }
+  if (settings->max_field_section_size != defaults.max_field_section_size)
+  {
+    payload_len += http3_serialize_varint(payload + payload_len, SETTINGS_MAX_FIELD_SECTION_SIZE);
+    payload_len += http3_serialize_varint(payload + payload_len, settings->max_field_section_size);
+  }
+  if (settings->qpack_blocked_streams != defaults.qpack_blocked_streams)
+  {
+    payload_len += http3_serialize_varint(payload + payload_len, SETTINGS_QPACK_BLOCKED_STREAMS);
+    payload_len += http3_serialize_varint(payload + payload_len, settings->qpack_blocked_streams);
+  }
+
+  const uint8_t header_len = http3_serialize_frame_header(buffer, HTTP3_SETTINGS, payload_len);
+  memcpy(buffer + header_len, payload, payload_len);
+
+  return header_len + payload_len;
+}
+
+uint32_t http3_serialize_goaway(char *restrict buffer, const uint64_t id)
+{
+  const uint8_t header_len = http3_serialize_frame_header(buffer, HTTP3_GOAWAY, varint_size(id));
+  return header_len + http3_serialize_varint(buffer + header_len, id);
+}
+
+//a HEADERS frame and, when there is a body, a single DATA frame. Inserts for the peer are written to encoder_stream
+uint32_t http3_serialize_request(char *restrict buffer, http_qpack_encoder_t *const restrict encoder, const uint32_t stream_id, const http_request_t *restrict request, char *restrict encoder_stream, uint32_t *const restrict encoder_stream_len)
+{
+  const http_header_t *host;
+  http_header_t pseudo[HTTP_REQUEST_PSEUDO_FIELDS];
+  const uint8_t pseudo_count = request_pseudo_fields(pseudo, request, &host);
+
+  const char *const buffer_start = buffer;
+
+  buffer += encode_message(buffer, encoder, stream_id, pseudo, pseudo_count, request->headers, request->headers_count, host != NULL, encoder_stream, encoder_stream_len);
+  if (request->body_len != 0)
+    buffer += http3_serialize_data(buffer, request->body, request->body_len);
+
+  return buffer - buffer_start;
+}
+
+uint32_t http3_serialize_response(char *restrict buffer, http_qpack_encoder_t *const restrict encoder, const uint32_t stream_id, const http_response_t *restrict response, char *restrict encoder_stream, uint32_t *const restrict encoder_stream_len)
+{
+  const uint16_t status_code = response->status_code;
+  const char status[3] = { '0' + status_code / 100, '0' + (status_code / 10) % 10, '0' + status_code % 10 };
+  const http_header_t pseudo = PSEUDO(":status", status, sizeof(status));
+
+  const char *const buffer_start = buffer;
+
+  buffer += encode_message(buffer, encoder, stream_id, &pseudo, 1, response->headers, response->headers_count, false, encoder_stream, encoder_stream_len);
+  if (response->body_len != 0)
+    buffer += http3_serialize_data(buffer, response->body, response->body_len);
+
+  return buffer - buffer_start;
+}
+
+static inline uint8_t varint_size(const uint64_t value)
+{
+  return 1 + (value >= (1 << 6)) + 2 * (value >= (1 << 14)) + 4 * (value >= (1 << 30));
+}
+
+//the payload must be a whole sequence of identifier and value pairs
+static bool settings_valid(const http3_frame_t *const restrict frame)
+{
+  const char *cursor = frame->payload;
+  const char *const end = frame->payload + frame->payload_len;
+
+  while (cursor < end)
+  {
+    uint64_t value;
+    const uint8_t id_len = http3_deserialize_varint(cursor, end - cursor, &value);
+    if (UNLIKELY(id_len == 0))
+      return false;
+    cursor += id_len;
+
+    const uint8_t value_len = http3_deserialize_varint(cursor, end - cursor, &value);
+    if (UNLIKELY(value_len == 0))
+      return false;
+    cursor += value_len;
+  }
+
+  return true;
+}
+
+//the section is encoded past the longest frame header, then moved right behind the actual one. Headers of the HTTP/1 connection are dropped, and Host when it was sent as :authority
+static uint32_t encode_message(char *restrict buffer, http_qpack_encoder_t *const restrict encoder, const uint32_t stream_id, const http_header_t *restrict pseudo, const uint8_t pseudo_count, const http_header_t *restrict headers, const uint16_t headers_count, const bool skip_host, char *restrict encoder_stream, uint32_t *const restrict encoder_stream_len)
+{
+  char *const block = buffer + HTTP3_FRAME_HEADER_MAX_SIZE;
+  qpack_section_t section;
+  qpack_section_begin(encoder, &section, block, encoder_stream);
+
+  for (uint8_t i = 0; i < pseudo_count; i++)
+    qpack_section_encode(encoder, &section, &pseudo[i]);
+
+  for (uint16_t i = 0; LIKELY(i < headers_count); i++)
+  {
+    const http_header_t *const header = &headers[i];
+    const bool skip = (skip_host && (header->id == HTTP_HEADER_HOST)) || connection_specific(header);
+    if (UNLIKELY(skip))
+      continue;
+    qpack_section_encode(encoder, &section, header);
+  }
+
+  const uint32_t block_len = qpack_section_end(encoder, &section, stream_id, encoder_stream_len);
+  return http3_serialize_headers(buffer, block, block_len);
+}
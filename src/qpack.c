@@ -0,0 +1,737 @@
+/*================================================================================
+
+File: qpack.c                                                                   
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-03-14 10:26:18                                                 
+last edited: 2025-03-15 13:48:21                                                
+
+================================================================================*/
+
+#include <string.h>
+
+#include "common.h"
+#include "hpack_internal.h"
+#include "qpack.h"
+#include "deserializer.h"
+
+# define STATIC_TABLE_SIZE 99
+# define STATIC_NONE UINT8_MAX
+//Required Insert Count and Delta Base, up to 5 bytes each
+# define PREFIX_MAX_SIZE 10
+//the longest integer a 32 bit value needs: the prefix and 4 continuation bytes
+# define INTEGER_MAX_SIZE 5
+
+typedef struct
+{
+  const char *name;
+  const char *value;
+  uint8_t name_len;
+  uint8_t value_len;
+  http_header_id_t id;
+} static_entry_t;
+
+# define STATIC_ENTRY(n, v, i) { n, v, STR_LEN(n), STR_LEN(v), i }
+
+//RFC 9204 Appendix A, unlike HPACK it starts at 0 and entries sharing a name are not always adjacent
+constexpr static_entry_t static_table[STATIC_TABLE_SIZE] = {
+  STATIC_ENTRY(":authority", "", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":path", "/", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("age", "0", HTTP_HEADER_AGE),
+  STATIC_ENTRY("content-disposition", "", HTTP_HEADER_CONTENT_DISPOSITION),
+  STATIC_ENTRY("content-length", "0", HTTP_HEADER_CONTENT_LENGTH),
+  STATIC_ENTRY("cookie", "", HTTP_HEADER_COOKIE),
+  STATIC_ENTRY("date", "", HTTP_HEADER_DATE),
+  STATIC_ENTRY("etag", "", HTTP_HEADER_ETAG),
+  STATIC_ENTRY("if-modified-since", "", HTTP_HEADER_IF_MODIFIED_SINCE),
+  STATIC_ENTRY("if-none-match", "", HTTP_HEADER_IF_NONE_MATCH),
+  STATIC_ENTRY("last-modified", "", HTTP_HEADER_LAST_MODIFIED),
+  STATIC_ENTRY("link", "", HTTP_HEADER_LINK),
+  STATIC_ENTRY("location", "", HTTP_HEADER_LOCATION),
+  STATIC_ENTRY("referer", "", HTTP_HEADER_REFERER),
+  STATIC_ENTRY("set-cookie", "", HTTP_HEADER_SET_COOKIE),
+  STATIC_ENTRY(":method", "CONNECT", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":method", "DELETE", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":method", "GET", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":method", "HEAD", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":method", "OPTIONS", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":method", "POST", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":method", "PUT", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":scheme", "http", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":scheme", "https", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "103", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "200", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "304", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "404", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "503", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("accept", "*/*", HTTP_HEADER_ACCEPT),
+  STATIC_ENTRY("accept", "application/dns-message", HTTP_HEADER_ACCEPT),
+  STATIC_ENTRY("accept-encoding", "gzip, deflate, br", HTTP_HEADER_ACCEPT_ENCODING),
+  STATIC_ENTRY("accept-ranges", "bytes", HTTP_HEADER_ACCEPT_RANGES),
+  STATIC_ENTRY("access-control-allow-headers", "cache-control", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("access-control-allow-headers", "content-type", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("access-control-allow-origin", "*", HTTP_HEADER_ACCESS_CONTROL_ALLOW_ORIGIN),
+  STATIC_ENTRY("cache-control", "max-age=0", HTTP_HEADER_CACHE_CONTROL),
+  STATIC_ENTRY("cache-control", "max-age=2592000", HTTP_HEADER_CACHE_CONTROL),
+  STATIC_ENTRY("cache-control", "max-age=604800", HTTP_HEADER_CACHE_CONTROL),
+  STATIC_ENTRY("cache-control", "no-cache", HTTP_HEADER_CACHE_CONTROL),
+  STATIC_ENTRY("cache-control", "no-store", HTTP_HEADER_CACHE_CONTROL),
+  STATIC_ENTRY("cache-control", "public, max-age=31536000", HTTP_HEADER_CACHE_CONTROL),
+  STATIC_ENTRY("content-encoding", "br", HTTP_HEADER_CONTENT_ENCODING),
+  STATIC_ENTRY("content-encoding", "gzip", HTTP_HEADER_CONTENT_ENCODING),
+  STATIC_ENTRY("content-type", "application/dns-message", HTTP_HEADER_CONTENT_TYPE),
+  STATIC_ENTRY("content-type", "application/javascript", HTTP_HEADER_CONTENT_TYPE),
+  STATIC_ENTRY("content-type", "application/json", HTTP_HEADER_CONTENT_TYPE),
+  STATIC_ENTRY("content-type", "application/x-www-form-urlencoded", HTTP_HEADER_CONTENT_TYPE),
+  STATIC_ENTRY("content-type", "image/gif", HTTP_HEADER_CONTENT_TYPE),
+  STATIC_ENTRY("content-type", "image/jpeg", HTTP_HEADER_CONTENT_TYPE),
+  STATIC_ENTRY("content-type", "image/png", HTTP_HEADER_CONTENT_TYPE),
+  STATIC_ENTRY("content-type", "text/css", HTTP_HEADER_CONTENT_TYPE),
+  STATIC_ENTRY("content-type", "text/html; charset=utf-8", HTTP_HEADER_CONTENT_TYPE),
+  STATIC_ENTRY("content-type", "text/plain", HTTP_HEADER_CONTENT_TYPE),
+  STATIC_ENTRY("content-type", "text/plain;charset=utf-8", HTTP_HEADER_CONTENT_TYPE),
+  STATIC_ENTRY("range", "bytes=0-", HTTP_HEADER_RANGE),
+  STATIC_ENTRY("strict-transport-security", "max-age=31536000", HTTP_HEADER_STRICT_TRANSPORT_SECURITY),
+  STATIC_ENTRY("strict-transport-security", "max-age=31536000; includesubdomains", HTTP_HEADER_STRICT_TRANSPORT_SECURITY),
+  STATIC_ENTRY("strict-transport-security", "max-age=31536000; includesubdomains; preload", HTTP_HEADER_STRICT_TRANSPORT_SECURITY),
+  STATIC_ENTRY("vary", "accept-encoding", HTTP_HEADER_VARY),
+  STATIC_ENTRY("vary", "origin", HTTP_HEADER_VARY),
+  STATIC_ENTRY("x-content-type-options", "nosniff", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("x-xss-protection", "1; mode=block", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "100", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "204", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "206", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "302", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "400", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "403", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "421", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "425", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY(":status", "500", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("accept-language", "", HTTP_HEADER_ACCEPT_LANGUAGE),
+  STATIC_ENTRY("access-control-allow-credentials", "FALSE", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("access-control-allow-credentials", "TRUE", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("access-control-allow-headers", "*", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("access-control-allow-methods", "get", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("access-control-allow-methods", "get, post, options", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("access-control-allow-methods", "options", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("access-control-expose-headers", "content-length", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("access-control-request-headers", "content-type", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("access-control-request-method", "get", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("access-control-request-method", "post", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("alt-svc", "clear", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("authorization", "", HTTP_HEADER_AUTHORIZATION),
+  STATIC_ENTRY("content-security-policy", "script-src 'none'; object-src 'none'; base-uri 'none'", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("early-data", "1", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("expect-ct", "", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("forwarded", "", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("if-range", "", HTTP_HEADER_IF_RANGE),
+  STATIC_ENTRY("origin", "", HTTP_HEADER_ORIGIN),
+  STATIC_ENTRY("purpose", "prefetch", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("server", "", HTTP_HEADER_SERVER),
+  STATIC_ENTRY("timing-allow-origin", "*", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("upgrade-insecure-requests", "1", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("user-agent", "", HTTP_HEADER_USER_AGENT),
+  STATIC_ENTRY("x-forwarded-for", "", HTTP_HEADER_X_FORWARDED_FOR),
+  STATIC_ENTRY("x-frame-options", "deny", HTTP_HEADER_UNKNOWN),
+  STATIC_ENTRY("x-frame-options", "sameorigin", HTTP_HEADER_UNKNOWN)
+};
+
+static uint8_t find_static(const http_header_id_t id, const char *const name, const uint16_t name_len, const char *const value, const uint16_t value_len, uint8_t *const restrict name_index);
+static void reference(qpack_section_t *const restrict section, const uint32_t index);
+static void insert(http_qpack_encoder_t *const restrict encoder, qpack_section_t *const restrict section, const char *const name, const uint16_t name_len, const http_header_t *restrict header, const uint8_t static_name_index);
+static bool fits(const http_qpack_encoder_t *const restrict encoder, const qpack_section_t *const restrict section, const uint32_t entry_size);
+static bool acknowledge_section(http_qpack_encoder_t *const restrict encoder, const uint32_t stream_id);
+static void cancel_stream(http_qpack_encoder_t *const restrict encoder, const uint32_t stream_id);
+static bool required_insert_count(const http_qpack_decoder_t *const restrict decoder, const uint32_t encoded, uint32_t *const restrict required);
+static bool static_lookup(const uint32_t index, http_header_t *const restrict header, const bool name_only);
+static bool dynamic_lookup(const http_qpack_decoder_t *const restrict decoder, const uint32_t index, const uint32_t limit, http_header_t *const restrict header, const bool name_only, scratch_t *const restrict scratch);
+static bool receive_instruction(http_qpack_decoder_t *const restrict decoder, const char *cursor, const char *const end, scratch_t *const restrict scratch);
+static uint32_t instruction_len(const char *const start, const char *const end);
+static uint8_t integer_len(const char *const cursor, const char *const end, const uint8_t prefix_bits);
+
+//the table cannot outgrow what the peer accepts, the required insert count is encoded modulo its entries
+void http_qpack_encoder_init(http_qpack_encoder_t *const restrict encoder, void *const memory, const uint32_t capacity, const uint32_t max_table_capacity)
+{
+  *encoder = (http_qpack_encoder_t){ .max_entries = max_table_capacity / HTTP_HPACK_ENTRY_OVERHEAD };
+  http_hpack_table_init(&encoder->table, memory, MIN(capacity, max_table_capacity));
+}
+
+//the peer starts with an empty table of capacity 0 and grows it from the encoder stream
+void http_qpack_decoder_init(http_qpack_decoder_t *const restrict decoder, void *const memory, const uint32_t max_table_capacity)
+{
+  *decoder = (http_qpack_decoder_t){ .max_entries = max_table_capacity / HTTP_HPACK_ENTRY_OVERHEAD };
+  http_hpack_table_init(&decoder->table, memory, max_table_capacity);
+  decoder->table.max_size = 0;
+}
+
+uint32_t http_qpack_encode(http_qpack_encoder_t *const restrict encoder, const uint32_t stream_id, char *restrict buffer, const http_header_t *restrict headers, const uint16_t headers_count, char *restrict encoder_stream, uint32_t *const restrict encoder_stream_len)
+{
+  qpack_section_t section;
+  qpack_section_begin(encoder, &section, buffer, encoder_stream);
+
+  for (uint16_t i = 0; LIKELY(i < headers_count); i++)
+    qpack_section_encode(encoder, &section, &headers[i]);
+
+  return qpack_section_end(encoder, &section, stream_id, encoder_stream_len);
+}
+
+//a section can only be tracked, and so reference the dynamic table, while there is a free pending slot
+void qpack_section_begin(http_qpack_encoder_t *const restrict encoder, qpack_section_t *const restrict section, char *restrict buffer, char *restrict encoder_stream)
+{
+  const bool trackable = encoder->pending_count < HTTP_QPACK_MAX_PENDING;
+
+  *section = (qpack_section_t){
+    .buffer = buffer,
+    .cursor = buffer + PREFIX_MAX_SIZE,
+    .instructions = encoder_stream,
+    .instructions_start = encoder_stream,
+    .base = trackable * encoder->known_received_count,
+    .min_index = UINT32_MAX
+  };
+}
+
+//fully indexed when possible, otherwise a literal whose entry is inserted for the sections that follow, except for credentials
+void qpack_section_encode(http_qpack_encoder_t *const restrict encoder, qpack_section_t *const restrict section, const http_header_t *restrict header)
+{
+  const http_header_id_t id = known_id(header->id);
+
+  const char *name = header->key;
+  uint16_t name_len = header->key_len;
+  if (LIKELY(id != HTTP_HEADER_UNKNOWN))
+  {
+    name = header_names_str[id];
+    name_len = header_names_len[id] - STR_LEN(": ");
+  }
+
+  uint8_t static_name_index;
+  const uint8_t static_index = find_static(id, name, name_len, header->value, header->value_len, &static_name_index);
+  if (static_index != STATIC_NONE)
+  {
+    section->cursor += hpack_encode_integer(section->cursor, static_index, 6, 0xC0);
+    return;
+  }
+
+  uint16_t dynamic_name_index = 0;
+  uint16_t dynamic_index = 0;
+  if (encoder->table.max_size != 0)
+    dynamic_index = hpack_find_dynamic(&encoder->table, name, name_len, header->value, header->value_len, &dynamic_name_index);
+
+  if (dynamic_index != 0)
+  {
+    const uint32_t index = encoder->insert_count - dynamic_index;
+    if (index < section->base)
+    {
+      reference(section, index);
+      section->cursor += hpack_encode_integer(section->cursor, section->base - 1 - index, 6, 0x80);
+      return;
+    }
+  }
+
+  //the name is only referenced if the insert did not evict it
+  const uint32_t name_index = encoder->insert_count - dynamic_name_index;
+  const bool never_indexed = hpack_never_indexed(id);
+  if ((dynamic_index == 0) & !never_indexed)
+    insert(encoder, section, name, name_len, header, static_name_index);
+
+  const uint32_t oldest_index = encoder->insert_count - encoder->table.count;
+  const bool dynamic_name = (static_name_index == STATIC_NONE) & (dynamic_name_index != 0) & (name_index < section->base) & (name_index >= oldest_index);
+  if (dynamic_name)
+    reference(section, name_index);
+
+  const uint8_t never_indexed_bit = never_indexed << 5;
+  if (static_name_index != STATIC_NONE)
+    section->cursor += hpack_encode_integer(section->cursor, static_name_index, 4, 0x50 | never_indexed_bit);
+  else if (dynamic_name)
+    section->cursor += hpack_encode_integer(section->cursor, section->base - 1 - name_index, 4, 0x40 | never_indexed_bit);
+  else
+    section->cursor += hpack_encode_string(section->cursor, name, name_len, true, 3, 0x20 | (never_indexed_bit >> 1));
+  section->cursor += hpack_encode_string(section->cursor, header->value, header->value_len, false, 7, 0x00);
+}
+
+//the prefix is only known once every line is written, so the lines are moved right behind it
+uint32_t qpack_section_end(http_qpack_encoder_t *const restrict encoder, qpack_section_t *const restrict section, const uint32_t stream_id, uint32_t *const restrict encoder_stream_len)
+{
+  char prefix[PREFIX_MAX_SIZE];
+  uint8_t prefix_len;
+  const uint32_t required = section->required_insert_count;
+
+  if (required == 0)
+  {
+    prefix[0] = 0x00;
+    prefix[1] = 0x00;
+    prefix_len = 2;
+  }
+  else
+  {
+    const uint32_t encoded = (required % (2 * encoder->max_entries)) + 1;
+    prefix_len = hpack_encode_integer(prefix, encoded, 8, 0x00);
+    prefix_len += hpack_encode_integer(prefix + prefix_len, section->base - required, 7, 0x00);
+
+    encoder->pending[encoder->pending_count++] = (http_qpack_pending_t){ stream_id, section->min_index };
+  }
+
+  const uint32_t lines_len = section->cursor - (section->buffer + PREFIX_MAX_SIZE);
+  memmove(section->buffer + prefix_len, section->buffer + PREFIX_MAX_SIZE, lines_len);
+  memcpy(section->buffer, prefix, prefix_len);
+
+  *encoder_stream_len = section->instructions - section->instructions_start;
+  return prefix_len + lines_len;
+}
+
+//Section Acknowledgment, Stream Cancellation and Insert Count Increment from the decoder stream
+uint32_t http_qpack_encoder_receive(http_qpack_encoder_t *const restrict encoder, const char *restrict buffer, const uint32_t buffer_size)
+{
+  const char *cursor = buffer;
+  const char *const end = buffer + buffer_size;
+
+  while (LIKELY(cursor < end))
+  {
+    const uint8_t byte = *cursor;
+    const uint8_t prefix_bits = (byte & 0x80) ? 7 : 6;
+    if (UNLIKELY(integer_len(cursor, end, prefix_bits) == 0))
+      break;
+
+    uint32_t value;
+    if (UNLIKELY(!hpack_decode_integer(&cursor, end, prefix_bits, &value)))
+      return 0;
+
+    if (byte & 0x80)
+    {
+      if (UNLIKELY(!acknowledge_section(encoder, value)))
+        return 0;
+    }
+    else if (byte & 0x40)
+      cancel_stream(encoder, value);
+    else
+    {
+      const bool valid = (value != 0) & (value <= encoder->insert_count - encoder->known_received_count);
+      if (UNLIKELY(!valid))
+        return 0;
+      encoder->known_received_count += value;
+    }
+  }
+
+  const uint32_t consumed = cursor - buffer;
+  return (consumed != 0) ? consumed : HTTP_NEED_MORE;
+}
+
+//literals that are not huffman encoded are left in the block, everything else is written to scratch
+uint32_t http_qpack_decode(http_qpack_decoder_t *const restrict decoder, char *restrict block, const uint32_t block_len, http_header_t *restrict headers, uint16_t *const restrict headers_count, char *restrict scratch, const uint32_t scratch_size)
+{
+  const char *cursor = block;
+  const char *const end = block + block_len;
+  scratch_t scratch_space = { scratch, scratch + scratch_size };
+  const uint16_t max_headers = *headers_count;
+  uint16_t count = 0;
+
+  uint32_t encoded;
+  uint32_t required;
+  uint32_t delta;
+  bool valid = hpack_decode_integer(&cursor, end, 8, &encoded) && required_insert_count(decoder, encoded, &required) && (cursor < end);
+  const bool negative = valid && (*cursor & 0x80);
+  valid = valid && hpack_decode_integer(&cursor, end, 7, &delta);
+  valid = valid && (negative ? (delta < required) : (delta <= UINT32_MAX - required));
+  if (UNLIKELY(!valid))
+    return 0;
+
+  const uint32_t base = negative ? required - delta - 1 : required + delta;
+  if (UNLIKELY(required > decoder->insert_count))
+    return HTTP_NEED_MORE;
+
+  //one past the highest absolute index referenced, which must be the Required Insert Count
+  uint32_t highest = 0;
+
+  while (LIKELY(cursor < end))
+  {
+    if (UNLIKELY(count == max_headers))
+      return 0;
+    http_header_t *const header = &headers[count++];
+    *header = (http_header_t){ .id = HTTP_HEADER_UNKNOWN };
+
+    const uint8_t byte = *cursor;
+    uint32_t index;
+    bool literal_value = true;
+    bool dynamic = false;
+
+    if (byte & 0x80)
+    {
+      valid = hpack_decode_integer(&cursor, end, 6, &index);
+      literal_value = false;
+      dynamic = !(byte & 0x40);
+      if (dynamic)
+      {
+        valid &= index < base;
+        index = base - 1 - index;
+      }
+      else
+        valid = valid && static_lookup(index, header, false);
+    }
+    else if (byte & 0x40)
+    {
+      valid = hpack_decode_integer(&cursor, end, 4, &index);
+      dynamic = !(byte & 0x10);
+      if (dynamic)
+      {
+        valid &= index < base;
+        index = base - 1 - index;
+      }
+      else
+        valid = valid && static_lookup(index, header, true);
+    }
+    else if (byte & 0x20)
+    {
+      valid = hpack_decode_string(&cursor, end, 3, &header->key, &header->key_len, &scratch_space);
+      header->id = valid ? lookup_header_id(header->key, header->key_len) : HTTP_HEADER_UNKNOWN;
+    }
+    else
+    {
+      //post-base indices count up from Base, towards the entries inserted after it
+      literal_value = !(byte & 0x10);
+      valid = hpack_decode_integer(&cursor, end, literal_value ? 3 : 4, &index);
+      dynamic = true;
+      valid &= index < required - MIN(base, required);
+      index += base;
+    }
+
+    if (dynamic)
+    {
+      valid = valid && dynamic_lookup(decoder, index, required, header, literal_value, &scratch_space);
+      highest = MAX(highest, index + 1);
+    }
+    if (literal_value)
+      valid = valid && hpack_decode_string(&cursor, end, 7, &header->value, &header->value_len, &scratch_space);
+    if (UNLIKELY(!valid))
+      return 0;
+  }
+
+  if (UNLIKELY(highest != required))
+    return 0;
+
+  decoder->required_insert_count = required;
+  *headers_count = count;
+  return block_len;
+}
+
+//every complete instruction is applied, a partial one is left for the next call
+uint32_t http_qpack_decoder_receive(http_qpack_decoder_t *const restrict decoder, char *restrict buffer, const uint32_t buffer_size, char *restrict scratch, const uint32_t scratch_size)
+{
+  const char *cursor = buffer;
+  const char *const end = buffer + buffer_size;
+
+  while (LIKELY(cursor < end))
+  {
+    const uint32_t len = instruction_len(cursor, end);
+    if (len == 0)
+      break;
+
+    scratch_t scratch_space = { scratch, scratch + scratch_size };
+    if (UNLIKELY(!receive_instruction(decoder, cursor, cursor + len, &scratch_space)))
+      return 0;
+    cursor += len;
+  }
+
+  const uint32_t consumed = cursor - buffer;
+  return (consumed != 0) ? consumed : HTTP_NEED_MORE;
+}
+
+//nothing to acknowledge when the last field section did not reference the dynamic table
+uint8_t http_qpack_encode_section_ack(http_qpack_decoder_t *const restrict decoder, char *restrict buffer, const uint32_t stream_id)
+{
+  const uint32_t required = decoder->required_insert_count;
+  if (required == 0)
+    return 0;
+
+  decoder->required_insert_count = 0;
+  decoder->acknowledged_count = MAX(decoder->acknowledged_count, required);
+  return hpack_encode_integer(buffer, stream_id, 7, 0x80);
+}
+
+//the inserts the peer has not seen acknowledged yet, by a section or by a previous increment
+uint8_t http_qpack_encode_insert_count(http_qpack_decoder_t *const restrict decoder, char *restrict buffer)
+{
+  const uint32_t increment = decoder->insert_count - decoder->acknowledged_count;
+  if (increment == 0)
+    return 0;
+
+  decoder->acknowledged_count = decoder->insert_count;
+  return hpack_encode_integer(buffer, increment, 6, 0x00);
+}
+
+uint8_t http_qpack_encode_stream_cancel(char *restrict buffer, const uint32_t stream_id)
+{
+  return hpack_encode_integer(buffer, stream_id, 6, 0x40);
+}
+
+//well-known headers are matched by id, the others by name
+static uint8_t find_static(const http_header_id_t id, const char *const name, const uint16_t name_len, const char *const value, const uint16_t value_len, uint8_t *const restrict name_index)
+{
+  *name_index = STATIC_NONE;
+
+  for (uint8_t i = 0; i < STATIC_TABLE_SIZE; i++)
+  {
+    const static_entry_t *const entry = &static_table[i];
+    const bool named = (id != HTTP_HEADER_UNKNOWN) ? (entry->id == id) : ((entry->id == HTTP_HEADER_UNKNOWN) && equals_caseless(name, name_len, entry->name, entry->name_len));
+    if (!named)
+      continue;
+
+    if (*name_index == STATIC_NONE)
+      *name_index = i;
+    if ((entry->value_len == value_len) && (memcmp(entry->value, value, value_len) == 0))
+      return i;
+  }
+
+  return STATIC_NONE;
+}
+
+static void reference(qpack_section_t *const restrict section, const uint32_t index)
+{
+  section->min_index = MIN(section->min_index, index);
+  section->required_insert_count = MAX(section->required_insert_count, index + 1);
+}
+
+//the capacity is announced right before the first insert, the peer starts from 0
+static void insert(http_qpack_encoder_t *const restrict encoder, qpack_section_t *const restrict section, const char *const name, const uint16_t name_len, const http_header_t *restrict header, const uint8_t static_name_index)
+{
+  const uint32_t entry_size = name_len + header->value_len + HTTP_HPACK_ENTRY_OVERHEAD;
+  if (!fits(encoder, section, entry_size))
+    return;
+
+  if (UNLIKELY(!encoder->capacity_sent))
+  {
+    section->instructions += hpack_encode_integer(section->instructions, encoder->table.max_size, 5, 0x20);
+    encoder->capacity_sent = true;
+  }
+
+  if (static_name_index != STATIC_NONE)
+    section->instructions += hpack_encode_integer(section->instructions, static_name_index, 6, 0xC0);
+  else
+    section->instructions += hpack_encode_string(section->instructions, name, name_len, true, 5, 0x40);
+  section->instructions += hpack_encode_string(section->instructions, header->value, header->value_len, false, 7, 0x00);
+
+  hpack_table_insert(&encoder->table, name, name_len, header->value, header->value_len, known_id(header->id), true);
+  encoder->insert_count++;
+}
+
+//whether the entry fits once the oldest entries, that no pending or current section references, are evicted
+static bool fits(const http_qpack_encoder_t *const restrict encoder, const qpack_section_t *const restrict section, const uint32_t entry_size)
+{
+  const http_hpack_table_t *const table = &encoder->table;
+  if (entry_size > table->max_size)
+    return false;
+
+  uint32_t limit = section->min_index;
+  for (uint8_t i = 0; i < encoder->pending_count; i++)
+    limit = MIN(limit, encoder->pending[i].min_index);
+
+  uint32_t size = table->size;
+  uint32_t index = encoder->insert_count - table->count;
+  for (uint16_t i = table->count; size + entry_size > table->max_size; i--, index++)
+  {
+    if (index >= limit)
+      return false;
+
+    const http_hpack_entry_t *const entry = hpack_table_entry(table, i);
+    size -= entry->name_len + entry->value_len + HTTP_HPACK_ENTRY_OVERHEAD;
+  }
+
+  return true;
+}
+
+//sections of a stream are acknowledged in the order they were sent
+static bool acknowledge_section(http_qpack_encoder_t *const restrict encoder, const uint32_t stream_id)
+{
+  for (uint8_t i = 0; i < encoder->pending_count; i++)
+  {
+    if (encoder->pending[i].stream_id != stream_id)
+      continue;
+
+    encoder->pending_count--;
+    memmove(&encoder->pending[i], &encoder->pending[i + 1], (encoder->pending_count - i) * sizeof(http_qpack_pending_t));
+    return true;
+  }
+
+  return false;
+}
+
+static void cancel_stream(http_qpack_encoder_t *const restrict encoder, const uint32_t stream_id)
+{
+  uint8_t kept = 0;
+
+  for (uint8_t i = 0; i < encoder->pending_count; i++)
+  {
+    if (encoder->pending[i].stream_id != stream_id)
+      encoder->pending[kept++] = encoder->pending[i];
+  }
+
+  encoder->pending_count = kept;
+}
+
+//RFC 9204 section 4.5.1.1, the count is sent modulo twice the number of entries the table can hold
+static bool required_insert_count(const http_qpack_decoder_t *const restrict decoder, const uint32_t encoded, uint32_t *const restrict required)
+{
+  *required = 0;
+  if (encoded == 0)
+    return true;
+
+  const uint64_t full_range = 2 * (uint64_t)decoder->max_entries;
+  if (UNLIKELY(encoded > full_range))
+    return false;
+
+  const uint64_t max_value = (uint64_t)decoder->insert_count + decoder->max_entries;
+  uint64_t count = (max_value / full_range) * full_range + encoded - 1;
+  if (count > max_value)
+  {
+    if (UNLIKELY(count <= full_range))
+      return false;
+    count -= full_range;
+  }
+
+  *required = count;
+  return (count != 0) & (count <= UINT32_MAX);
+}
+
+static bool static_lookup(const uint32_t index, http_header_t *const restrict header, const bool name_only)
+{
+  if (UNLIKELY(index >= STATIC_TABLE_SIZE))
+    return false;
+
+  const static_entry_t *const entry = &static_table[index];
+  header->key = (char *)entry->name;
+  header->key_len = entry->name_len;
+  header->id = entry->id;
+  if (!name_only)
+  {
+    header->value = (char *)entry->value;
+    header->value_len = entry->value_len;
+  }
+  return true;
+}
+
+//entries are copied out: an insert, or a later header of the same section, may evict them
+static bool dynamic_lookup(const http_qpack_decoder_t *const restrict decoder, const uint32_t index, const uint32_t limit, http_header_t *const restrict header, const bool name_only, scratch_t *const restrict scratch)
+{
+  const uint32_t relative = decoder->insert_count - index;
+  if (UNLIKELY((index >= limit) | (relative > decoder->table.count)))
+    return false;
+
+  const http_hpack_entry_t entry = *hpack_table_entry(&decoder->table, relative);
+  const uint32_t len = entry.name_len + (!name_only * entry.value_len);
+  if (UNLIKELY(len > (uint32_t)(scratch->end - scratch->cursor)))
+    return false;
+
+  char *const copy = scratch->cursor;
+  hpack_ring_read(&decoder->table, copy, entry.offset, len);
+  scratch->cursor += len;
+
+  header->key = copy;
+  header->key_len = entry.name_len;
+  header->id = entry.id;
+  if (!name_only)
+  {
+    header->value = copy + entry.name_len;
+    header->value_len = entry.value_len;
+  }
+  return true;
+}
+
+//Set Dynamic Table Capacity, Insert With Name Reference, Insert With Literal Name and Duplicate
+static bool receive_instruction(http_qpack_decoder_t *const restrict decoder, const char *cursor, const char *const end, scratch_t *const restrict scratch)
+{
+  http_hpack_table_t *const table = &decoder->table;
+  http_header_t field = { .id = HTTP_HEADER_UNKNOWN };
+  const uint8_t byte = *cursor;
+  uint32_t index;
+  bool valid;
+
+  if ((byte & 0xE0) == 0x20)
+  {
+    valid = hpack_decode_integer(&cursor, end, 5, &index) && (index <= table->capacity);
+    if (UNLIKELY(!valid))
+      return false;
+
+    table->max_size = index;
+    hpack_table_evict(table, index);
+    return true;
+  }
+
+  if (byte & 0x80)
+  {
+    valid = hpack_decode_integer(&cursor, end, 6, &index);
+    if (byte & 0x40)
+      valid = valid && static_lookup(index, &field, true);
+    else
+      valid = valid && (index < decoder->insert_count) && dynamic_lookup(decoder, decoder->insert_count - 1 - index, decoder->insert_count, &field, true, scratch);
+    valid = valid && hpack_decode_string(&cursor, end, 7, &field.value, &field.value_len, scratch);
+  }
+  else if (byte & 0x40)
+  {
+    valid = hpack_decode_string(&cursor, end, 5, &field.key, &field.key_len, scratch);
+    valid = valid && hpack_decode_string(&cursor, end, 7, &field.value, &field.value_len, scratch);
+    field.id = valid ? lookup_header_id(field.key, field.key_len) : HTTP_HEADER_UNKNOWN;
+  }
+  else
+  {
+    valid = hpack_decode_integer(&cursor, end, 5, &index);
+    valid = valid && (index < decoder->insert_count) && dynamic_lookup(decoder, decoder->insert_count - 1 - index, decoder->insert_count, &field, false, scratch);
+  }
+
+  valid = valid && ((uint32_t)(field.key_len + field.value_len + HTTP_HPACK_ENTRY_OVERHEAD) <= table->max_size);
+  if (UNLIKELY(!valid))
+    return false;
+
+  hpack_table_insert(table, field.key, field.key_len, field.value, field.value_len, field.id, false);
+  decoder->insert_count++;
+  return true;
+}
+
+//bytes the next encoder instruction takes, 0 if it has not been received whole yet
+static uint32_t instruction_len(const char *const start, const char *const end)
+{
+  const char *cursor = start;
+  const uint8_t byte = *cursor;
+  const bool literal_name = (byte & 0xC0) == 0x40;
+  const bool has_value = byte & 0xC0;
+  const uint8_t prefix_bits = (byte & 0x80) ? 6 : 5;
+
+  for (uint8_t field = 0; field <= has_value; field++)
+  {
+    const bool string = (field == 1) | literal_name;
+    const uint8_t bits = (field == 1) ? 7 : prefix_bits;
+    const uint8_t len = integer_len(cursor, end, bits);
+    if (len == 0)
+      return 0;
+
+    uint32_t length = 0;
+    const char *str = cursor;
+    if (string && UNLIKELY(!hpack_decode_integer(&str, end, bits, &length)))
+      return (cursor - start) + len;
+    if (length > (uint32_t)(end - cursor) - len)
+      return 0;
+    cursor += len + length;
+  }
+
+  return cursor - start;
+}
+
+//0 if the integer is cut short. An overlong one is reported whole, for the decoding to reject it
+static uint8_t integer_len(const char *const cursor, const char *const end, const uint8_t prefix_bits)
+{
+  if (UNLIKELY(cursor == end))
+    return 0;
+
+  const uint8_t max_prefix = (1 << prefix_bits) - 1;
+  if (LIKELY(((uint8_t)*cursor & max_prefix) != max_prefix))
+    return 1;
+
+  const uint32_t available = end - cursor;
+  for (uint8_t len = 1; len < INTEGER_MAX_SIZE; len++)
+  {
+    if (len == available)
+      return 0;
+    if (!(cursor[len] & 0x80))
+      return len + 1;
+  }
+
+  return INTEGER_MAX_SIZE;
+}
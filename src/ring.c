@@ -0,0 +1,158 @@
+/*================================================================================
+
+File: ring.c                                                                    
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-03-08 16:02:47                                                 
+last edited: 2025-03-15 12:17:44                                                
+
+================================================================================*/
+
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+
+#include "common.h"
+#include "ring.h"
+
+static inline uint32_t round_size(uint32_t size);
+static char *map_mirrored(const int fd, const uint32_t size);
+
+int32_t http_ring_init(http_ring_t *const restrict ring, const uint32_t size)
+{
+  const uint32_t ring_size = round_size(size);
+  if (UNLIKELY(ring_size == 0))
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  const int fd = memfd_create("flashhttp_ring", MFD_CLOEXEC);
+  if (UNLIKELY(fd == -1))
+    return -1;
+
+  char *data = MAP_FAILED;
+  if (LIKELY(ftruncate(fd, ring_size) == 0))
+    data = map_mirrored(fd, ring_size);
+
+  const int saved_errno = errno;
+  close(fd);
+  if (UNLIKELY(data == MAP_FAILED))
+  {
+    errno = saved_errno;
+    return -1;
+  }
+
+  *ring = (http_ring_t){ .data = data, .size = ring_size };
+
+  return 0;
+}
+
+void http_ring_destroy(http_ring_t *const restrict ring)
+{
+  munmap(ring->data, (size_t)ring->size << 1);
+
+  *ring = (http_ring_t){0};
+}
+
+char *http_ring_read_ptr(const http_ring_t *const restrict ring)
+{
+  return ring->data + (ring->head & (ring->size - 1));
+}
+
+uint32_t http_ring_readable(const http_ring_t *const restrict ring)
+{
+  return ring->tail - ring->head;
+}
+
+char *http_ring_write_ptr(const http_ring_t *const restrict ring)
+{
+  return ring->data + (ring->tail & (ring->size - 1));
+}
+
+uint32_t http_ring_writable(const http_ring_t *const restrict ring)
+{
+  return ring->size - (ring->tail - ring->head);
+}
+
+void http_ring_consume(http_ring_t *const restrict ring, const uint32_t len)
+{
+  ring->head += len;
+}
+
+void http_ring_produce(http_ring_t *const restrict ring, const uint32_t len)
+{
+  ring->tail += len;
+}
+
+//a read of 0 bytes would return 0 and look like the peer closed the connection
+int64_t http_ring_recv(http_ring_t *const restrict ring, const int fd)
+{
+  if (UNLIKELY(http_ring_writable(ring) == 0))
+  {
+    errno = ENOBUFS;
+    return -1;
+  }
+
+  ssize_t received;
+  do
+    received = read(fd, http_ring_write_ptr(ring), http_ring_writable(ring));
+  while (UNLIKELY((received == -1) & (errno == EINTR)));
+
+  if (LIKELY(received > 0))
+    ring->tail += received;
+
+  return received;
+}
+
+int64_t http_ring_send(http_ring_t *const restrict ring, const int fd)
+{
+  if (UNLIKELY(http_ring_readable(ring) == 0))
+  {
+    errno = ENODATA;
+    return -1;
+  }
+
+  ssize_t sent;
+  do
+    sent = write(fd, http_ring_read_ptr(ring), http_ring_readable(ring));
+  while (UNLIKELY((sent == -1) & (errno == EINTR)));
+
+  if (LIKELY(sent > 0))
+    ring->head += sent;
+
+  return sent;
+}
+
+//a power of two number of pages, so that positions wrap with a mask. 0 if too big
+static inline uint32_t round_size(uint32_t size)
+{
+  const uint32_t page_size = sysconf(_SC_PAGESIZE);
+
+  size = (size < page_size) ? page_size : size;
+  if (UNLIKELY(size > (UINT32_MAX >> 1) + 1))
+    return 0;
+
+  return (size & (size - 1)) ? 1U << (32 - __builtin_clz(size)) : size;
+}
+
+//reserves both halves at once so that nothing else can be mapped in between, then maps the file over each
+static char *map_mirrored(const int fd, const uint32_t size)
+{
+  char *const data = mmap(NULL, (size_t)size << 1, PROT_NONE, MAP_PRIVATE | MAP_ANONYMOUS, -1, 0);
+  if (UNLIKELY(data == MAP_FAILED))
+    return MAP_FAILED;
+
+  const bool mapped = (mmap(data, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED) &&
+    (mmap(data + size, size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_FIXED, fd, 0) != MAP_FAILED);
+  if (UNLIKELY(!mapped))
+  {
+    const int saved_errno = errno;
+    munmap(data, (size_t)size << 1);
+    errno = saved_errno;
+    return MAP_FAILED;
+  }
+
+  return data;
+}
@@ -5,12 +5,19 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-02-11 12:37:26                                                 
-last edited: 2025-03-05 21:04:20                                                
+last edited: 2025-03-15 13:27:18                                                
 
 ================================================================================*/
 
 #include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <fcntl.h>
 #include <sys/uio.h>
+#include <sys/sendfile.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <linux/errqueue.h>
 
 #include "common.h"
 #include "serializer.h"
@@ -27,45 +34,229 @@ last edited: 2025-03-05 21:04:20
 
 #endif
 
-constexpr char methods_str[][sizeof(uint64_t)] ALIGNED(64) = {
-  [HTTP_GET] = "GET",
-  [HTTP_HEAD] = "HEAD",
-  [HTTP_POST] = "POST",
-  [HTTP_PUT] = "PUT",
-  [HTTP_DELETE] = "DELETE",
-  [HTTP_OPTIONS] = "OPTIONS",
-  [HTTP_TRACE] = "TRACE",
-  [HTTP_PATCH] = "PATCH",
-  [HTTP_CONNECT] = "CONNECT"
-};
-constexpr uint8_t methods_len[] = {
-  [HTTP_GET] = STR_LEN("GET"),
-  [HTTP_HEAD] = STR_LEN("HEAD"),
-  [HTTP_POST] = STR_LEN("POST"),
-  [HTTP_PUT] = STR_LEN("PUT"),
-  [HTTP_DELETE] = STR_LEN("DELETE"),
-  [HTTP_OPTIONS] = STR_LEN("OPTIONS"),
-  [HTTP_TRACE] = STR_LEN("TRACE"),
-  [HTTP_PATCH] = STR_LEN("PATCH"),
-  [HTTP_CONNECT] = STR_LEN("CONNECT")
-};
+//longest start line that is staged by copy, followed by the longest Content-Length line
+# define CONTENT_LENGTH_SIZE (STR_LEN("Content-Length: 4294967295\r\n"))
+# define HEAD_RESERVE (sizeof(uint64_t) + COPY_THRESHOLD + sizeof(uint64_t) + sizeof(clrf) + CONTENT_LENGTH_SIZE)
 
-constexpr char versions_str[][sizeof(uint64_t)] ALIGNED(64) = {
-  [HTTP_1_0] = "HTTP/1.0",
-  [HTTP_1_1] = "HTTP/1.1",
-  [HTTP_2_0] = "HTTP/2.0",
-  [HTTP_3_0] = "HTTP/3.0"
-};
-constexpr uint8_t versions_len[] = {
-  [HTTP_1_0] = STR_LEN("HTTP/1.0"),
-  [HTTP_1_1] = STR_LEN("HTTP/1.1"),
-  [HTTP_2_0] = STR_LEN("HTTP/2.0"),
-  [HTTP_3_0] = STR_LEN("HTTP/3.0")
-};
+//small fields are packed in buffer[run, cursor) until a large one forces the run out as one iovec
+typedef struct
+{
+  struct iovec *iov;
+  char *run;
+  char *cursor;
+  const char *end;
+  uint16_t iovcnt;
+} staging_t;
 
 constexpr char clrf[sizeof(uint16_t)] = "\r\n";
 constexpr char colon_space[sizeof(uint16_t)] = ": ";
 
+//"00" to "99", so integers are formatted two digits per lookup
+constexpr char digit_pairs[200] =
+  "0001020304050607080910111213141516171819"
+  "2021222324252627282930313233343536373839"
+  "4041424344454647484950515253545556575859"
+  "6061626364656667686970717273747576777879"
+  "8081828384858687888990919293949596979899";
+
+//powers_of_10[i] is the smallest number with i + 1 digits
+constexpr uint32_t powers_of_10[10] = {
+  0, 10, 100, 1'000, 10'000, 100'000, 1'000'000, 10'000'000, 100'000'000, 1'000'000'000
+};
+
+//index into status_lines_str, 0 for unregistered status codes
+constexpr uint8_t status_lines_idx[600] = {
+  [100] = 1,
+  [101] = 2,
+  [102] = 3,
+  [103] = 4,
+  [200] = 5,
+  [201] = 6,
+  [202] = 7,
+  [203] = 8,
+  [204] = 9,
+  [205] = 10,
+  [206] = 11,
+  [207] = 12,
+  [208] = 13,
+  [226] = 14,
+  [300] = 15,
+  [301] = 16,
+  [302] = 17,
+  [303] = 18,
+  [304] = 19,
+  [305] = 20,
+  [307] = 21,
+  [308] = 22,
+  [400] = 23,
+  [401] = 24,
+  [402] = 25,
+  [403] = 26,
+  [404] = 27,
+  [405] = 28,
+  [406] = 29,
+  [407] = 30,
+  [408] = 31,
+  [409] = 32,
+  [410] = 33,
+  [411] = 34,
+  [412] = 35,
+  [413] = 36,
+  [414] = 37,
+  [415] = 38,
+  [416] = 39,
+  [417] = 40,
+  [421] = 41,
+  [422] = 42,
+  [423] = 43,
+  [424] = 44,
+  [425] = 45,
+  [426] = 46,
+  [428] = 47,
+  [429] = 48,
+  [431] = 49,
+  [451] = 50,
+  [500] = 51,
+  [501] = 52,
+  [502] = 53,
+  [503] = 54,
+  [504] = 55,
+  [505] = 56,
+  [506] = 57,
+  [507] = 58,
+  [508] = 59,
+  [510] = 60,
+  [511] = 61
+};
+constexpr char status_lines_str[][48] ALIGNED(64) = {
+  [0] = "",
+  [1] = " 100 Continue\r\n",
+  [2] = " 101 Switching Protocols\r\n",
+  [3] = " 102 Processing\r\n",
+  [4] = " 103 Early Hints\r\n",
+  [5] = " 200 OK\r\n",
+  [6] = " 201 Created\r\n",
+  [7] = " 202 Accepted\r\n",
+  [8] = " 203 Non-Authoritative Information\r\n",
+  [9] = " 204 No Content\r\n",
+  [10] = " 205 Reset Content\r\n",
+  [11] = " 206 Partial Content\r\n",
+  [12] = " 207 Multi-Status\r\n",
+  [13] = " 208 Already Reported\r\n",
+  [14] = " 226 IM Used\r\n",
+  [15] = " 300 Multiple Choices\r\n",
+  [16] = " 301 Moved Permanently\r\n",
+  [17] = " 302 Found\r\n",
+  [18] = " 303 See Other\r\n",
+  [19] = " 304 Not Modified\r\n",
+  [20] = " 305 Use Proxy\r\n",
+  [21] = " 307 Temporary Redirect\r\n",
+  [22] = " 308 Permanent Redirect\r\n",
+  [23] = " 400 Bad Request\r\n",
+  [24] = " 401 Unauthorized\r\n",
+  [25] = " 402 Payment Required\r\n",
+  [26] = " 403 Forbidden\r\n",
+  [27] = " 404 Not Found\r\n",
+  [28] = " 405 Method Not Allowed\r\n",
+  [29] = " 406 Not Acceptable\r\n",
+  [30] = " 407 Proxy Authentication Required\r\n",
+  [31] = " 408 Request Timeout\r\n",
+  [32] = " 409 Conflict\r\n",
+  [33] = " 410 Gone\r\n",
+  [34] = " 411 Length Required\r\n",
+  [35] = " 412 Precondition Failed\r\n",
+  [36] = " 413 Content Too Large\r\n",
+  [37] = " 414 URI Too Long\r\n",
+  [38] = " 415 Unsupported Media Type\r\n",
+  [39] = " 416 Range Not Satisfiable\r\n",
+  [40] = " 417 Expectation Failed\r\n",
+  [41] = " 421 Misdirected Request\r\n",
+  [42] = " 422 Unprocessable Content\r\n",
+  [43] = " 423 Locked\r\n",
+  [44] = " 424 Failed Dependency\r\n",
+  [45] = " 425 Too Early\r\n",
+  [46] = " 426 Upgrade Required\r\n",
+  [47] = " 428 Precondition Required\r\n",
+  [48] = " 429 Too Many Requests\r\n",
+  [49] = " 431 Request Header Fields Too Large\r\n",
+  [50] = " 451 Unavailable For Legal Reasons\r\n",
+  [51] = " 500 Internal Server Error\r\n",
+  [52] = " 501 Not Implemented\r\n",
+  [53] = " 502 Bad Gateway\r\n",
+  [54] = " 503 Service Unavailable\r\n",
+  [55] = " 504 Gateway Timeout\r\n",
+  [56] = " 505 HTTP Version Not Supported\r\n",
+  [57] = " 506 Variant Also Negotiates\r\n",
+  [58] = " 507 Insufficient Storage\r\n",
+  [59] = " 508 Loop Detected\r\n",
+  [60] = " 510 Not Extended\r\n",
+  [61] = " 511 Network Authentication Required\r\n"
+};
+constexpr uint8_t status_lines_len[] = {
+  [0] = 0,
+  [1] = STR_LEN(" 100 Continue\r\n"),
+  [2] = STR_LEN(" 101 Switching Protocols\r\n"),
+  [3] = STR_LEN(" 102 Processing\r\n"),
+  [4] = STR_LEN(" 103 Early Hints\r\n"),
+  [5] = STR_LEN(" 200 OK\r\n"),
+  [6] = STR_LEN(" 201 Created\r\n"),
+  [7] = STR_LEN(" 202 Accepted\r\n"),
+  [8] = STR_LEN(" 203 Non-Authoritative Information\r\n"),
+  [9] = STR_LEN(" 204 No Content\r\n"),
+  [10] = STR_LEN(" 205 Reset Content\r\n"),
+  [11] = STR_LEN(" 206 Partial Content\r\n"),
+  [12] = STR_LEN(" 207 Multi-Status\r\n"),
+  [13] = STR_LEN(" 208 Already Reported\r\n"),
+  [14] = STR_LEN(" 226 IM Used\r\n"),
+  [15] = STR_LEN(" 300 Multiple Choices\r\n"),
+  [16] = STR_LEN(" 301 Moved Permanently\r\n"),
+  [17] = STR_LEN(" 302 Found\r\n"),
+  [18] = STR_LEN(" 303 See Other\r\n"),
+  [19] = STR_LEN(" 304 Not Modified\r\n"),
+  [20] = STR_LEN(" 305 Use Proxy\r\n"),
+  [21] = STR_LEN(" 307 Temporary Redirect\r\n"),
+  [22] = STR_LEN(" 308 Permanent Redirect\r\n"),
+  [23] = STR_LEN(" 400 Bad Request\r\n"),
+  [24] = STR_LEN(" 401 Unauthorized\r\n"),
+  [25] = STR_LEN(" 402 Payment Required\r\n"),
+  [26] = STR_LEN(" 403 Forbidden\r\n"),
+  [27] = STR_LEN(" 404 Not Found\r\n"),
+  [28] = STR_LEN(" 405 Method Not Allowed\r\n"),
+  [29] = STR_LEN(" 406 Not Acceptable\r\n"),
+  [30] = STR_LEN(" 407 Proxy Authentication Required\r\n"),
+  [31] = STR_LEN(" 408 Request Timeout\r\n"),
+  [32] = STR_LEN(" 409 Conflict\r\n"),
+  [33] = STR_LEN(" 410 Gone\r\n"),
+  [34] = STR_LEN(" 411 Length Required\r\n"),
+  [35] = STR_LEN(" 412 Precondition Failed\r\n"),
+  [36] = STR_LEN(" 413 Content Too Large\r\n"),
+  [37] = STR_LEN(" 414 URI Too Long\r\n"),
+  [38] = STR_LEN(" 415 Unsupported Media Type\r\n"),
+  [39] = STR_LEN(" 416 Range Not Satisfiable\r\n"),
+  [40] = STR_LEN(" 417 Expectation Failed\r\n"),
+  [41] = STR_LEN(" 421 Misdirected Request\r\n"),
+  [42] = STR_LEN(" 422 Unprocessable Content\r\n"),
+  [43] = STR_LEN(" 423 Locked\r\n"),
+  [44] = STR_LEN(" 424 Failed Dependency\r\n"),
+  [45] = STR_LEN(" 425 Too Early\r\n"),
+  [46] = STR_LEN(" 426 Upgrade Required\r\n"),
+  [47] = STR_LEN(" 428 Precondition Required\r\n"),
+  [48] = STR_LEN(" 429 Too Many Requests\r\n"),
+  [49] = STR_LEN(" 431 Request Header Fields Too Large\r\n"),
+  [50] = STR_LEN(" 451 Unavailable For Legal Reasons\r\n"),
+  [51] = STR_LEN(" 500 Internal Server Error\r\n"),
+  [52] = STR_LEN(" 501 Not Implemented\r\n"),
+  [53] = STR_LEN(" 502 Bad Gateway\r\n"),
+  [54] = STR_LEN(" 503 Service Unavailable\r\n"),
+  [55] = STR_LEN(" 504 Gateway Timeout\r\n"),
+  [56] = STR_LEN(" 505 HTTP Version Not Supported\r\n"),
+  [57] = STR_LEN(" 506 Variant Also Negotiates\r\n"),
+  [58] = STR_LEN(" 507 Insufficient Storage\r\n"),
+  [59] = STR_LEN(" 508 Loop Detected\r\n"),
+  [60] = STR_LEN(" 510 Not Extended\r\n"),
+  [61] = STR_LEN(" 511 Network Authentication Required\r\n")
+};
+
 CONSTRUCTOR void http_serializer_init(void)
 {
 #ifdef __AVX512F__
@@ -81,16 +272,31 @@ CONSTRUCTOR void http_serializer_init(void)
 #endif
 }
 
+static inline void staging_reset(staging_t *restrict staging, struct iovec *restrict iov, char *restrict buffer, const uint16_t buffer_size);
+static inline void stage_copy(staging_t *restrict staging, const char *restrict src, const uint32_t len);
+static inline void stage_scatter(staging_t *restrict staging, const char *restrict src, const uint32_t len);
+static inline void stage_close(staging_t *restrict staging);
+static void stage_request(staging_t *restrict staging, const http_request_t *restrict request);
+static void stage_request_head(staging_t *restrict staging, const http_request_t *restrict request, const uint32_t content_length);
+static bool send_zerocopy(http_zerocopy_t *restrict tracker, const char *restrict body, uint32_t body_len, uint32_t *restrict handle, int64_t *const restrict total_written);
+static bool send_body(const int fd, const int body_fd, off_t body_offset, uint32_t body_len, int64_t *const restrict total_written);
 static inline uint8_t serialize_method(char *restrict buffer, const http_method_t method);
-static inline uint8_t vectorize_method(struct iovec *restrict iov, const http_method_t method);
+static inline void stage_method(staging_t *restrict staging, const http_method_t method);
 static inline uint16_t serialize_path(char *restrict buffer, const char *restrict path, const uint16_t path_len);
-static inline uint8_t vectorize_path(struct iovec *restrict iov, const char *restrict path, const uint16_t path_len);
 static inline uint8_t serialize_version(char *restrict buffer, const http_version_t version);
-static inline uint8_t vectorize_version(struct iovec *restrict iov, const http_version_t version);
+static inline void stage_version(staging_t *restrict staging, const http_version_t version);
+static inline bool valid_status_line(const http_response_t *restrict response);
+static inline uint32_t serialize_status_line(char *restrict buffer, const http_response_t *restrict response);
+static inline void stage_status_line(staging_t *restrict staging, const http_response_t *restrict response);
+static inline uint8_t serialize_status_code(char *restrict buffer, const uint16_t status_code);
 static uint16_t serialize_headers(char *restrict buffer, const http_header_t *restrict headers, const uint16_t headers_count);
-static uint16_t vectorize_headers(struct iovec *restrict iov, const http_header_t *restrict headers, const uint16_t headers_count);
+static void stage_headers(staging_t *restrict staging, const http_header_t *restrict headers, const uint16_t headers_count);
+static inline uint8_t serialize_content_length(char *restrict buffer, const uint32_t content_length);
+static inline void stage_content_length(staging_t *restrict staging, const uint32_t content_length);
+static inline uint8_t serialize_uint(char *restrict buffer, uint32_t n);
+static inline uint8_t uint_len(const uint32_t n);
 static inline uint32_t serialize_body(char *restrict buffer, const char *restrict body, const uint32_t body_len);
-static inline uint8_t vectorize_body(struct iovec *restrict iov, const char *restrict body, const uint32_t body_len);
+static uint32_t template_size(const http_request_t *restrict request);
 
 uint32_t http1_serialize(char *restrict buffer, const http_request_t *restrict request)
 {
@@ -99,31 +305,568 @@ uint32_t http1_serialize(char *restrict buffer, const http_request_t *restrict r
   buffer += serialize_method(buffer, request->method);
   buffer += serialize_path(buffer, request->path, request->path_len);
   buffer += serialize_version(buffer, request->version);
+  if (request->emit_content_length)
+    buffer += serialize_content_length(buffer, request->body_len);
   buffer += serialize_headers(buffer, request->headers, request->headers_count);
   buffer += serialize_body(buffer, request->body, request->body_len);
 
   return buffer - buffer_start;
 }
 
-int32_t http1_serialize_write(const int fd, const http_request_t *restrict request) //TODO optimize, too many microwrites
+int32_t http1_serialize_write(const int fd, const http_request_t *restrict request)
 {
-  if (UNLIKELY((8 + (request->headers_count << 4) + 1) > IOV_MAX))
+  if (UNLIKELY(REQUEST_IOVCNT(request->headers_count) > IOV_MAX))
     return -1;
- 
-  const uint16_t headers_count = request->headers_count;
 
   struct iovec iov[IOV_MAX] ALIGNED(64);
-  uint16_t iovcnt = 0;
+  char buffer[STAGING_SIZE] ALIGNED(64);
+  const uint16_t iovcnt = vectorize_request(iov, buffer, sizeof(buffer), request);
+
+  return writev(fd, iov, iovcnt);
+}
+
+uint32_t http1_serialize_batch(char *restrict buffer, const http_request_t *restrict requests, const uint16_t requests_count)
+{
+  const char *const buffer_start = buffer;
+
+  for (uint16_t i = 0; LIKELY(i < requests_count); i++)
+    buffer += http1_serialize(buffer, &requests[i]);
+
+  return buffer - buffer_start;
+}
+
+int64_t http1_serialize_batch_write(const int fd, const http_request_t *restrict requests, const uint16_t requests_count)
+{
+  for (uint16_t i = 0; LIKELY(i < requests_count); i++)
+  {
+    if (UNLIKELY(REQUEST_IOVCNT(requests[i].headers_count) > IOV_MAX))
+      return -1;
+  }
+
+  struct iovec iov[IOV_MAX] ALIGNED(64);
+  char buffer[STAGING_SIZE] ALIGNED(64);
+  staging_t staging;
+  int64_t total_written = 0;
+
+  staging_reset(&staging, iov, buffer, sizeof(buffer));
+
+  for (uint16_t i = 0; LIKELY(i < requests_count); i++)
+  {
+    const http_request_t *const request = &requests[i];
+
+    const bool staging_full = request->emit_content_length & (staging.end - staging.cursor < (ptrdiff_t)HEAD_RESERVE);
+    const uint16_t pending_run = (staging.cursor != staging.run);
+    if (UNLIKELY((staging.iovcnt + pending_run + REQUEST_IOVCNT(request->headers_count) > IOV_MAX) | staging_full))
+    {
+      stage_close(&staging);
+      if (UNLIKELY(!flush_iov(fd, iov, staging.iovcnt, 0, &total_written)))
+        return write_result(total_written);
+      staging_reset(&staging, iov, buffer, sizeof(buffer));
+    }
+
+    stage_request(&staging, request);
+  }
+
+  stage_close(&staging);
+  if (UNLIKELY(!flush_iov(fd, iov, staging.iovcnt, 0, &total_written)))
+    return write_result(total_written);
+
+  return total_written;
+}
+
+uint32_t http1_serialize_response(char *restrict buffer, const http_response_t *restrict response)
+{
+  if (UNLIKELY(!valid_status_line(response)))
+    return 0;
+
+  const char *const buffer_start = buffer;
+
+  buffer += serialize_status_line(buffer, response);
+  if (response->emit_content_length)
+    buffer += serialize_content_length(buffer, response->body_len);
+  buffer += serialize_headers(buffer, response->headers, response->headers_count);
+  buffer += serialize_body(buffer, response->body, response->body_len);
+
+  return buffer - buffer_start;
+}
+
+int32_t http1_serialize_response_write(const int fd, const http_response_t *restrict response)
+{
+  if (UNLIKELY((4 + (response->headers_count << 2) + 1 + 1) > IOV_MAX))
+    return -1;
+  if (UNLIKELY(!valid_status_line(response)))
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  struct iovec iov[IOV_MAX] ALIGNED(64);
+  char buffer[STAGING_SIZE] ALIGNED(64);
+  staging_t staging;
+
+  staging_reset(&staging, iov, buffer, sizeof(buffer));
+  stage_status_line(&staging, response);
+  if (response->emit_content_length)
+    stage_content_length(&staging, response->body_len);
+  stage_headers(&staging, response->headers, response->headers_count);
+  if (response->body)
+    stage_scatter(&staging, response->body, response->body_len);
+  stage_close(&staging);
+
+  return writev(fd, iov, staging.iovcnt);
+}
+
+int64_t http1_serialize_write_file(const int fd, const http_request_t *restrict request, const int body_fd, const off_t body_offset, const uint32_t body_len)
+{
+  if (UNLIKELY(REQUEST_IOVCNT(request->headers_count) > IOV_MAX))
+    return -1;
+
+  struct iovec iov[IOV_MAX] ALIGNED(64);
+  char buffer[STAGING_SIZE] ALIGNED(64);
+  staging_t staging;
+
+  staging_reset(&staging, iov, buffer, sizeof(buffer));
+  stage_request_head(&staging, request, body_len);
+  stage_close(&staging);
+
+  int64_t total_written = 0;
+  if (UNLIKELY(!flush_iov(fd, iov, staging.iovcnt, 0, &total_written)))
+    return write_result(total_written);
+  if (UNLIKELY(!send_body(fd, body_fd, body_offset, body_len, &total_written)))
+    return write_result(total_written);
+
+  return total_written;
+}
+
+int64_t http1_serialize_response_write_file(const int fd, const http_response_t *restrict response, const int body_fd, const off_t body_offset, const uint32_t body_len)
+{
+  if (UNLIKELY((4 + (response->headers_count << 2) + 1) > IOV_MAX))
+    return -1;
+  if (UNLIKELY(!valid_status_line(response)))
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  struct iovec iov[IOV_MAX] ALIGNED(64);
+  char buffer[STAGING_SIZE] ALIGNED(64);
+  staging_t staging;
+
+  staging_reset(&staging, iov, buffer, sizeof(buffer));
+  stage_status_line(&staging, response);
+  if (response->emit_content_length)
+    stage_content_length(&staging, body_len);
+  stage_headers(&staging, response->headers, response->headers_count);
+  stage_close(&staging);
+
+  int64_t total_written = 0;
+  if (UNLIKELY(!flush_iov(fd, iov, staging.iovcnt, 0, &total_written)))
+    return write_result(total_written);
+  if (UNLIKELY(!send_body(fd, body_fd, body_offset, body_len, &total_written)))
+    return write_result(total_written);
+
+  return total_written;
+}
+
+int32_t http_zerocopy_init(http_zerocopy_t *restrict tracker, const int fd)
+{
+  constexpr int enable = 1;
+
+  *tracker = (http_zerocopy_t){ .fd = fd };
+
+  return setsockopt(fd, SOL_SOCKET, SO_ZEROCOPY, &enable, sizeof(enable));
+}
+
+//only the body is pinned: the head lives in the stack staging buffer, so it is copied and sent ahead with MSG_MORE
+int64_t http1_serialize_write_zerocopy(http_zerocopy_t *restrict tracker, const http_request_t *restrict request, uint32_t *restrict handle)
+{
+  *handle = tracker->completed - 1;
+
+  if ((request->body == NULL) | (request->body_len < HTTP_ZEROCOPY_THRESHOLD))
+    return http1_serialize_write(tracker->fd, request);
+
+  if (UNLIKELY(REQUEST_IOVCNT(request->headers_count) > IOV_MAX))
+    return -1;
+
+  struct iovec iov[IOV_MAX] ALIGNED(64);
+  char buffer[STAGING_SIZE] ALIGNED(64);
+  staging_t staging;
+
+  staging_reset(&staging, iov, buffer, sizeof(buffer));
+  stage_request_head(&staging, request, request->body_len);
+  stage_close(&staging);
+
+  int64_t total_written = 0;
+  if (UNLIKELY(!flush_iov(tracker->fd, iov, staging.iovcnt, MSG_MORE, &total_written)))
+    return write_result(total_written);
+  if (UNLIKELY(!send_zerocopy(tracker, request->body, request->body_len, handle, &total_written)))
+    return write_result(total_written);
+
+  return total_written;
+}
+
+//each notification covers a range of sendmsg() ids, which TCP completes in order
+int32_t http_zerocopy_reap(http_zerocopy_t *restrict tracker)
+{
+  char control[CMSG_SPACE(sizeof(struct sock_extended_err) + sizeof(struct sockaddr_in6))] ALIGNED(8);
+  int32_t count = 0;
+
+  while (true)
+  {
+    struct msghdr msg = { .msg_control = control, .msg_controllen = sizeof(control) };
+
+    if (recvmsg(tracker->fd, &msg, MSG_ERRQUEUE | MSG_DONTWAIT) == -1)
+    {
+      if (errno == EINTR)
+        continue;
+      if ((errno == EAGAIN) | (errno == EWOULDBLOCK))
+        return count;
+      return -1;
+    }
+
+    for (struct cmsghdr *cmsg = CMSG_FIRSTHDR(&msg); cmsg; cmsg = CMSG_NXTHDR(&msg, cmsg))
+    {
+      const bool ipv4 = (cmsg->cmsg_level == SOL_IP) & (cmsg->cmsg_type == IP_RECVERR);
+      const bool ipv6 = (cmsg->cmsg_level == SOL_IPV6) & (cmsg->cmsg_type == IPV6_RECVERR);
+      if (UNLIKELY(!(ipv4 | ipv6)))
+        continue;
+
+      const struct sock_extended_err *err = (const struct sock_extended_err *)CMSG_DATA(cmsg);
+      if (UNLIKELY((err->ee_origin != SO_EE_ORIGIN_ZEROCOPY) | (err->ee_errno != 0)))
+        continue;
+
+      const uint32_t completed = err->ee_data + 1;
+      if ((int32_t)(completed - tracker->completed) > 0)
+        tracker->completed = completed;
+      tracker->copied |= err->ee_code & SO_EE_CODE_ZEROCOPY_COPIED;
+      count++;
+    }
+  }
+}
+
+bool http_zerocopy_done(const http_zerocopy_t *restrict tracker, const uint32_t handle)
+{
+  return (int32_t)(tracker->completed - handle) > 0;
+}
+
+//a NULL path or header value marks a slot, filled at every send in order of appearance
+uint16_t http1_template_compile(http_request_template_t *restrict template, const http_request_t *restrict request)
+{
+  if (UNLIKELY(template_size(request) > HTTP_TEMPLATE_SIZE))
+    return 0;
+
+  char *buffer = template->buffer;
+  uint8_t slots_count = 0;
+
+  buffer += serialize_method(buffer, request->method);
+  if (request->path == NULL)
+  {
+    template->runs_end[slots_count++] = buffer - template->buffer;
+    *buffer++ = ' ';
+  }
+  else
+    buffer += serialize_path(buffer, request->path, request->path_len);
+  buffer += serialize_version(buffer, request->version);
+
+  for (uint16_t i = 0; LIKELY(i < request->headers_count); i++)
+  {
+    const http_header_t *header = &request->headers[i];
+    const http_header_id_t id = known_id(header->id);
+
+    if (LIKELY(id != HTTP_HEADER_UNKNOWN))
+    {
+      memcpy_short(buffer, header_names_str[id], header_names_len[id]);
+      buffer += header_names_len[id];
+    }
+    else
+    {
+      memcpy(buffer, header->key, header->key_len);
+      buffer += header->key_len;
+      memcpy2(buffer, colon_space);
+      buffer += sizeof(colon_space);
+    }
+
+    if (header->value == NULL)
+    {
+      if (UNLIKELY(slots_count == HTTP_TEMPLATE_MAX_SLOTS))
+        return 0;
+      template->runs_end[slots_count++] = buffer - template->buffer;
+    }
+    else
+    {
+      memcpy(buffer, header->value, header->value_len);
+      buffer += header->value_len;
+    }
+
+    memcpy2(buffer, clrf);
+    buffer += sizeof(clrf);
+  }
+
+  memcpy2(buffer, clrf);
+  buffer += sizeof(clrf);
+
+  template->runs_end[slots_count] = buffer - template->buffer;
+  template->slots_count = slots_count;
+  template->content_length = request->emit_content_length;
+
+  return buffer - template->buffer;
+}
+
+uint32_t http1_template_serialize(char *restrict buffer, const http_request_template_t *restrict template, const struct iovec *restrict values, const char *restrict body, const uint32_t body_len)
+{
+  const char *const buffer_start = buffer;
+  uint16_t run_start = 0;
+
+  for (uint8_t i = 0; LIKELY(i < template->slots_count); i++)
+  {
+    const uint16_t run_len = template->runs_end[i] - run_start;
+    memcpy(buffer, template->buffer + run_start, run_len);
+    buffer += run_len;
+    memcpy(buffer, values[i].iov_base, values[i].iov_len);
+    buffer += values[i].iov_len;
+    run_start = template->runs_end[i];
+  }
+
+  //the last run always ends with the CRLF closing the headers
+  const uint16_t run_len = template->runs_end[template->slots_count] - run_start - (sizeof(clrf) * template->content_length);
+  memcpy(buffer, template->buffer + run_start, run_len);
+  buffer += run_len;
+  if (template->content_length)
+  {
+    buffer += serialize_content_length(buffer, body_len);
+    memcpy2(buffer, clrf);
+    buffer += sizeof(clrf);
+  }
+  buffer += serialize_body(buffer, body, body_len);
+
+  return buffer - buffer_start;
+}
+
+int32_t http1_template_write(const int fd, const http_request_template_t *restrict template, const struct iovec *restrict values, const char *restrict body, const uint32_t body_len)
+{
+  struct iovec iov[(HTTP_TEMPLATE_MAX_SLOTS << 1) + 1 + 1 + 1];
+  //the line and the final CRLF take 30 bytes, rounded up to the widest store of memcpy_short
+  char content_length[32];
+  uint8_t iovcnt = 0;
+  uint16_t run_start = 0;
 
-  iovcnt += vectorize_method(iov + iovcnt, request->method);
-  iovcnt += vectorize_path(iov + iovcnt, request->path, request->path_len);
-  iovcnt += vectorize_version(iov + iovcnt, request->version);
-  iovcnt += vectorize_headers(iov + iovcnt, request->headers, headers_count);
-  iovcnt += vectorize_body(iov + iovcnt, request->body, request->body_len);
+  for (uint8_t i = 0; LIKELY(i < template->slots_count); i++)
+  {
+    iov[iovcnt++] = (struct iovec){(char *)template->buffer + run_start, template->runs_end[i] - run_start};
+    iov[iovcnt++] = values[i];
+    run_start = template->runs_end[i];
+  }
+
+  iov[iovcnt++] = (struct iovec){(char *)template->buffer + run_start, template->runs_end[template->slots_count] - run_start - (sizeof(clrf) * template->content_length)};
+  if (template->content_length)
+  {
+    const uint8_t line_len = serialize_content_length(content_length, body_len);
+    memcpy2(content_length + line_len, clrf);
+    iov[iovcnt++] = (struct iovec){content_length, line_len + sizeof(clrf)};
+  }
+  iov[iovcnt] = (struct iovec){(char *)body, body_len};
+  iovcnt += (body != NULL);
 
   return writev(fd, iov, iovcnt);
 }
 
+//the staging buffer must outlive the iovecs, since small fields are written from it
+uint16_t vectorize_request(struct iovec *restrict iov, char *restrict buffer, const uint16_t buffer_size, const http_request_t *restrict request)
+{
+  staging_t staging;
+
+  staging_reset(&staging, iov, buffer, buffer_size);
+  stage_request(&staging, request);
+  stage_close(&staging);
+
+  return staging.iovcnt;
+}
+
+//exact length of what http1_serialize() writes, which never stores past it
+uint64_t serialized_size(const http_request_t *restrict request)
+{
+  uint64_t size = methods_len[request->method] + 1 + request->path_len + 1 + versions_len[request->version] + sizeof(clrf);
+
+  if (request->emit_content_length)
+    size += header_names_len[HTTP_HEADER_CONTENT_LENGTH] + uint_len(request->body_len) + sizeof(clrf);
+
+  for (uint16_t i = 0; LIKELY(i < request->headers_count); i++)
+  {
+    const http_header_t *header = &request->headers[i];
+    const http_header_id_t id = known_id(header->id);
+
+    if (LIKELY(id != HTTP_HEADER_UNKNOWN))
+      size += header_names_len[id];
+    else
+      size += header->key_len + sizeof(colon_space);
+    size += header->value_len + sizeof(clrf);
+  }
+
+  return size + sizeof(clrf) + (request->body_len * (request->body != NULL));
+}
+
+static inline void staging_reset(staging_t *restrict staging, struct iovec *restrict iov, char *restrict buffer, const uint16_t buffer_size)
+{
+  *staging = (staging_t){
+    .iov = iov,
+    .run = buffer,
+    .cursor = buffer,
+    .end = buffer + buffer_size,
+    .iovcnt = 0
+  };
+}
+
+static inline void stage_copy(staging_t *restrict staging, const char *restrict src, const uint32_t len)
+{
+  if (UNLIKELY((len >= COPY_THRESHOLD) | (staging->end - staging->cursor < COPY_THRESHOLD)))
+  {
+    stage_scatter(staging, src, len);
+    return;
+  }
+
+  memcpy_short(staging->cursor, src, len);
+  staging->cursor += len;
+}
+
+static inline void stage_scatter(staging_t *restrict staging, const char *restrict src, const uint32_t len)
+{
+  stage_close(staging);
+  staging->iov[staging->iovcnt++] = (struct iovec){(char *)src, len};
+}
+
+static inline void stage_close(staging_t *restrict staging)
+{
+  if (staging->cursor == staging->run)
+    return;
+
+  staging->iov[staging->iovcnt++] = (struct iovec){staging->run, staging->cursor - staging->run};
+  staging->run = staging->cursor;
+}
+
+//adds at most REQUEST_IOVCNT iovecs, since every run it closes replaces at least one field iovec
+//a run left open by the previous request is not covered: closing it takes one more
+static void stage_request(staging_t *restrict staging, const http_request_t *restrict request)
+{
+  stage_request_head(staging, request, request->body_len);
+  if (request->body)
+    stage_scatter(staging, request->body, request->body_len);
+}
+
+static void stage_request_head(staging_t *restrict staging, const http_request_t *restrict request, const uint32_t content_length)
+{
+  stage_method(staging, request->method);
+  stage_copy(staging, request->path, request->path_len);
+  stage_copy(staging, " ", 1);
+  stage_version(staging, request->version);
+  if (request->emit_content_length)
+    stage_content_length(staging, content_length);
+  stage_headers(staging, request->headers, request->headers_count);
+}
+
+//writev() can stop short, this keeps going from where it stopped until everything is written. Flags need a socket
+//total_written grows with every byte sent, so on failure it still tells how far the data got
+bool flush_iov(const int fd, struct iovec *restrict iov, uint16_t iovcnt, const int flags, int64_t *const restrict total_written)
+{
+  while (iovcnt)
+  {
+    ssize_t written;
+    if (LIKELY(flags == 0))
+      written = writev(fd, iov, iovcnt);
+    else
+      written = sendmsg(fd, &(struct msghdr){ .msg_iov = iov, .msg_iovlen = iovcnt }, flags);
+    if (UNLIKELY(written == -1))
+    {
+      if (errno == EINTR)
+        continue;
+      return false;
+    }
+    *total_written += written;
+
+    while (iovcnt && ((size_t)written >= iov->iov_len))
+    {
+      written -= iov->iov_len;
+      iov++;
+      iovcnt--;
+    }
+
+    if (iovcnt)
+    {
+      iov->iov_base = (char *)iov->iov_base + written;
+      iov->iov_len -= written;
+    }
+  }
+
+  return true;
+}
+
+//every successful MSG_ZEROCOPY sendmsg() takes the next id, the handle is the last one taken
+static bool send_zerocopy(http_zerocopy_t *restrict tracker, const char *restrict body, uint32_t body_len, uint32_t *restrict handle, int64_t *const restrict total_written)
+{
+  while (body_len)
+  {
+    struct iovec iov = {(char *)body, body_len};
+    const ssize_t written = sendmsg(tracker->fd, &(struct msghdr){ .msg_iov = &iov, .msg_iovlen = 1 }, MSG_ZEROCOPY);
+
+    if (UNLIKELY(written == -1))
+    {
+      if (errno == EINTR)
+        continue;
+      if (errno != ENOBUFS)
+        return false;
+
+      //out of pinnable memory, the rest is copied like a normal write
+      return flush_iov(tracker->fd, &iov, 1, 0, total_written);
+    }
+
+    *handle = tracker->next_id++;
+    *total_written += written;
+    body += written;
+    body_len -= written;
+  }
+
+  return true;
+}
+
+//sendfile() needs a source it can map, so a pipe as body_fd makes it fail before anything is moved and splice() takes over
+static bool send_body(const int fd, const int body_fd, off_t body_offset, uint32_t body_len, int64_t *const restrict total_written)
+{
+  bool use_splice = false;
+  bool moved = false;
+
+  while (body_len)
+  {
+    ssize_t written;
+    if (LIKELY(!use_splice))
+      written = sendfile(fd, body_fd, &body_offset, body_len);
+    else
+      written = splice(body_fd, NULL, fd, NULL, body_len, SPLICE_F_MOVE | SPLICE_F_MORE);
+
+    if (UNLIKELY(written == -1))
+    {
+      if (errno == EINTR)
+        continue;
+      if (((errno == EINVAL) | (errno == ESPIPE)) & !use_splice & !moved)
+      {
+        use_splice = true;
+        continue;
+      }
+      return false;
+    }
+
+    if (UNLIKELY(written == 0))
+    {
+      errno = ENODATA;
+      return false;
+    }
+
+    moved = true;
+    *total_written += written;
+    body_len -= written;
+  }
+
+  return true;
+}
+
 static inline uint8_t serialize_method(char *restrict buffer, const http_method_t method)
 {
   const char *const buffer_start = buffer;
@@ -135,12 +878,16 @@ static inline uint8_t serialize_method(char *restrict buffer, const http_method_
   return buffer - buffer_start;
 }
 
-static inline uint8_t vectorize_method(struct iovec *restrict iov, const http_method_t method)
+static inline void stage_method(staging_t *restrict staging, const http_method_t method)
 {
-  *iov++ = (struct iovec){(char *)methods_str[method], methods_len[method]};
-  *iov = (struct iovec){" ", 1};
+  if (UNLIKELY(staging->end - staging->cursor < COPY_THRESHOLD))
+  {
+    stage_scatter(staging, methods_str[method], methods_len[method]);
+    stage_scatter(staging, " ", 1);
+    return;
+  }
 
-  return 2;
+  staging->cursor += serialize_method(staging->cursor, method);
 }
 
 static inline uint16_t serialize_path(char *restrict buffer, const char *restrict path, const uint16_t path_len)
@@ -154,32 +901,94 @@ static inline uint16_t serialize_path(char *restrict buffer, const char *restric
   return buffer - buffer_start;
 }
 
-static inline uint8_t vectorize_path(struct iovec *restrict iov, const char *restrict path, const uint16_t path_len)
+static inline uint8_t serialize_version(char *restrict buffer, const http_version_t version)
+{
+  const char *const buffer_start = buffer;
+
+  memcpy8(buffer, versions_str[version]);
+  buffer += versions_len[version];
+  memcpy2(buffer, clrf);
+  buffer += sizeof(clrf);
+
+  return buffer - buffer_start;
+}
+
+static inline void stage_version(staging_t *restrict staging, const http_version_t version)
 {
-  *iov++ = (struct iovec){(char *)path, path_len};
-  *iov = (struct iovec){" ", 1};
+  if (UNLIKELY(staging->end - staging->cursor < COPY_THRESHOLD))
+  {
+    stage_scatter(staging, versions_str[version], versions_len[version]);
+    stage_scatter(staging, clrf, sizeof(clrf));
+    return;
+  }
 
-  return 2;
+  staging->cursor += serialize_version(staging->cursor, version);
 }
 
-static inline uint8_t serialize_version(char *restrict buffer, const http_version_t version)
+//the status line has room for exactly three digits, and only HTTP/1.x has one
+static inline bool valid_status_line(const http_response_t *restrict response)
+{
+  return ((uint16_t)(response->status_code - 100) < 900) & (response->version <= HTTP_1_1);
+}
+
+static inline uint32_t serialize_status_line(char *restrict buffer, const http_response_t *restrict response)
 {
   const char *const buffer_start = buffer;
 
-  memcpy8(buffer, versions_str[version]);
-  buffer += versions_len[version];
-  memcpy8(buffer, clrf);
+  memcpy8(buffer, versions_str[response->version]);
+  buffer += versions_len[response->version];
+
+  const uint8_t idx = (response->status_code < ARR_SIZE(status_lines_idx)) ? status_lines_idx[response->status_code] : 0;
+  if (LIKELY((response->reason_phrase == NULL) & (idx != 0)))
+  {
+    memcpy_short(buffer, status_lines_str[idx], status_lines_len[idx]);
+    buffer += status_lines_len[idx];
+    return buffer - buffer_start;
+  }
+
+  buffer += serialize_status_code(buffer, response->status_code);
+  if (response->reason_phrase != NULL)
+  {
+    memcpy(buffer, response->reason_phrase, response->reason_phrase_len);
+    buffer += response->reason_phrase_len;
+  }
+  memcpy2(buffer, clrf);
   buffer += sizeof(clrf);
 
   return buffer - buffer_start;
 }
 
-static inline uint8_t vectorize_version(struct iovec *restrict iov, const http_version_t version)
+//the status line always starts an empty staging buffer, so only the reason phrase can need its own iovec
+static inline void stage_status_line(staging_t *restrict staging, const http_response_t *restrict response)
+{
+  memcpy8(staging->cursor, versions_str[response->version]);
+  staging->cursor += versions_len[response->version];
+
+  const uint8_t idx = (response->status_code < ARR_SIZE(status_lines_idx)) ? status_lines_idx[response->status_code] : 0;
+  if (LIKELY((response->reason_phrase == NULL) & (idx != 0)))
+  {
+    memcpy_short(staging->cursor, status_lines_str[idx], status_lines_len[idx]);
+    staging->cursor += status_lines_len[idx];
+    return;
+  }
+
+  staging->cursor += serialize_status_code(staging->cursor, response->status_code);
+  if (response->reason_phrase != NULL)
+    stage_copy(staging, response->reason_phrase, response->reason_phrase_len);
+  stage_copy(staging, clrf, sizeof(clrf));
+}
+
+static inline uint8_t serialize_status_code(char *restrict buffer, const uint16_t status_code)
 {
-  *iov++ = (struct iovec){(char *)versions_str[version], versions_len[version]};
-  *iov = (struct iovec){(char *)clrf, sizeof(clrf)};
+  const char *const buffer_start = buffer;
+
+  *buffer++ = ' ';
+  *buffer++ = '0' + status_code / 100;
+  *buffer++ = '0' + status_code / 10 % 10;
+  *buffer++ = '0' + status_code % 10;
+  *buffer++ = ' ';
 
-  return 2;
+  return buffer - buffer_start;
 }
 
 static uint16_t serialize_headers(char *restrict buffer, const http_header_t *restrict headers, const uint16_t headers_count)
@@ -189,11 +998,20 @@ static uint16_t serialize_headers(char *restrict buffer, const http_header_t *re
   for (uint16_t i = 0; LIKELY(i < headers_count); i++)
   {
     const http_header_t *header = &headers[i];
+    const http_header_id_t id = known_id(header->id);
 
-    memcpy(buffer, header->key, header->key_len);
-    buffer += header->key_len;
-    memcpy2(buffer, colon_space);
-    buffer += sizeof(colon_space);
+    if (LIKELY(id != HTTP_HEADER_UNKNOWN))
+    {
+      memcpy_short(buffer, header_names_str[id], header_names_len[id]);
+      buffer += header_names_len[id];
+    }
+    else
+    {
+      memcpy(buffer, header->key, header->key_len);
+      buffer += header->key_len;
+      memcpy2(buffer, colon_space);
+      buffer += sizeof(colon_space);
+    }
 
     memcpy(buffer, header->value, header->value_len);
     buffer += header->value_len;
@@ -207,24 +1025,74 @@ static uint16_t serialize_headers(char *restrict buffer, const http_header_t *re
   return buffer - buffer_start;
 }
 
-//TODO SIMD
-static uint16_t vectorize_headers(struct iovec *restrict iov, const http_header_t *restrict headers, uint16_t headers_count)
+static void stage_headers(staging_t *restrict staging, const http_header_t *restrict headers, uint16_t headers_count)
 {
-  const struct iovec *const iov_start = iov;
-
   while (LIKELY(headers_count--))
   {
     const http_header_t header = *headers++;
+    const http_header_id_t id = known_id(header.id);
 
-    *iov++ = (struct iovec){(char *)header.key, header.key_len};
-    *iov++ = (struct iovec){(char *)colon_space, sizeof(colon_space)};
-    *iov++ = (struct iovec){(char *)header.value, header.value_len};
-    *iov++ = (struct iovec){(char *)clrf, sizeof(clrf)};
+    if (LIKELY(id != HTTP_HEADER_UNKNOWN))
+      stage_copy(staging, header_names_str[id], header_names_len[id]);
+    else
+    {
+      stage_copy(staging, header.key, header.key_len);
+      stage_copy(staging, colon_space, sizeof(colon_space));
+    }
+    stage_copy(staging, header.value, header.value_len);
+    stage_copy(staging, clrf, sizeof(clrf));
   }
 
-  *iov++ = (struct iovec){(char *)clrf, sizeof(clrf)};
+  stage_copy(staging, clrf, sizeof(clrf));
+}
+
+static inline uint8_t serialize_content_length(char *restrict buffer, const uint32_t content_length)
+{
+  const char *const buffer_start = buffer;
+
+  memcpy_short(buffer, header_names_str[HTTP_HEADER_CONTENT_LENGTH], header_names_len[HTTP_HEADER_CONTENT_LENGTH]);
+  buffer += header_names_len[HTTP_HEADER_CONTENT_LENGTH];
+  buffer += serialize_uint(buffer, content_length);
+  memcpy2(buffer, clrf);
+  buffer += sizeof(clrf);
 
-  return iov - iov_start;
+  return buffer - buffer_start;
+}
+
+//the line always follows the start line, which leaves at least HEAD_RESERVE bytes free, so the digits live in the staging buffer
+static inline void stage_content_length(staging_t *restrict staging, const uint32_t content_length)
+{
+  staging->cursor += serialize_content_length(staging->cursor, content_length);
+}
+
+//the length comes from the bit length, then the digits are written backwards two at a time
+static inline uint8_t serialize_uint(char *restrict buffer, uint32_t n)
+{
+  const uint8_t len = uint_len(n);
+
+  char *cursor = buffer + len;
+  while (n >= 100)
+  {
+    cursor -= 2;
+    memcpy2(cursor, &digit_pairs[(n % 100) << 1]);
+    n /= 100;
+  }
+
+  if (n >= 10)
+    memcpy2(cursor - 2, &digit_pairs[n << 1]);
+  else
+    cursor[-1] = '0' + n;
+
+  return len;
+}
+
+//log10 from the bit length: 1233 / 4096 is close to log10(2), powers_of_10 corrects the guess
+static inline uint8_t uint_len(const uint32_t n)
+{
+  const uint8_t bits = 32 - __builtin_clz(n | 1);
+  const uint8_t guess = (bits * 1233) >> 12;
+
+  return guess + (n >= powers_of_10[guess]);
 }
 
 static inline uint32_t serialize_body(char *restrict buffer, const char *restrict body, const uint32_t body_len)
@@ -239,9 +1107,25 @@ static inline uint32_t serialize_body(char *restrict buffer, const char *restric
   return buffer - buffer_start;
 }
 
-static inline uint8_t vectorize_body(struct iovec *restrict iov, const char *restrict body, const uint32_t body_len)
+//upper bound of the bytes written while compiling, including the slack of the 8-byte stores
+static uint32_t template_size(const http_request_t *restrict request)
 {
-  *iov = (struct iovec){(char *)body, body_len};
+  uint32_t size = sizeof(uint64_t) + 1;
+
+  size += (request->path_len * (request->path != NULL)) + 1;
+  size += sizeof(uint64_t) + sizeof(clrf);
+
+  for (uint16_t i = 0; LIKELY(i < request->headers_count); i++)
+  {
+    const http_header_t *header = &request->headers[i];
+    const http_header_id_t id = known_id(header->id);
+
+    if (LIKELY(id != HTTP_HEADER_UNKNOWN))
+      size += header_names_len[id];
+    else
+      size += header->key_len + sizeof(colon_space);
+    size += (header->value_len * (header->value != NULL)) + sizeof(clrf);
+  }
 
-  return 1;
+  return size + sizeof(clrf);
 }
@@ -0,0 +1,334 @@
+/*================================================================================
+
+File: uring.c                                                                   
+Creator: Claudio Raimondi                                                       
+Email: claudio.raimondi@pm.me                                                   
+
+created at: 2025-03-07 10:21:03                                                 
+last edited: 2025-03-15 13:34:46                                                
+
+================================================================================*/
+
+#include <string.h>
+#include <errno.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+#include <linux/io_uring.h>
+
+#include "common.h"
+#include "serializer.h"
+#include "uring.h"
+
+static inline struct io_uring_sqe *acquire_sqe(http_uring_t *const restrict ring);
+static inline uint16_t acquire_slot(http_uring_t *const restrict ring);
+static inline void release_slot(http_uring_t *const restrict ring, const uint16_t slot);
+static inline void prep_slot(struct io_uring_sqe *const restrict sqe, const http_uring_slot_t *restrict slot, const uint16_t idx);
+static bool resume_slot(http_uring_t *const restrict ring, const uint16_t idx, uint32_t written);
+static int32_t map_rings(http_uring_t *const restrict ring, const struct io_uring_params *restrict params);
+
+int32_t http_uring_init(http_uring_t *const restrict ring, http_uring_slot_t *restrict slots, const uint16_t slots_count)
+{
+  if (UNLIKELY(slots_count == 0))
+  {
+    errno = EINVAL;
+    return -1;
+  }
+
+  struct io_uring_params params = {0};
+
+  *ring = (http_uring_t){0};
+  ring->fd = syscall(__NR_io_uring_setup, slots_count, &params);
+  if (UNLIKELY(ring->fd == -1))
+    return -1;
+
+  if (UNLIKELY(map_rings(ring, &params) == -1))
+  {
+    const int saved_errno = errno;
+    http_uring_destroy(ring);
+    errno = saved_errno;
+    return -1;
+  }
+
+  for (uint16_t i = 0; LIKELY(i < slots_count); i++)
+    slots[i].next_free = i + 1;
+
+  ring->slots = slots;
+  ring->slots_count = slots_count;
+  ring->free_slot = 0;
+
+  return 0;
+}
+
+void http_uring_destroy(http_uring_t *const restrict ring)
+{
+  if (ring->sqes)
+    munmap(ring->sqes, ring->sqes_size);
+  if (ring->cq_ring && (ring->cq_ring != ring->sq_ring))
+    munmap(ring->cq_ring, ring->cq_ring_size);
+  if (ring->sq_ring)
+    munmap(ring->sq_ring, ring->sq_ring_size);
+  close(ring->fd);
+
+  *ring = (http_uring_t){ .fd = -1 };
+}
+
+int32_t http_uring_register_buffers(http_uring_t *const restrict ring, const struct iovec *restrict buffers, const uint16_t buffers_count)
+{
+  return syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_BUFFERS, buffers, buffers_count);
+}
+
+int32_t http_uring_register_files(http_uring_t *const restrict ring, const int *restrict fds, const uint16_t fds_count)
+{
+  return syscall(__NR_io_uring_register, ring->fd, IORING_REGISTER_FILES, fds, fds_count);
+}
+
+int32_t http1_uring_prep_write(http_uring_t *const restrict ring, const int fd, const http_request_t *restrict request, const uint64_t cookie, const uint8_t flags)
+{
+  if (UNLIKELY(REQUEST_IOVCNT(request->headers_count) > HTTP_URING_SLOT_IOVCNT))
+    return -1;
+
+  struct io_uring_sqe *const sqe = acquire_sqe(ring);
+  if (UNLIKELY(sqe == NULL))
+    return -1;
+
+  const uint16_t idx = acquire_slot(ring);
+  if (UNLIKELY(idx == ring->slots_count))
+  {
+    ring->sq_local_tail--;
+    return -1;
+  }
+
+  http_uring_slot_t *const slot = &ring->slots[idx];
+  const uint16_t iovcnt = vectorize_request(slot->iov, slot->staging, sizeof(slot->staging), request);
+
+  int32_t len = 0;
+  for (uint16_t i = 0; LIKELY(i < iovcnt); i++)
+    len += slot->iov[i].iov_len;
+
+  slot->buffer = NULL;
+  slot->cookie = cookie;
+  slot->length = len;
+  slot->written = 0;
+  slot->fd = fd;
+  slot->iov_first = 0;
+  slot->iovcnt = iovcnt;
+  slot->sqe_flags = IOSQE_FIXED_FILE * !!(flags & HTTP_URING_FIXED_FILE);
+  prep_slot(sqe, slot, idx);
+
+  return len;
+}
+
+int32_t http1_uring_prep_write_fixed(http_uring_t *const restrict ring, const int fd, const http_request_t *restrict request, char *restrict buffer, const uint32_t buffer_size, const uint16_t buffer_index, const uint64_t cookie, const uint8_t flags)
+{
+  if (UNLIKELY(serialized_size(request) > buffer_size))
+    return -1;
+
+  struct io_uring_sqe *const sqe = acquire_sqe(ring);
+  if (UNLIKELY(sqe == NULL))
+    return -1;
+
+  const uint16_t idx = acquire_slot(ring);
+  if (UNLIKELY(idx == ring->slots_count))
+  {
+    ring->sq_local_tail--;
+    return -1;
+  }
+
+  http_uring_slot_t *const slot = &ring->slots[idx];
+  const uint32_t len = http1_serialize(buffer, request);
+
+  slot->buffer = buffer;
+  slot->cookie = cookie;
+  slot->length = len;
+  slot->written = 0;
+  slot->fd = fd;
+  slot->buffer_index = buffer_index;
+  slot->sqe_flags = IOSQE_FIXED_FILE * !!(flags & HTTP_URING_FIXED_FILE);
+  prep_slot(sqe, slot, idx);
+
+  return len;
+}
+
+//one syscall submits everything prepared since the last call, across all connections
+//the kernel may take fewer entries than offered, the rest are offered again on the next call
+int32_t http_uring_submit(http_uring_t *const restrict ring, const uint32_t wait_completions)
+{
+  const uint32_t to_submit = ring->sq_local_tail - ring->sq_submitted;
+  if (UNLIKELY((to_submit == 0) & (wait_completions == 0)))
+    return 0;
+
+  __atomic_store_n(ring->sq_tail, ring->sq_local_tail, __ATOMIC_RELEASE);
+
+  const uint32_t enter_flags = (wait_completions != 0) * IORING_ENTER_GETEVENTS;
+  int32_t ret;
+  do
+    ret = syscall(__NR_io_uring_enter, ring->fd, to_submit, wait_completions, enter_flags, NULL, 0);
+  while (UNLIKELY((ret == -1) & (errno == EINTR)));
+
+  if (LIKELY(ret > 0))
+    ring->sq_submitted += ret;
+
+  return ret;
+}
+
+uint16_t http_uring_reap(http_uring_t *const restrict ring, http_uring_completion_t *restrict completions, const uint16_t max_completions)
+{
+  uint32_t head = *ring->cq_head;
+  const uint32_t tail = __atomic_load_n(ring->cq_tail, __ATOMIC_ACQUIRE);
+  uint16_t count = 0;
+
+  while (LIKELY((head != tail) & (count < max_completions)))
+  {
+    const struct io_uring_cqe *const cqe = &ring->cqes[head & ring->cq_mask];
+    const uint16_t idx = cqe->user_data;
+    http_uring_slot_t *const slot = &ring->slots[idx];
+    const int32_t res = cqe->res;
+    head++;
+
+    //a short write keeps its slot and goes back in the queue for the next submit
+    if (UNLIKELY((res > 0) && (slot->written + res < slot->length)) && resume_slot(ring, idx, res))
+      continue;
+
+    //like the writers of serializer.c, bytes already sent win over a later error
+    const int32_t result = (res > 0) ? (int32_t)(slot->written + res) : ((slot->written != 0) ? (int32_t)slot->written : res);
+    completions[count++] = (http_uring_completion_t){ slot->cookie, result, slot->length };
+    release_slot(ring, idx);
+  }
+
+  __atomic_store_n(ring->cq_head, head, __ATOMIC_RELEASE);
+
+  return count;
+}
+
+static inline struct io_uring_sqe *acquire_sqe(http_uring_t *const restrict ring)
+{
+  const uint32_t head = __atomic_load_n(ring->sq_head, __ATOMIC_ACQUIRE);
+  if (UNLIKELY(ring->sq_local_tail - head >= ring->sq_entries))
+    return NULL;
+
+  return &ring->sqes[ring->sq_local_tail++ & ring->sq_mask];
+}
+
+//free slots form a singly linked list threaded through next_free, slots_count terminates it
+static inline uint16_t acquire_slot(http_uring_t *const restrict ring)
+{
+  const uint16_t idx = ring->free_slot;
+  if (LIKELY(idx != ring->slots_count))
+    ring->free_slot = ring->slots[idx].next_free;
+
+  return idx;
+}
+
+static inline void release_slot(http_uring_t *const restrict ring, const uint16_t slot)
+{
+  ring->slots[slot].next_free = ring->free_slot;
+  ring->free_slot = slot;
+}
+
+//the entry covers whatever the slot has not written yet
+static inline void prep_slot(struct io_uring_sqe *const restrict sqe, const http_uring_slot_t *restrict slot, const uint16_t idx)
+{
+  if (slot->buffer != NULL)
+  {
+    *sqe = (struct io_uring_sqe){
+      .opcode = IORING_OP_WRITE_FIXED,
+      .flags = slot->sqe_flags,
+      .fd = slot->fd,
+      .off = -1,
+      .addr = (uintptr_t)(slot->buffer + slot->written),
+      .len = slot->length - slot->written,
+      .buf_index = slot->buffer_index,
+      .user_data = idx
+    };
+    return;
+  }
+
+  *sqe = (struct io_uring_sqe){
+    .opcode = IORING_OP_WRITEV,
+    .flags = slot->sqe_flags,
+    .fd = slot->fd,
+    .off = -1,
+    .addr = (uintptr_t)(slot->iov + slot->iov_first),
+    .len = slot->iovcnt - slot->iov_first,
+    .user_data = idx
+  };
+}
+
+//without a free submission entry the short write is reported as is, like writev would
+static bool resume_slot(http_uring_t *const restrict ring, const uint16_t idx, uint32_t written)
+{
+  struct io_uring_sqe *const sqe = acquire_sqe(ring);
+  if (UNLIKELY(sqe == NULL))
+    return false;
+
+  http_uring_slot_t *const slot = &ring->slots[idx];
+  slot->written += written;
+
+  if (slot->buffer == NULL)
+  {
+    while (written >= slot->iov[slot->iov_first].iov_len)
+      written -= slot->iov[slot->iov_first++].iov_len;
+    slot->iov[slot->iov_first].iov_base = (char *)slot->iov[slot->iov_first].iov_base + written;
+    slot->iov[slot->iov_first].iov_len -= written;
+  }
+
+  prep_slot(sqe, slot, idx);
+  return true;
+}
+
+static int32_t map_rings(http_uring_t *const restrict ring, const struct io_uring_params *restrict params)
+{
+  const bool single_mmap = params->features & IORING_FEAT_SINGLE_MMAP;
+
+  ring->sq_ring_size = params->sq_off.array + params->sq_entries * sizeof(uint32_t);
+  ring->cq_ring_size = params->cq_off.cqes + params->cq_entries * sizeof(struct io_uring_cqe);
+  ring->sqes_size = params->sq_entries * sizeof(struct io_uring_sqe);
+
+  if (single_mmap)
+  {
+    ring->sq_ring_size = ring->sq_ring_size > ring->cq_ring_size ? ring->sq_ring_size : ring->cq_ring_size;
+    ring->cq_ring_size = ring->sq_ring_size;
+  }
+
+  void *ptr = mmap(NULL, ring->sq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQ_RING);
+  if (UNLIKELY(ptr == MAP_FAILED))
+    return -1;
+  ring->sq_ring = ptr;
+
+  if (single_mmap)
+    ring->cq_ring = ring->sq_ring;
+  else
+  {
+    ptr = mmap(NULL, ring->cq_ring_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_CQ_RING);
+    if (UNLIKELY(ptr == MAP_FAILED))
+      return -1;
+    ring->cq_ring = ptr;
+  }
+
+  ptr = mmap(NULL, ring->sqes_size, PROT_READ | PROT_WRITE, MAP_SHARED | MAP_POPULATE, ring->fd, IORING_OFF_SQES);
+  if (UNLIKELY(ptr == MAP_FAILED))
+    return -1;
+  ring->sqes = ptr;
+
+  char *const sq_ring = ring->sq_ring;
+  char *const cq_ring = ring->cq_ring;
+
+  ring->sq_head = (uint32_t *)(sq_ring + params->sq_off.head);
+  ring->sq_tail = (uint32_t *)(sq_ring + params->sq_off.tail);
+  ring->sq_array = (uint32_t *)(sq_ring + params->sq_off.array);
+  ring->sq_mask = *(uint32_t *)(sq_ring + params->sq_off.ring_mask);
+  ring->sq_entries = params->sq_entries;
+  ring->sq_local_tail = *ring->sq_tail;
+  ring->sq_submitted = *ring->sq_tail;
+  ring->cq_head = (uint32_t *)(cq_ring + params->cq_off.head);
+  ring->cq_tail = (uint32_t *)(cq_ring + params->cq_off.tail);
+  ring->cq_mask = *(uint32_t *)(cq_ring + params->cq_off.ring_mask);
+  ring->cqes = (struct io_uring_cqe *)(cq_ring + params->cq_off.cqes);
+
+  //sqes are consumed in order, so the indirection array is the identity
+  for (uint32_t i = 0; LIKELY(i < params->sq_entries); i++)
+    ring->sq_array[i] = i;
+
+  return 0;
+}
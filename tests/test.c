@@ -5,7 +5,7 @@ Creator: Claudio Raimondi
 Email: claudio.raimondi@pm.me                                                   
 
 created at: 2025-02-10 21:08:13                                                 
-last edited: 2025-03-05 21:11:45                                                
+last edited: 2025-03-15 13:48:21                                                
 
 ================================================================================*/
 
@@ -17,6 +17,10 @@ last edited: 2025-03-05 21:11:45
 #include <stdlib.h>
 #include <fcntl.h>
 #include <sys/uio.h>
+#include <sys/socket.h>
+#include <netinet/in.h>
+#include <arpa/inet.h>
+#include <poll.h>
 
 #define STR_LEN(x) (sizeof(x) - 1)
 #define ARR_SIZE(x) (sizeof(x) / sizeof(x[0]))
@@ -92,6 +96,75 @@ static char *test_deserialize_reason_phrase_too_long(void);
 static char *test_deserialize_header_key_too_long(void);
 static char *test_deserialize_header_value_too_long(void);
 static char *test_deserialize_clrfs(void);
+static char *test_deserialize_block_boundaries(void);
+static char *test_deserialize_colon_after_clrf(void);
+static char *test_deserialize_request_normal_message(void);
+static char *test_deserialize_request_all_methods(void);
+static char *test_deserialize_request_invalid_method(void);
+static char *test_deserialize_request_invalid_version(void);
+static char *test_deserialize_request_missing_path(void);
+static char *test_serialize_response_normal_message(void);
+static char *test_serialize_response_status_lines(void);
+static char *test_serialize_response_custom_reason_phrase(void);
+static char *test_serialize_response_write_normal_message(void);
+static char *test_serialize_response_write_custom_reason_phrase(void);
+static char *test_deserialize_partial_split_reads(void);
+static char *test_deserialize_partial_need_more(void);
+static char *test_deserialize_request_partial_split_reads(void);
+static char *test_decode_chunked_normal_message(void);
+static char *test_decode_chunked_extensions_trailers(void);
+static char *test_decode_chunked_split_reads(void);
+static char *test_decode_chunked_iov(void);
+static char *test_decode_chunked_invalid_size(void);
+static char *test_deserialize_framing_content_length(void);
+static char *test_deserialize_framing_chunked_and_close(void);
+static char *test_deserialize_request_framing(void);
+static char *test_deserialize_filtered(void);
+static char *test_header_filter_compile_invalid(void);
+static char *test_deserialize_indexed(void);
+static char *test_deserialize_request_indexed(void);
+static char *test_deserialize_header_ids(void);
+static char *test_serialize_header_ids(void);
+static char *test_deserialize_batch(void);
+static char *test_deserialize_batch_stops(void);
+static char *test_serialize_batch_write_pipelined(void);
+static char *test_serialize_batch_write_iov_max(void);
+static char *test_serialize_write_long_fields(void);
+static char *test_serialize_batch_write_staging_full(void);
+static char *test_uring_write(void);
+static char *test_uring_write_fixed(void);
+static char *test_template(void);
+static char *test_serialize_write_file(void);
+static char *test_serialize_response_write_file_pipe(void);
+static char *test_serialize_write_zerocopy(void);
+static char *test_deserialize_iov_seams(void);
+static char *test_deserialize_iov_incomplete(void);
+static char *test_ring_wraparound(void);
+static char *test_deserialize_arena(void);
+static char *test_deserialize_compact(void);
+static char *test_deserialize_status_line_shapes(void);
+static char *test_serialize_content_length(void);
+static char *test_serialize_batch_write_content_length(void);
+static char *test_hpack_rfc_requests(void);
+static char *test_hpack_decode_raw_literals(void);
+static char *test_hpack_eviction(void);
+static char *test_http2_control_frames(void);
+static char *test_http2_padding(void);
+static char *test_http2_request_response(void);
+static char *test_qpack_rfc_examples(void);
+static char *test_qpack_dynamic_table(void);
+static char *test_http3_request_response(void);
+static char *test_serialize_response_status_code_range(void);
+static char *test_decode_chunked_invalid_extensions_trailers(void);
+static char *test_deserialize_header_ids_all(void);
+static char *test_serialize_batch_write_partial(void);
+static char *test_deserialize_arena_full(void);
+static char *test_template_content_length(void);
+static char *test_hpack_never_indexed(void);
+static char *test_http2_deserialize_invalid_fields(void);
+static char *test_serialize_out_of_range_id(void);
+static char *test_uring_short_write(void);
+static char *test_http2_deserialize_literal_names(void);
 
 int main(void)
 {
@@ -135,6 +208,75 @@ static char *all_tests(void)
   mu_run_test(test_deserialize_header_key_too_long);
   mu_run_test(test_deserialize_header_value_too_long);
   mu_run_test(test_deserialize_clrfs);
+  mu_run_test(test_deserialize_block_boundaries);
+  mu_run_test(test_deserialize_colon_after_clrf);
+  mu_run_test(test_deserialize_request_normal_message);
+  mu_run_test(test_deserialize_request_all_methods);
+  mu_run_test(test_deserialize_request_invalid_method);
+  mu_run_test(test_deserialize_request_invalid_version);
+  mu_run_test(test_deserialize_request_missing_path);
+  mu_run_test(test_serialize_response_normal_message);
+  mu_run_test(test_serialize_response_status_lines);
+  mu_run_test(test_serialize_response_custom_reason_phrase);
+  mu_run_test(test_serialize_response_write_normal_message);
+  mu_run_test(test_serialize_response_write_custom_reason_phrase);
+  mu_run_test(test_deserialize_partial_split_reads);
+  mu_run_test(test_deserialize_partial_need_more);
+  mu_run_test(test_deserialize_request_partial_split_reads);
+  mu_run_test(test_decode_chunked_normal_message);
+  mu_run_test(test_decode_chunked_extensions_trailers);
+  mu_run_test(test_decode_chunked_split_reads);
+  mu_run_test(test_decode_chunked_iov);
+  mu_run_test(test_decode_chunked_invalid_size);
+  mu_run_test(test_deserialize_framing_content_length);
+  mu_run_test(test_deserialize_framing_chunked_and_close);
+  mu_run_test(test_deserialize_request_framing);
+  mu_run_test(test_deserialize_filtered);
+  mu_run_test(test_header_filter_compile_invalid);
+  mu_run_test(test_deserialize_indexed);
+  mu_run_test(test_deserialize_request_indexed);
+  mu_run_test(test_deserialize_header_ids);
+  mu_run_test(test_serialize_header_ids);
+  mu_run_test(test_deserialize_batch);
+  mu_run_test(test_deserialize_batch_stops);
+  mu_run_test(test_serialize_batch_write_pipelined);
+  mu_run_test(test_serialize_batch_write_iov_max);
+  mu_run_test(test_serialize_write_long_fields);
+  mu_run_test(test_serialize_batch_write_staging_full);
+  mu_run_test(test_uring_write);
+  mu_run_test(test_uring_write_fixed);
+  mu_run_test(test_template);
+  mu_run_test(test_serialize_write_file);
+  mu_run_test(test_serialize_response_write_file_pipe);
+  mu_run_test(test_serialize_write_zerocopy);
+  mu_run_test(test_deserialize_iov_seams);
+  mu_run_test(test_deserialize_iov_incomplete);
+  mu_run_test(test_ring_wraparound);
+  mu_run_test(test_deserialize_arena);
+  mu_run_test(test_deserialize_compact);
+  mu_run_test(test_deserialize_status_line_shapes);
+  mu_run_test(test_serialize_content_length);
+  mu_run_test(test_serialize_batch_write_content_length);
+  mu_run_test(test_hpack_rfc_requests);
+  mu_run_test(test_hpack_decode_raw_literals);
+  mu_run_test(test_hpack_eviction);
+  mu_run_test(test_http2_control_frames);
+  mu_run_test(test_http2_padding);
+  mu_run_test(test_http2_request_response);
+  mu_run_test(test_qpack_rfc_examples);
+  mu_run_test(test_qpack_dynamic_table);
+  mu_run_test(test_http3_request_response);
+  mu_run_test(test_serialize_response_status_code_range);
+  mu_run_test(test_decode_chunked_invalid_extensions_trailers);
+  mu_run_test(test_deserialize_header_ids_all);
+  mu_run_test(test_serialize_batch_write_partial);
+  mu_run_test(test_deserialize_arena_full);
+  mu_run_test(test_template_content_length);
+  mu_run_test(test_hpack_never_indexed);
+  mu_run_test(test_http2_deserialize_invalid_fields);
+  mu_run_test(test_serialize_out_of_range_id);
+  mu_run_test(test_uring_short_write);
+  mu_run_test(test_http2_deserialize_literal_names);
   
 
   return 0;
@@ -848,5 +990,2948 @@ static char *test_deserialize_clrfs(void)
   mu_assert("error: deserialize newlines: wrong headers", compare_headers(response.headers, expected_headers, response.headers_count));
   mu_assert("error: deserialize newlines: wrong body", memcmp(response.body, expected_body, sizeof(expected_body)) == 0);
 
+  return 0;
+}
+
+static char *test_deserialize_block_boundaries(void)
+{
+  char buffer[] =
+    "HTTP/1.1 200 OK\r\n"
+    "X-Pad: 00000000000000000000000000000000000000000000000000000000\r\n"
+    "X-Long: 0000000000000000000000000000000000000000000000000000000000000000"
+    "0000000000000000000000000000000000000000000000000000000000000000:00\r\n"
+    "Date: Mon, 01 Jan 2023 12:00:00 GMT\r\n"
+    "\r\n"
+    "body";
+  const http_header_t expected_headers[] = {
+    { .key = "X-Pad",  .value = "00000000000000000000000000000000000000000000000000000000", .key_len = 5, .value_len = 56 },
+    { .key = "X-Long", .value = "0000000000000000000000000000000000000000000000000000000000000000"
+                                "0000000000000000000000000000000000000000000000000000000000000000:00", .key_len = 6, .value_len = 131 },
+    { .key = "Date",   .value = "Mon, 01 Jan 2023 12:00:00 GMT", .key_len = 4, .value_len = 29 }
+  };
+
+  http_header_t headers[ARR_SIZE(expected_headers)] = {0};
+  http_response_t response = { .headers = headers, .headers_count = ARR_SIZE(headers) };
+  const uint32_t len = http1_deserialize(buffer, sizeof(buffer), &response);
+
+  mu_assert("error: deserialize block boundaries: wrong length", len == STR_LEN(buffer) - STR_LEN("body"));
+  mu_assert("error: deserialize block boundaries: wrong headers count", response.headers_count == ARR_SIZE(expected_headers));
+  mu_assert("error: deserialize block boundaries: wrong headers", compare_headers(response.headers, expected_headers, response.headers_count));
+  mu_assert("error: deserialize block boundaries: wrong body", memcmp(response.body, "body", sizeof("body")) == 0);
+
+  return 0;
+}
+
+static char *test_deserialize_colon_after_clrf(void)
+{
+  char buffer[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type text/html\r\n"
+    "Content-Length: 1234\r\n"
+    "\r\n";
+  http_header_t headers[2] = {0};
+  http_response_t response = { .headers = headers, .headers_count = 2 };
+  const uint32_t len = http1_deserialize(buffer, sizeof(buffer), &response);
+
+  mu_assert("error: deserialize colon after clrf: should fail", len == 0);
+
+  return 0;
+}
+
+static char *test_deserialize_request_normal_message(void)
+{
+  char buffer[] =
+    "POST /example/path/resource HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "User-Agent: Mozilla/5.0\r\n"
+    "Content-Length: 31\r\n"
+    "\r\n"
+    "This is the body of the request";
+  const http_header_t expected_headers[] = {
+    { .key = "Host",            .value = "example.com", .key_len = 4,  .value_len = 11 },
+    { .key = "User-Agent",      .value = "Mozilla/5.0", .key_len = 10, .value_len = 11 },
+    { .key = "Content-Length",  .value = "31",          .key_len = 14, .value_len = 2 }
+  };
+  const char expected_path[] = "/example/path/resource";
+  const char expected_body[] = "This is the body of the request";
+
+  http_header_t headers[ARR_SIZE(expected_headers)] = {0};
+  http_request_t request = { .headers = headers, .headers_count = ARR_SIZE(headers) };
+  const uint32_t len = http1_deserialize_request(buffer, sizeof(buffer), &request);
+
+  mu_assert("error: deserialize request normal message: wrong length", len == STR_LEN(buffer) - STR_LEN(expected_body));
+  mu_assert("error: deserialize request normal message: wrong method", request.method == HTTP_POST);
+  mu_assert("error: deserialize request normal message: wrong path", request.path_len == STR_LEN(expected_path) && memcmp(request.path, expected_path, sizeof(expected_path)) == 0);
+  mu_assert("error: deserialize request normal message: wrong version", request.version == HTTP_1_1);
+  mu_assert("error: deserialize request normal message: wrong headers count", request.headers_count == ARR_SIZE(expected_headers));
+  mu_assert("error: deserialize request normal message: wrong headers", compare_headers(request.headers, expected_headers, request.headers_count));
+  mu_assert("error: deserialize request normal message: wrong body", memcmp(request.body, expected_body, sizeof(expected_body)) == 0);
+
+  return 0;
+}
+
+static char *test_deserialize_request_all_methods(void)
+{
+  const char *methods[] = { "GET", "HEAD", "POST", "PUT", "DELETE", "OPTIONS", "TRACE", "PATCH", "CONNECT" };
+  const http_method_t expected_methods[] = { HTTP_GET, HTTP_HEAD, HTTP_POST, HTTP_PUT, HTTP_DELETE, HTTP_OPTIONS, HTTP_TRACE, HTTP_PATCH, HTTP_CONNECT };
+
+  for (uint8_t i = 0; i < ARR_SIZE(methods); i++)
+  {
+    char buffer[64];
+    const int buffer_len = sprintf(buffer, "%s / HTTP/1.0\r\n\r\n", methods[i]);
+
+    http_request_t request = {0};
+    const uint32_t len = http1_deserialize_request(buffer, buffer_len, &request);
+
+    mu_assert("error: deserialize request all methods: wrong length", len == (uint32_t)buffer_len);
+    mu_assert("error: deserialize request all methods: wrong method", request.method == expected_methods[i]);
+    mu_assert("error: deserialize request all methods: wrong version", request.version == HTTP_1_0);
+    mu_assert("error: deserialize request all methods: wrong body", request.body == NULL);
+  }
+
+  return 0;
+}
+
+static char *test_deserialize_request_invalid_method(void)
+{
+  char buffer[] =
+    "GETS /example/path/resource HTTP/1.1\r\n"
+    "\r\n";
+  http_request_t request = {0};
+  const uint32_t len = http1_deserialize_request(buffer, sizeof(buffer), &request);
+
+  mu_assert("error: deserialize request invalid method: should fail", len == 0);
+
+  return 0;
+}
+
+static char *test_deserialize_request_invalid_version(void)
+{
+  char buffer[] =
+    "GET /example/path/resource HTTP/1.2\r\n"
+    "\r\n";
+  http_request_t request = {0};
+  const uint32_t len = http1_deserialize_request(buffer, sizeof(buffer), &request);
+
+  mu_assert("error: deserialize request invalid version: should fail", len == 0);
+
+  return 0;
+}
+
+static char *test_deserialize_request_missing_path(void)
+{
+  char buffer[] =
+    "OPTIONS HTTP/1.1\r\n"
+    "\r\n";
+  http_request_t request = {0};
+  const uint32_t len = http1_deserialize_request(buffer, sizeof(buffer), &request);
+
+  mu_assert("error: deserialize request missing path: should fail", len == 0);
+
+  return 0;
+}
+
+static char *test_serialize_response_normal_message(void)
+{
+  http_header_t headers[] = {
+    { .key = "Content-Type",    .value = "text/html; charset=UTF-8", .key_len = 12, .value_len = 24 },
+    { .key = "Content-Length",  .value = "32",                       .key_len = 14, .value_len = 2 }
+  };
+  char body[] = "This is the body of the response";
+  const http_response_t response = {
+    .version = HTTP_1_1,
+    .status_code = 200,
+    .headers = headers,
+    .headers_count = ARR_SIZE(headers),
+    .body = body,
+    .body_len = STR_LEN(body)
+  };
+  const char expected_buffer[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/html; charset=UTF-8\r\n"
+    "Content-Length: 32\r\n"
+    "\r\n"
+    "This is the body of the response";
+  const uint16_t expected_len = STR_LEN(expected_buffer);
+
+  char buffer[sizeof(expected_buffer)] = {0};
+  uint32_t len = http1_serialize_response(buffer, &response);
+
+  mu_assert("error: serialize response normal message: wrong length", len == expected_len);
+  mu_assert("error: serialize response normal message: wrong buffer", memcmp(buffer, expected_buffer, len) == 0);
+
+  return 0;
+}
+
+static char *test_serialize_response_status_lines(void)
+{
+  const struct { http_version_t version; uint16_t status_code; const char *expected; } cases[] = {
+    { HTTP_1_1, 100, "HTTP/1.1 100 Continue\r\n\r\n" },
+    { HTTP_1_0, 204, "HTTP/1.0 204 No Content\r\n\r\n" },
+    { HTTP_1_1, 404, "HTTP/1.1 404 Not Found\r\n\r\n" },
+    { HTTP_1_1, 431, "HTTP/1.1 431 Request Header Fields Too Large\r\n\r\n" },
+    { HTTP_1_1, 511, "HTTP/1.1 511 Network Authentication Required\r\n\r\n" },
+    { HTTP_1_1, 599, "HTTP/1.1 599 \r\n\r\n" }
+  };
+
+  for (uint8_t i = 0; i < ARR_SIZE(cases); i++)
+  {
+    const http_response_t response = { .version = cases[i].version, .status_code = cases[i].status_code };
+
+    char buffer[128] = {0};
+    uint32_t len = http1_serialize_response(buffer, &response);
+
+    mu_assert("error: serialize response status lines: wrong length", len == strlen(cases[i].expected));
+    mu_assert("error: serialize response status lines: wrong buffer", memcmp(buffer, cases[i].expected, len) == 0);
+  }
+
+  return 0;
+}
+
+static char *test_serialize_response_custom_reason_phrase(void)
+{
+  const http_response_t response = {
+    .version = HTTP_1_1,
+    .status_code = 200,
+    .reason_phrase = "Everything Fine",
+    .reason_phrase_len = 15
+  };
+  const char expected_buffer[] =
+    "HTTP/1.1 200 Everything Fine\r\n"
+    "\r\n";
+  const uint16_t expected_len = STR_LEN(expected_buffer);
+
+  char buffer[sizeof(expected_buffer)] = {0};
+  uint32_t len = http1_serialize_response(buffer, &response);
+
+  mu_assert("error: serialize response custom reason phrase: wrong length", len == expected_len);
+  mu_assert("error: serialize response custom reason phrase: wrong buffer", memcmp(buffer, expected_buffer, len) == 0);
+
+  return 0;
+}
+
+static char *test_serialize_response_write_normal_message(void)
+{
+  http_header_t headers[] = {
+    { .key = "Content-Type",    .value = "text/html; charset=UTF-8", .key_len = 12, .value_len = 24 },
+    { .key = "Content-Length",  .value = "32",                       .key_len = 14, .value_len = 2 }
+  };
+  char body[] = "This is the body of the response";
+  const http_response_t response = {
+    .version = HTTP_1_1,
+    .status_code = 503,
+    .headers = headers,
+    .headers_count = ARR_SIZE(headers),
+    .body = body,
+    .body_len = STR_LEN(body)
+  };
+  const char expected_buffer[] =
+    "HTTP/1.1 503 Service Unavailable\r\n"
+    "Content-Type: text/html; charset=UTF-8\r\n"
+    "Content-Length: 32\r\n"
+    "\r\n"
+    "This is the body of the response";
+  const uint16_t expected_len = STR_LEN(expected_buffer);
+
+  int fds[2];
+  if (pipe(fds) == -1)
+    return strerror(errno);
+  int32_t len = http1_serialize_response_write(fds[1], &response);
+
+  mu_assert("error: serialize response write normal message: wrong length", len == expected_len);
+  mu_assert("error: serialize response write normal message: wrong output", compare_file(fds[0], expected_buffer, expected_len));
+
+  close(fds[0]);
+  close(fds[1]);
+
+  return 0;
+}
+
+static char *test_serialize_response_write_custom_reason_phrase(void)
+{
+  const http_response_t response = {
+    .version = HTTP_1_0,
+    .status_code = 299,
+    .reason_phrase = "Custom",
+    .reason_phrase_len = 6
+  };
+  const char expected_buffer[] =
+    "HTTP/1.0 299 Custom\r\n"
+    "\r\n";
+  const uint16_t expected_len = STR_LEN(expected_buffer);
+
+  int fds[2];
+  if (pipe(fds) == -1)
+    return strerror(errno);
+  int32_t len = http1_serialize_response_write(fds[1], &response);
+
+  mu_assert("error: serialize response write custom reason phrase: wrong length", len == expected_len);
+  mu_assert("error: serialize response write custom reason phrase: wrong output", compare_file(fds[0], expected_buffer, expected_len));
+
+  close(fds[0]);
+  close(fds[1]);
+
+  return 0;
+}
+
+static char *test_deserialize_partial_split_reads(void)
+{
+  const char message[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/html; charset=UTF-8\r\n"
+    "Content-Length: 1234\r\n"
+    "Connection: keep-alive\r\n"
+    "Server: Apache/2.4.41 (Unix)\r\n"
+    "X-Long: 0000000000000000000000000000000000000000000000000000000000000000"
+    "0000000000000000000000000000000000000000000000000000000000000000:00\r\n"
+    "Cache-Control: max-age=3600\r\n"
+    "ETag: \"abc123\"\r\n"
+    "Date: Mon, 01 Jan 2023 12:00:00 GMT\r\n"
+    "\r\n"
+    "This is the body of the response";
+  const http_header_t expected_headers[] = {
+    { .key = "Content-Type",    .value = "text/html; charset=UTF-8",      .key_len = 12,  .value_len = 24 },
+    { .key = "Content-Length",  .value = "1234",                          .key_len = 14,  .value_len = 4 },
+    { .key = "Connection",      .value = "keep-alive",                    .key_len = 10,  .value_len = 10 },
+    { .key = "Server",          .value = "Apache/2.4.41 (Unix)",          .key_len = 6,   .value_len = 20 },
+    { .key = "X-Long",          .value = "0000000000000000000000000000000000000000000000000000000000000000"
+                                         "0000000000000000000000000000000000000000000000000000000000000000:00", .key_len = 6, .value_len = 131 },
+    { .key = "Cache-Control",   .value = "max-age=3600",                  .key_len = 13,  .value_len = 12 },
+    { .key = "ETag",            .value = "\"abc123\"",                    .key_len = 4,   .value_len = 8 },
+    { .key = "Date",            .value = "Mon, 01 Jan 2023 12:00:00 GMT", .key_len = 4,   .value_len = 29 }
+  };
+  const uint32_t expected_len = STR_LEN(message) - STR_LEN("This is the body of the response");
+  const uint32_t chunk_sizes[] = { 1, 2, 3, 7, 63, 64, 65, 1000 };
+
+  for (uint8_t i = 0; i < ARR_SIZE(chunk_sizes); i++)
+  {
+    char buffer[sizeof(message)];
+    memcpy(buffer, message, sizeof(message));
+
+    http_header_t headers[ARR_SIZE(expected_headers)] = {0};
+    http_response_t response = { .headers = headers, .headers_count = ARR_SIZE(headers) };
+    http_parser_t parser = {0};
+
+    uint32_t buffer_size = 0;
+    uint32_t len;
+    do
+    {
+      buffer_size += chunk_sizes[i];
+      if (buffer_size > sizeof(buffer))
+        buffer_size = sizeof(buffer);
+      len = http1_deserialize_partial(&parser, buffer, buffer_size, &response);
+    } while (len == HTTP_NEED_MORE && buffer_size < sizeof(buffer));
+
+    mu_assert("error: deserialize partial split reads: wrong length", len == expected_len);
+    mu_assert("error: deserialize partial split reads: wrong status code", response.status_code == 200);
+    mu_assert("error: deserialize partial split reads: wrong headers count", response.headers_count == ARR_SIZE(expected_headers));
+    mu_assert("error: deserialize partial split reads: wrong headers", compare_headers(response.headers, expected_headers, response.headers_count));
+  }
+
+  return 0;
+}
+
+static char *test_deserialize_partial_need_more(void)
+{
+  char buffer[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/html\r\n"
+    "\r\n";
+
+  http_header_t headers[1] = {0};
+  http_response_t response = { .headers = headers, .headers_count = 1 };
+  http_parser_t parser = {0};
+
+  mu_assert("error: deserialize partial need more: status line", http1_deserialize_partial(&parser, buffer, 10, &response) == HTTP_NEED_MORE);
+  mu_assert("error: deserialize partial need more: header key", http1_deserialize_partial(&parser, buffer, 25, &response) == HTTP_NEED_MORE);
+  mu_assert("error: deserialize partial need more: header value", http1_deserialize_partial(&parser, buffer, 35, &response) == HTTP_NEED_MORE);
+  mu_assert("error: deserialize partial need more: empty line", http1_deserialize_partial(&parser, buffer, STR_LEN(buffer) - 1, &response) == HTTP_NEED_MORE);
+  mu_assert("error: deserialize partial need more: wrong length", http1_deserialize_partial(&parser, buffer, STR_LEN(buffer), &response) == STR_LEN(buffer));
+  mu_assert("error: deserialize partial need more: wrong headers count", response.headers_count == 1);
+
+  return 0;
+}
+
+static char *test_deserialize_request_partial_split_reads(void)
+{
+  const char message[] =
+    "GET /example/path/resource HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "User-Agent: Mozilla/5.0\r\n"
+    "\r\n";
+  const http_header_t expected_headers[] = {
+    { .key = "Host",        .value = "example.com", .key_len = 4,  .value_len = 11 },
+    { .key = "User-Agent",  .value = "Mozilla/5.0", .key_len = 10, .value_len = 11 }
+  };
+
+  for (uint32_t chunk_size = 1; chunk_size < sizeof(message); chunk_size++)
+  {
+    char buffer[sizeof(message)];
+    memcpy(buffer, message, sizeof(message));
+
+    http_header_t headers[ARR_SIZE(expected_headers)] = {0};
+    http_request_t request = { .headers = headers, .headers_count = ARR_SIZE(headers) };
+    http_parser_t parser = {0};
+
+    uint32_t buffer_size = 0;
+    uint32_t len;
+    do
+    {
+      buffer_size += chunk_size;
+      if (buffer_size > STR_LEN(message))
+        buffer_size = STR_LEN(message);
+      len = http1_deserialize_request_partial(&parser, buffer, buffer_size, &request);
+    } while (len == HTTP_NEED_MORE && buffer_size < STR_LEN(message));
+
+    mu_assert("error: deserialize request partial split reads: wrong length", len == STR_LEN(message));
+    mu_assert("error: deserialize request partial split reads: wrong method", request.method == HTTP_GET);
+    mu_assert("error: deserialize request partial split reads: wrong headers count", request.headers_count == ARR_SIZE(expected_headers));
+    mu_assert("error: deserialize request partial split reads: wrong headers", compare_headers(request.headers, expected_headers, request.headers_count));
+    mu_assert("error: deserialize request partial split reads: wrong body", request.body == NULL);
+  }
+
+  return 0;
+}
+
+static char *test_decode_chunked_normal_message(void)
+{
+  char buffer[] =
+    "7\r\n"
+    "Mozilla\r\n"
+    "11\r\n"
+    "Developer Network\r\n"
+    "0\r\n"
+    "\r\n"
+    "HTTP/1.1 200 OK\r\n";
+  const char expected_body[] = "MozillaDeveloper Network";
+  const uint32_t expected_len = STR_LEN(buffer) - STR_LEN("HTTP/1.1 200 OK\r\n");
+
+  http_chunked_decoder_t decoder = {0};
+  uint32_t body_len = 0;
+  const uint32_t len = http1_decode_chunked(&decoder, buffer, STR_LEN(buffer), &body_len);
+
+  mu_assert("error: decode chunked normal message: wrong length", len == expected_len);
+  mu_assert("error: decode chunked normal message: wrong body length", body_len == STR_LEN(expected_body));
+  mu_assert("error: decode chunked normal message: wrong body", memcmp(buffer, expected_body, body_len) == 0);
+
+  return 0;
+}
+
+static char *test_decode_chunked_extensions_trailers(void)
+{
+  char buffer[] =
+    "1A;name=value;other\r\n"
+    "abcdefghijklmnopqrstuvwxyz\r\n"
+    "0000fFfF\r\n";
+  char large_buffer[0x10000 + 128] = {0};
+  const char expected_body[] = "abcdefghijklmnopqrstuvwxyz";
+
+  http_chunked_decoder_t decoder = {0};
+  uint32_t body_len = 0;
+  uint32_t len = http1_decode_chunked(&decoder, buffer, STR_LEN(buffer), &body_len);
+
+  mu_assert("error: decode chunked extensions trailers: should need more", len == HTTP_NEED_MORE);
+  mu_assert("error: decode chunked extensions trailers: wrong body length", body_len == STR_LEN(expected_body));
+  mu_assert("error: decode chunked extensions trailers: wrong body", memcmp(buffer, expected_body, body_len) == 0);
+
+  memset(large_buffer, 'x', 0xFFFF);
+  strcpy(large_buffer + 0xFFFF,
+    "\r\n"
+    "0 ; last\r\n"
+    "Expires: Wed, 21 Oct 2015 07:28:00 GMT\r\n"
+    "X-Checksum: abc\r\n"
+    "\r\n");
+  len = http1_decode_chunked(&decoder, large_buffer, strlen(large_buffer), &body_len);
+
+  mu_assert("error: decode chunked extensions trailers: wrong length", len == strlen(large_buffer));
+  mu_assert("error: decode chunked extensions trailers: wrong large body length", body_len == 0xFFFF);
+
+  return 0;
+}
+
+static char *test_decode_chunked_split_reads(void)
+{
+  const char message[] =
+    "4\r\n"
+    "Wiki\r\n"
+    "11;ext=\"a b\"\r\n"
+    "pedia in \r\nchunks\r\n"
+    "3\r\n"
+    ".\r\n\r\n"
+    "0\r\n"
+    "Trailer: value\r\n"
+    "\r\n";
+  const char expected_body[] = "Wikipedia in \r\nchunks.\r\n";
+
+  for (uint32_t chunk_size = 1; chunk_size < sizeof(message); chunk_size++)
+  {
+    char buffer[sizeof(message)];
+    memcpy(buffer, message, sizeof(message));
+
+    http_chunked_decoder_t decoder = {0};
+    char body[sizeof(expected_body)] = {0};
+    uint32_t body_total = 0;
+    uint32_t offset = 0;
+    uint32_t len = HTTP_NEED_MORE;
+
+    while (len == HTTP_NEED_MORE && offset < STR_LEN(message))
+    {
+      const uint32_t size = (STR_LEN(message) - offset < chunk_size) ? STR_LEN(message) - offset : chunk_size;
+      uint32_t body_len = 0;
+
+      len = http1_decode_chunked(&decoder, buffer + offset, size, &body_len);
+      memcpy(body + body_total, buffer + offset, body_len);
+      body_total += body_len;
+      offset += size;
+    }
+
+    mu_assert("error: decode chunked split reads: wrong length", len != HTTP_NEED_MORE && len != 0);
+    mu_assert("error: decode chunked split reads: wrong body length", body_total == STR_LEN(expected_body));
+    mu_assert("error: decode chunked split reads: wrong body", memcmp(body, expected_body, body_total) == 0);
+  }
+
+  return 0;
+}
+
+static char *test_decode_chunked_iov(void)
+{
+  char buffer[] =
+    "5\r\n"
+    "Hello\r\n"
+    "7\r\n"
+    ", world\r\n"
+    "0\r\n"
+    "\r\n";
+
+  http_chunked_decoder_t decoder = {0};
+  struct iovec iov[4];
+  uint16_t iovcnt = ARR_SIZE(iov);
+  const uint32_t len = http1_decode_chunked_iov(&decoder, buffer, STR_LEN(buffer), iov, &iovcnt);
+
+  mu_assert("error: decode chunked iov: wrong length", len == STR_LEN(buffer));
+  mu_assert("error: decode chunked iov: wrong iovcnt", iovcnt == 2);
+  mu_assert("error: decode chunked iov: wrong first slice", iov[0].iov_base == buffer + 3 && iov[0].iov_len == 5);
+  mu_assert("error: decode chunked iov: wrong second slice", iov[1].iov_base == buffer + 13 && iov[1].iov_len == 7);
+
+  decoder = (http_chunked_decoder_t){0};
+  iovcnt = 1;
+  const uint32_t first_len = http1_decode_chunked_iov(&decoder, buffer, STR_LEN(buffer), iov, &iovcnt);
+
+  mu_assert("error: decode chunked iov: full iov should stop before the second slice", first_len == 13 && iovcnt == 1);
+  mu_assert("error: decode chunked iov: full iov should keep the state", decoder.stage == HTTP_CHUNK_DATA);
+
+  iovcnt = 1;
+  const uint32_t second_len = http1_decode_chunked_iov(&decoder, buffer + first_len, STR_LEN(buffer) - first_len, iov, &iovcnt);
+
+  mu_assert("error: decode chunked iov: wrong resumed length", second_len == STR_LEN(buffer) - first_len);
+  mu_assert("error: decode chunked iov: wrong resumed slice", iovcnt == 1 && iov[0].iov_base == buffer + 13 && iov[0].iov_len == 7);
+
+  return 0;
+}
+
+static char *test_decode_chunked_invalid_size(void)
+{
+  const char *messages[] = {
+    "G\r\nabc\r\n0\r\n\r\n",
+    "\r\nabc\r\n0\r\n\r\n",
+    "123456789\r\nabc\r\n0\r\n\r\n",
+    "3\r\nabcd\r\n0\r\n\r\n",
+    "3\nabc\r\n0\r\n\r\n",
+    "\x10\r\nabc\r\n0\r\n\r\n",
+    "\x13\x10\r\nabc\r\n0\r\n\r\n",
+    "3\x10\r\nabc\r\n0\r\n\r\n",
+    "3 x\r\nabc\r\n0\r\n\r\n"
+  };
+
+  for (uint8_t i = 0; i < ARR_SIZE(messages); i++)
+  {
+    char buffer[64];
+    strcpy(buffer, messages[i]);
+
+    http_chunked_decoder_t decoder = {0};
+    uint32_t body_len = 0;
+    const uint32_t len = http1_decode_chunked(&decoder, buffer, strlen(buffer), &body_len);
+
+    mu_assert("error: decode chunked invalid size: should fail", len == 0);
+  }
+
+  return 0;
+}
+
+static char *test_deserialize_framing_content_length(void)
+{
+  char buffer[] =
+    "HTTP/1.1 200 OK\r\n"
+    "CONTENT-length: 12 \r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n"
+    "Hello world!"
+    "HTTP/1.1 204 No Content\r\n"
+    "\r\n";
+  http_header_t headers[2] = {0};
+  http_response_t response = { .headers = headers, .headers_count = ARR_SIZE(headers) };
+  const uint32_t len = http1_deserialize(buffer, STR_LEN(buffer), &response);
+
+  mu_assert("error: deserialize framing content length: wrong length", len == STR_LEN("HTTP/1.1 200 OK\r\nCONTENT-length: 12 \r\nConnection: keep-alive\r\n\r\n"));
+  mu_assert("error: deserialize framing content length: wrong version", response.version == HTTP_1_1);
+  mu_assert("error: deserialize framing content length: wrong framing", response.framing == HTTP_FRAMING_CONTENT_LENGTH);
+  mu_assert("error: deserialize framing content length: wrong body length", response.body_len == 12);
+  mu_assert("error: deserialize framing content length: wrong keep alive", response.keep_alive);
+
+  char *const next = buffer + len + response.body_len;
+  http_response_t next_response = {0};
+  const uint32_t next_len = http1_deserialize(next, STR_LEN(buffer) - (next - buffer), &next_response);
+
+  mu_assert("error: deserialize framing content length: wrong next message", next_len == STR_LEN("HTTP/1.1 204 No Content\r\n\r\n"));
+  mu_assert("error: deserialize framing content length: wrong next framing", next_response.framing == HTTP_FRAMING_NONE && next_response.body_len == 0);
+  mu_assert("error: deserialize framing content length: wrong next keep alive", next_response.keep_alive);
+
+  return 0;
+}
+
+static char *test_deserialize_framing_chunked_and_close(void)
+{
+  char chunked_buffer[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Length: 100\r\n"
+    "Transfer-Encoding: gzip, Chunked\r\n"
+    "\r\n";
+  char close_buffer[] =
+    "HTTP/1.0 200 OK\r\n"
+    "Content-Type: text/plain\r\n"
+    "\r\n"
+    "until close";
+  char invalid_buffer[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Length: 99999999999\r\n"
+    "Connection: Upgrade, close\r\n"
+    "\r\n";
+  http_header_t headers[2] = {0};
+
+  http_response_t response = { .headers = headers, .headers_count = ARR_SIZE(headers) };
+  mu_assert("error: deserialize framing chunked: should succeed", http1_deserialize(chunked_buffer, STR_LEN(chunked_buffer), &response) != 0);
+  mu_assert("error: deserialize framing chunked: wrong framing", response.framing == HTTP_FRAMING_CHUNKED && response.body_len == 0);
+  mu_assert("error: deserialize framing chunked: length and encoding should not keep alive", !response.keep_alive);
+
+  response = (http_response_t){ .headers = headers, .headers_count = ARR_SIZE(headers) };
+  mu_assert("error: deserialize framing close: should succeed", http1_deserialize(close_buffer, STR_LEN(close_buffer), &response) != 0);
+  mu_assert("error: deserialize framing close: wrong version", response.version == HTTP_1_0);
+  mu_assert("error: deserialize framing close: wrong framing", response.framing == HTTP_FRAMING_CLOSE && response.body_len == STR_LEN("until close"));
+  mu_assert("error: deserialize framing close: wrong keep alive", !response.keep_alive);
+
+  response = (http_response_t){ .headers = headers, .headers_count = ARR_SIZE(headers) };
+  mu_assert("error: deserialize framing invalid length: should succeed", http1_deserialize(invalid_buffer, STR_LEN(invalid_buffer), &response) != 0);
+  mu_assert("error: deserialize framing invalid length: wrong framing", response.framing == HTTP_FRAMING_CLOSE);
+  mu_assert("error: deserialize framing invalid length: wrong keep alive", !response.keep_alive);
+
+  return 0;
+}
+
+static char *test_deserialize_request_framing(void)
+{
+  char buffer[] =
+    "POST / HTTP/1.0\r\n"
+    "Connection: Keep-Alive\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "\r\n";
+  char invalid_buffer[] =
+    "POST / HTTP/1.1\r\n"
+    "Transfer-Encoding: chunked, gzip\r\n"
+    "\r\n";
+  http_header_t headers[2] = {0};
+
+  http_request_t request = { .headers = headers, .headers_count = ARR_SIZE(headers) };
+  mu_assert("error: deserialize request framing: should succeed", http1_deserialize_request(buffer, STR_LEN(buffer), &request) == STR_LEN(buffer));
+  mu_assert("error: deserialize request framing: wrong framing", request.framing == HTTP_FRAMING_CHUNKED);
+  mu_assert("error: deserialize request framing: wrong keep alive", request.keep_alive);
+
+  request = (http_request_t){ .headers = headers, .headers_count = ARR_SIZE(headers) };
+  mu_assert("error: deserialize request framing: unframed encoding should fail", http1_deserialize_request(invalid_buffer, STR_LEN(invalid_buffer), &request) == 0);
+
+  return 0;
+}
+
+static char *test_deserialize_filtered(void)
+{
+  char buffer[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/html; charset=UTF-8\r\n"
+    "Content-Length: 5\r\n"
+    "Server: Apache/2.4.41 (Unix)\r\n"
+    "cache-control: max-age=3600\r\n"
+    "ETag: \"abc123\"\r\n"
+    "X-Request-Id: 42\r\n"
+    "Date: Mon, 01 Jan 2023 12:00:00 GMT\r\n"
+    "\r\n"
+    "hello";
+  enum { ETAG, CACHE_CONTROL, LOCATION, REQUEST_ID };
+  const char *const names[] = {
+    [ETAG] = "ETag",
+    [CACHE_CONTROL] = "Cache-Control",
+    [LOCATION] = "Location",
+    [REQUEST_ID] = "x-request-id"
+  };
+
+  http_header_filter_t filter;
+  mu_assert("error: deserialize filtered: compile failed", http_header_filter_compile(&filter, names, ARR_SIZE(names)));
+
+  http_header_t headers[ARR_SIZE(names)];
+  http_response_t response = { .headers = headers };
+  const uint32_t len = http1_deserialize_filtered(buffer, STR_LEN(buffer), &response, &filter);
+
+  mu_assert("error: deserialize filtered: wrong length", len == STR_LEN(buffer) - STR_LEN("hello"));
+  mu_assert("error: deserialize filtered: wrong headers count", response.headers_count == ARR_SIZE(names));
+  mu_assert("error: deserialize filtered: wrong etag", headers[ETAG].value_len == 8 && strcmp(headers[ETAG].value, "\"abc123\"") == 0);
+  mu_assert("error: deserialize filtered: wrong cache control", strcmp(headers[CACHE_CONTROL].key, "cache-control") == 0 && strcmp(headers[CACHE_CONTROL].value, "max-age=3600") == 0);
+  mu_assert("error: deserialize filtered: missing header should be empty", headers[LOCATION].key == NULL && headers[LOCATION].value == NULL);
+  mu_assert("error: deserialize filtered: wrong request id", headers[REQUEST_ID].value_len == 2 && strcmp(headers[REQUEST_ID].value, "42") == 0);
+  mu_assert("error: deserialize filtered: skipped header should be untouched", memcmp(buffer + STR_LEN("HTTP/1.1 200 OK\r\n"), "Content-Type: text/html", 23) == 0);
+  mu_assert("error: deserialize filtered: wrong framing", response.framing == HTTP_FRAMING_CONTENT_LENGTH && response.body_len == 5);
+
+  return 0;
+}
+
+static char *test_header_filter_compile_invalid(void)
+{
+  const char *const duplicates[] = { "Content-Type", "content-type" };
+  const char *const empty[] = { "Host", "" };
+  const char *too_many[HTTP_FILTER_MAX_HEADERS + 1];
+  for (uint8_t i = 0; i < ARR_SIZE(too_many); i++)
+    too_many[i] = "Host";
+
+  http_header_filter_t filter;
+  mu_assert("error: header filter compile: duplicates should fail", !http_header_filter_compile(&filter, duplicates, ARR_SIZE(duplicates)));
+  mu_assert("error: header filter compile: empty name should fail", !http_header_filter_compile(&filter, empty, ARR_SIZE(empty)));
+  mu_assert("error: header filter compile: too many names should fail", !http_header_filter_compile(&filter, too_many, ARR_SIZE(too_many)));
+
+  //same length, same first and last 8 bytes
+  const char *const middle[] = { "X-RateLimit-Limit-Minute", "X-RateLimit-Reset-Minute" };
+  mu_assert("error: header filter compile: names differing in the middle should compile", http_header_filter_compile(&filter, middle, ARR_SIZE(middle)));
+
+  return 0;
+}
+
+static char *test_deserialize_indexed(void)
+{
+  char buffer[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/html; charset=UTF-8\r\n"
+    "Set-Cookie: a=1\r\n"
+    "Server: Apache/2.4.41 (Unix)\r\n"
+    "Cache-Control: max-age=3600\r\n"
+    "set-cookie: b=2\r\n"
+    "ETag: \"abc123\"\r\n"
+    "\r\n";
+  http_header_t headers[8] = {0};
+  http_header_slot_t slots[16];
+  http_header_index_t index = { .slots = slots, .capacity = ARR_SIZE(slots) };
+  http_response_t response = { .headers = headers, .headers_count = ARR_SIZE(headers) };
+  const uint32_t len = http1_deserialize_indexed(buffer, STR_LEN(buffer), &response, &index);
+
+  mu_assert("error: deserialize indexed: wrong length", len == STR_LEN(buffer));
+  mu_assert("error: deserialize indexed: wrong headers count", response.headers_count == 6);
+
+  uint16_t cursor = 0;
+  const http_header_t *header = http_header_find(&index, "etag", STR_LEN("etag"), &cursor);
+  mu_assert("error: deserialize indexed: wrong etag", header == &headers[5]);
+  mu_assert("error: deserialize indexed: etag should be unique", http_header_find(&index, "etag", STR_LEN("etag"), &cursor) == NULL);
+
+  cursor = 0;
+  header = http_header_find(&index, "SET-COOKIE", STR_LEN("SET-COOKIE"), &cursor);
+  mu_assert("error: deserialize indexed: wrong first cookie", header && strcmp(header->value, "a=1") == 0);
+  header = http_header_find(&index, "SET-COOKIE", STR_LEN("SET-COOKIE"), &cursor);
+  mu_assert("error: deserialize indexed: wrong second cookie", header && strcmp(header->value, "b=2") == 0);
+  mu_assert("error: deserialize indexed: too many cookies", http_header_find(&index, "SET-COOKIE", STR_LEN("SET-COOKIE"), &cursor) == NULL);
+
+  cursor = 0;
+  mu_assert("error: deserialize indexed: missing header should not be found", http_header_find(&index, "Location", STR_LEN("Location"), &cursor) == NULL);
+
+  http_header_index_t small_index = { .slots = slots, .capacity = 8 };
+  response = (http_response_t){ .headers = headers, .headers_count = ARR_SIZE(headers) };
+  mu_assert("error: deserialize indexed: index without a free slot should fail", http1_deserialize_indexed(buffer, STR_LEN(buffer), &response, &small_index) == 0);
+
+  return 0;
+}
+
+static char *test_deserialize_request_indexed(void)
+{
+  char buffer[] =
+    "GET / HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "Accept: */*\r\n"
+    "\r\n";
+  http_header_t headers[4] = {0};
+  http_header_slot_t slots[8];
+  http_header_index_t index = { .slots = slots, .capacity = ARR_SIZE(slots) };
+  http_request_t request = { .headers = headers, .headers_count = ARR_SIZE(headers) };
+
+  mu_assert("error: deserialize request indexed: wrong length", http1_deserialize_request_indexed(buffer, STR_LEN(buffer), &request, &index) == STR_LEN(buffer));
+
+  uint16_t cursor = 0;
+  const http_header_t *const header = http_header_find(&index, "host", STR_LEN("host"), &cursor);
+  mu_assert("error: deserialize request indexed: wrong host", header && strcmp(header->value, "example.com") == 0);
+
+  return 0;
+}
+
+static char *test_deserialize_header_ids(void)
+{
+  char buffer[] =
+    "HTTP/1.1 200 OK\r\n"
+    "content-type: text/plain\r\n"
+    "X-Custom: 1\r\n"
+    "SERVER: flashhttp\r\n"
+    "Content-Lengths: 2\r\n"
+    "WWW-Authenticate: Basic\r\n"
+    "\r\n";
+  const http_header_id_t expected_ids[] = {
+    HTTP_HEADER_CONTENT_TYPE,
+    HTTP_HEADER_UNKNOWN,
+    HTTP_HEADER_SERVER,
+    HTTP_HEADER_UNKNOWN,
+    HTTP_HEADER_WWW_AUTHENTICATE
+  };
+  http_header_t headers[ARR_SIZE(expected_ids)] = {0};
+  http_response_t response = { .headers = headers, .headers_count = ARR_SIZE(headers) };
+
+  mu_assert("error: deserialize header ids: wrong length", http1_deserialize(buffer, STR_LEN(buffer), &response) == STR_LEN(buffer));
+  for (uint8_t i = 0; i < ARR_SIZE(expected_ids); i++)
+    mu_assert("error: deserialize header ids: wrong id", headers[i].id == expected_ids[i]);
+  mu_assert("error: deserialize header ids: unknown length header should not frame the body", response.framing == HTTP_FRAMING_CLOSE);
+
+  return 0;
+}
+
+static char *test_serialize_header_ids(void)
+{
+  const http_header_t headers[] = {
+    { .id = HTTP_HEADER_HOST, .value = "example.com", .value_len = 11 },
+    { .key = "X-Custom", .key_len = 8, .value = "1", .value_len = 1 },
+    { .id = HTTP_HEADER_ACCESS_CONTROL_ALLOW_ORIGIN, .value = "*", .value_len = 1 }
+  };
+  const http_request_t request = {
+    .method = HTTP_GET,
+    .path = "/",
+    .path_len = 1,
+    .version = HTTP_1_1,
+    .headers = (http_header_t *)headers,
+    .headers_count = ARR_SIZE(headers)
+  };
+  const char expected[] =
+    "GET / HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "X-Custom: 1\r\n"
+    "Access-Control-Allow-Origin: *\r\n"
+    "\r\n";
+
+  char buffer[256];
+  const uint32_t len = http1_serialize(buffer, &request);
+  mu_assert("error: serialize header ids: wrong length", len == STR_LEN(expected));
+  mu_assert("error: serialize header ids: wrong message", memcmp(buffer, expected, len) == 0);
+
+  int fds[2];
+  mu_assert("error: serialize write header ids: pipe failed", pipe(fds) == 0);
+  const int32_t written = http1_serialize_write(fds[1], &request);
+  close(fds[1]);
+  const bool match = compare_file(fds[0], expected, STR_LEN(expected));
+  close(fds[0]);
+  mu_assert("error: serialize write header ids: wrong length", written == (int32_t)STR_LEN(expected));
+  mu_assert("error: serialize write header ids: wrong message", match);
+
+  return 0;
+}
+
+static char *test_deserialize_batch(void)
+{
+  char buffer[512] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Length: 5\r\n"
+    "\r\n"
+    "first"
+    "HTTP/1.1 204 No Content\r\n"
+    "Server: flashhttp\r\n"
+    "\r\n"
+    "HTTP/1.1 404 Not Found\r\n"
+    "Content-Type: text/plain\r\n"
+    "Content-Length: 40\r\n"
+    "\r\n"
+    "the requested resource could not be foun"
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Length: 4\r\n"
+    "\r\n"
+    "la";
+  const uint32_t buffer_len = strlen(buffer);
+  const uint32_t complete_len = buffer_len - STR_LEN("HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\nla");
+  const uint16_t expected_status_codes[] = { 200, 204, 404 };
+
+  http_header_t headers[4][2] = {0};
+  http_response_t responses[4];
+  for (uint8_t i = 0; i < ARR_SIZE(responses); i++)
+    responses[i] = (http_response_t){ .headers = headers[i], .headers_count = ARR_SIZE(headers[i]) };
+
+  uint16_t count = ARR_SIZE(responses);
+  const uint32_t len = http1_deserialize_batch(buffer, buffer_len, responses, &count);
+
+  mu_assert("error: deserialize batch: wrong length", len == complete_len);
+  mu_assert("error: deserialize batch: wrong count", count == ARR_SIZE(expected_status_codes));
+  for (uint8_t i = 0; i < ARR_SIZE(expected_status_codes); i++)
+    mu_assert("error: deserialize batch: wrong status code", responses[i].status_code == expected_status_codes[i]);
+  mu_assert("error: deserialize batch: wrong body", responses[2].body_len == 40 && memcmp(responses[2].body, "the requested", 13) == 0);
+  mu_assert("error: deserialize batch: incomplete message should be untouched", memcmp(buffer + len, "HTTP/1.1 200 OK\r\nContent-Length: 4\r\n\r\nla", 40) == 0);
+
+  memcpy(buffer + buffer_len, "st", 2);
+  count = ARR_SIZE(responses);
+  const uint32_t last_len = http1_deserialize_batch(buffer + len, buffer_len + 2 - len, responses, &count);
+
+  mu_assert("error: deserialize batch: wrong last length", last_len == buffer_len + 2 - len);
+  mu_assert("error: deserialize batch: wrong last count", count == 1);
+  mu_assert("error: deserialize batch: wrong last body", memcmp(responses[0].body, "last", 4) == 0);
+
+  return 0;
+}
+
+static char *test_deserialize_batch_stops(void)
+{
+  char chunked_buffer[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n"
+    "HTTP/1.1 200 OK\r\n"
+    "Transfer-Encoding: chunked\r\n"
+    "\r\n"
+    "5\r\nhello\r\n0\r\n\r\n";
+  char partial_buffer[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Len";
+  char invalid_buffer[] =
+    "HTTP/1.1 304 Not Modified\r\n"
+    "\r\n"
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Length 0\r\n"
+    "\r\n";
+  http_header_t headers[2][2] = {0};
+  http_response_t responses[2] = {
+    { .headers = headers[0], .headers_count = ARR_SIZE(headers[0]) },
+    { .headers = headers[1], .headers_count = ARR_SIZE(headers[1]) }
+  };
+
+  uint16_t count = ARR_SIZE(responses);
+  const uint32_t len = http1_deserialize_batch(chunked_buffer, STR_LEN(chunked_buffer), responses, &count);
+  mu_assert("error: deserialize batch stops: chunked body should end the batch", len == STR_LEN(chunked_buffer) - STR_LEN("5\r\nhello\r\n0\r\n\r\n"));
+  mu_assert("error: deserialize batch stops: wrong chunked count", count == 2 && responses[1].framing == HTTP_FRAMING_CHUNKED);
+
+  count = ARR_SIZE(responses);
+  mu_assert("error: deserialize batch stops: partial message should need more", http1_deserialize_batch(partial_buffer, STR_LEN(partial_buffer), responses, &count) == HTTP_NEED_MORE);
+  mu_assert("error: deserialize batch stops: wrong partial count", count == 0);
+  mu_assert("error: deserialize batch stops: partial message should be untouched", strcmp(partial_buffer, "HTTP/1.1 200 OK\r\nContent-Len") == 0);
+
+  count = ARR_SIZE(responses);
+  mu_assert("error: deserialize batch stops: invalid message should fail", http1_deserialize_batch(invalid_buffer, STR_LEN(invalid_buffer), responses, &count) == 0);
+
+  return 0;
+}
+
+static char *test_serialize_batch_write_pipelined(void)
+{
+  http_header_t headers[] = {
+    { .key = "Host", .value = "example.com", .key_len = 4, .value_len = 11 },
+    { .key = "Accept", .value = "*/*", .key_len = 6, .value_len = 3 }
+  };
+  const char expected_request[] =
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "Accept: */*\r\n"
+    "\r\n";
+  http_request_t requests[50];
+  for (uint8_t i = 0; i < ARR_SIZE(requests); i++)
+  {
+    requests[i] = (http_request_t){
+      .method = HTTP_GET,
+      .path = "/index.html",
+      .path_len = 11,
+      .version = HTTP_1_1,
+      .headers = headers,
+      .headers_count = ARR_SIZE(headers)
+    };
+  }
+
+  char expected[ARR_SIZE(requests) * STR_LEN(expected_request)];
+  for (uint8_t i = 0; i < ARR_SIZE(requests); i++)
+    memcpy(expected + i * STR_LEN(expected_request), expected_request, STR_LEN(expected_request));
+
+  char buffer[sizeof(expected) + 64];
+  const uint32_t len = http1_serialize_batch(buffer, requests, ARR_SIZE(requests));
+  mu_assert("error: serialize batch: wrong length", len == sizeof(expected));
+  mu_assert("error: serialize batch: wrong messages", memcmp(buffer, expected, len) == 0);
+
+  int fds[2];
+  mu_assert("error: serialize batch write pipelined: pipe failed", pipe(fds) == 0);
+  const int64_t written = http1_serialize_batch_write(fds[1], requests, ARR_SIZE(requests));
+  close(fds[1]);
+  const bool match = compare_file(fds[0], expected, sizeof(expected));
+  close(fds[0]);
+
+  mu_assert("error: serialize batch write pipelined: wrong length", written == (int64_t)sizeof(expected));
+  mu_assert("error: serialize batch write pipelined: wrong messages", match);
+
+  return 0;
+}
+
+static char *test_serialize_batch_write_iov_max(void)
+{
+  const uint16_t headers_count = (IOV_MAX - 8) / 4;
+  http_header_t *headers = calloc(headers_count, sizeof(http_header_t));
+  if (headers == NULL)
+    return strerror(errno);
+  for (uint16_t i = 0; i < headers_count; i++)
+    headers[i] = (http_header_t){ .key = "A", .value = "b", .key_len = 1, .value_len = 1 };
+
+  http_request_t requests[3];
+  for (uint8_t i = 0; i < ARR_SIZE(requests); i++)
+    requests[i] = (http_request_t){ .method = HTTP_GET, .path = "/", .path_len = 1, .version = HTTP_1_1, .headers = headers, .headers_count = headers_count };
+
+  const uint32_t request_len = STR_LEN("GET / HTTP/1.1\r\n") + headers_count * STR_LEN("A: b\r\n") + STR_LEN("\r\n");
+  char *const expected = malloc(request_len * ARR_SIZE(requests));
+  if (expected == NULL)
+  {
+    free(headers);
+    return strerror(errno);
+  }
+  const uint32_t expected_len = http1_serialize_batch(expected, requests, ARR_SIZE(requests));
+
+  int fds[2];
+  bool match = false;
+  int64_t written = -1;
+  if (pipe(fds) == 0)
+  {
+    written = http1_serialize_batch_write(fds[1], requests, ARR_SIZE(requests));
+    close(fds[1]);
+    match = compare_file(fds[0], expected, expected_len);
+    close(fds[0]);
+  }
+
+  requests[1].headers_count = headers_count + 1;
+  const int64_t too_many = http1_serialize_batch_write(STDOUT_FILENO, requests, ARR_SIZE(requests));
+
+  free(expected);
+  free(headers);
+
+  mu_assert("error: serialize batch write iov max: wrong length", written == (int64_t)expected_len && expected_len == request_len * ARR_SIZE(requests));
+  mu_assert("error: serialize batch write iov max: wrong messages", match);
+  mu_assert("error: serialize batch write iov max: too many headers should fail", too_many == -1);
+
+  return 0;
+}
+
+static char *test_serialize_write_long_fields(void)
+{
+  char path[100];
+  char value[300];
+  char body[5000];
+  memset(path, 'p', sizeof(path));
+  path[0] = '/';
+  memset(value, 'v', sizeof(value));
+  memset(body, 'b', sizeof(body));
+
+  http_header_t headers[] = {
+    { .key = "Host", .value = "example.com", .key_len = 4, .value_len = 11 },
+    { .key = "X-Long", .value = value, .key_len = 6, .value_len = sizeof(value) },
+    { .key = "Accept", .value = "*/*", .key_len = 6, .value_len = 3 }
+  };
+  http_request_t request = {
+    .method = HTTP_POST,
+    .path = path,
+    .path_len = sizeof(path),
+    .version = HTTP_1_1,
+    .headers = headers,
+    .headers_count = ARR_SIZE(headers),
+    .body = body,
+    .body_len = sizeof(body)
+  };
+
+  char expected[sizeof(path) + sizeof(value) + sizeof(body) + 256];
+  const uint32_t expected_len = http1_serialize(expected, &request);
+
+  int fds[2];
+  if (pipe(fds) == -1)
+    return strerror(errno);
+  const int32_t len = http1_serialize_write(fds[1], &request);
+  close(fds[1]);
+  const bool match = compare_file(fds[0], expected, expected_len);
+  close(fds[0]);
+
+  mu_assert("error: serialize write long fields: wrong length", len == (int32_t)expected_len);
+  mu_assert("error: serialize write long fields: wrong output", match);
+
+  return 0;
+}
+
+static char *test_serialize_batch_write_staging_full(void)
+{
+  char value[60];
+  memset(value, 'v', sizeof(value));
+
+  http_header_t headers[10];
+  for (uint8_t i = 0; i < ARR_SIZE(headers); i++)
+    headers[i] = (http_header_t){ .key = "X-Filler", .value = value, .key_len = 8, .value_len = sizeof(value) };
+
+  http_request_t requests[40];
+  for (uint8_t i = 0; i < ARR_SIZE(requests); i++)
+  {
+    requests[i] = (http_request_t){
+      .method = HTTP_GET,
+      .path = "/",
+      .path_len = 1,
+      .version = HTTP_1_1,
+      .headers = headers,
+      .headers_count = ARR_SIZE(headers)
+    };
+  }
+
+  static char expected[ARR_SIZE(requests) * 1024];
+  const uint32_t expected_len = http1_serialize_batch(expected, requests, ARR_SIZE(requests));
+
+  int fds[2];
+  if (pipe(fds) == -1)
+    return strerror(errno);
+  const int64_t written = http1_serialize_batch_write(fds[1], requests, ARR_SIZE(requests));
+  close(fds[1]);
+  const bool match = compare_file(fds[0], expected, expected_len);
+  close(fds[0]);
+
+  mu_assert("error: serialize batch write staging full: wrong length", written == (int64_t)expected_len);
+  mu_assert("error: serialize batch write staging full: wrong output", match);
+
+  return 0;
+}
+
+static char *test_uring_write(void)
+{
+  static http_uring_slot_t slots[8];
+  http_uring_t ring;
+  if (http_uring_init(&ring, slots, ARR_SIZE(slots)) == -1)
+    return (errno == ENOSYS || errno == EPERM) ? 0 : strerror(errno);
+
+  http_header_t headers[] = {
+    { .key = "Host", .value = "example.com", .key_len = 4, .value_len = 11 },
+    { .key = "Accept", .value = "*/*", .key_len = 6, .value_len = 3 }
+  };
+  http_request_t request = {
+    .method = HTTP_GET,
+    .path = "/index.html",
+    .path_len = 11,
+    .version = HTTP_1_1,
+    .headers = headers,
+    .headers_count = ARR_SIZE(headers)
+  };
+  const char expected[] =
+    "GET /index.html HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "Accept: */*\r\n"
+    "\r\n";
+
+  int fds[2][2];
+  if ((pipe(fds[0]) == -1) || (pipe(fds[1]) == -1))
+    return strerror(errno);
+
+  mu_assert("error: uring write: prep failed", http1_uring_prep_write(&ring, fds[0][1], &request, 100, 0) == STR_LEN(expected));
+  mu_assert("error: uring write: prep failed", http1_uring_prep_write(&ring, fds[1][1], &request, 200, 0) == STR_LEN(expected));
+  mu_assert("error: uring write: prep failed", http1_uring_prep_write(&ring, fds[0][1], &request, 300, 0) == STR_LEN(expected));
+  mu_assert("error: uring write: submit failed", http_uring_submit(&ring, 3) == 3);
+
+  http_uring_completion_t completions[8];
+  const uint16_t count = http_uring_reap(&ring, completions, ARR_SIZE(completions));
+  mu_assert("error: uring write: wrong completions count", count == 3);
+
+  uint64_t cookies = 0;
+  for (uint16_t i = 0; i < count; i++)
+  {
+    mu_assert("error: uring write: wrong result", completions[i].result == STR_LEN(expected));
+    cookies += completions[i].cookie;
+  }
+  mu_assert("error: uring write: wrong cookies", cookies == 600);
+
+  char twice[2 * STR_LEN(expected)];
+  memcpy(twice, expected, STR_LEN(expected));
+  memcpy(twice + STR_LEN(expected), expected, STR_LEN(expected));
+
+  close(fds[0][1]);
+  close(fds[1][1]);
+  mu_assert("error: uring write: wrong output", compare_file(fds[0][0], twice, sizeof(twice)));
+  mu_assert("error: uring write: wrong output", compare_file(fds[1][0], expected, STR_LEN(expected)));
+  close(fds[0][0]);
+  close(fds[1][0]);
+
+  http_uring_destroy(&ring);
+
+  return 0;
+}
+
+static char *test_uring_write_fixed(void)
+{
+  static http_uring_slot_t slots[2];
+  http_uring_t ring;
+  if (http_uring_init(&ring, slots, ARR_SIZE(slots)) == -1)
+    return (errno == ENOSYS || errno == EPERM) ? 0 : strerror(errno);
+
+  http_request_t request = {
+    .method = HTTP_POST,
+    .path = "/submit",
+    .path_len = 7,
+    .version = HTTP_1_1,
+    .body = "hello",
+    .body_len = 5
+  };
+  const char expected[] =
+    "POST /submit HTTP/1.1\r\n"
+    "\r\n"
+    "hello";
+
+  static char buffer[4096];
+  const struct iovec registered = { buffer, sizeof(buffer) };
+  mu_assert("error: uring write fixed: register buffers failed", http_uring_register_buffers(&ring, &registered, 1) == 0);
+
+  int fds[2];
+  if (pipe(fds) == -1)
+    return strerror(errno);
+  mu_assert("error: uring write fixed: register files failed", http_uring_register_files(&ring, &fds[1], 1) == 0);
+
+  mu_assert("error: uring write fixed: overflow not detected", http1_uring_prep_write_fixed(&ring, 0, &request, buffer, STR_LEN(expected) - 1, 0, 41, HTTP_URING_FIXED_FILE) == -1);
+  mu_assert("error: uring write fixed: prep failed", http1_uring_prep_write_fixed(&ring, 0, &request, buffer, STR_LEN(expected), 0, 42, HTTP_URING_FIXED_FILE) == STR_LEN(expected));
+  mu_assert("error: uring write fixed: prep failed", http1_uring_prep_write(&ring, 0, &request, 43, HTTP_URING_FIXED_FILE) == STR_LEN(expected));
+  mu_assert("error: uring write fixed: slots exhausted not detected", http1_uring_prep_write(&ring, 0, &request, 44, HTTP_URING_FIXED_FILE) == -1);
+  mu_assert("error: uring write fixed: submit failed", http_uring_submit(&ring, 2) == 2);
+
+  http_uring_completion_t completions[2];
+  mu_assert("error: uring write fixed: wrong completions count", http_uring_reap(&ring, completions, ARR_SIZE(completions)) == 2);
+  mu_assert("error: uring write fixed: wrong result", (completions[0].result == STR_LEN(expected)) && (completions[1].result == STR_LEN(expected)));
+  mu_assert("error: uring write fixed: wrong cookies", completions[0].cookie + completions[1].cookie == 85);
+
+  char twice[2 * STR_LEN(expected)];
+  memcpy(twice, expected, STR_LEN(expected));
+  memcpy(twice + STR_LEN(expected), expected, STR_LEN(expected));
+
+  http_uring_destroy(&ring);
+  close(fds[1]);
+  mu_assert("error: uring write fixed: wrong output", compare_file(fds[0], twice, sizeof(twice)));
+  close(fds[0]);
+
+  return 0;
+}
+
+static char *test_template(void)
+{
+  http_header_t headers[] = {
+    { .key = "Host", .value = "example.com", .key_len = 4, .value_len = 11, .id = HTTP_HEADER_HOST },
+    { .key = "X-Request-Id", .value = NULL, .key_len = 12 },
+    { .key = "Accept", .value = "*/*", .key_len = 6, .value_len = 3, .id = HTTP_HEADER_ACCEPT },
+    { .key = "Content-Length", .value = NULL, .key_len = 14, .id = HTTP_HEADER_CONTENT_LENGTH }
+  };
+  const http_request_t request = {
+    .method = HTTP_POST,
+    .path = NULL,
+    .version = HTTP_1_1,
+    .headers = headers,
+    .headers_count = ARR_SIZE(headers)
+  };
+  const char expected[] =
+    "POST /api/items HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "X-Request-Id: 42\r\n"
+    "Accept: */*\r\n"
+    "Content-Length: 5\r\n"
+    "\r\n"
+    "hello";
+
+  static http_request_template_t template;
+  const uint16_t template_len = http1_template_compile(&template, &request);
+  mu_assert("error: template: compile failed", template_len == STR_LEN(expected) - STR_LEN("/api/items") - STR_LEN("42") - STR_LEN("5") - STR_LEN("hello"));
+  mu_assert("error: template: wrong slots count", template.slots_count == 3);
+
+  const struct iovec values[] = {
+    { "/api/items", 10 },
+    { "42", 2 },
+    { "5", 1 }
+  };
+
+  char buffer[256];
+  const uint32_t len = http1_template_serialize(buffer, &template, values, "hello", 5);
+  mu_assert("error: template: wrong length", len == STR_LEN(expected));
+  mu_assert("error: template: wrong output", memcmp(buffer, expected, len) == 0);
+
+  int fds[2];
+  if (pipe(fds) == -1)
+    return strerror(errno);
+  const int32_t written = http1_template_write(fds[1], &template, values, "hello", 5);
+  close(fds[1]);
+  const bool match = compare_file(fds[0], expected, STR_LEN(expected));
+  close(fds[0]);
+
+  mu_assert("error: template write: wrong length", written == STR_LEN(expected));
+  mu_assert("error: template write: wrong output", match);
+
+  http_header_t slots[HTTP_TEMPLATE_MAX_SLOTS + 1];
+  for (uint8_t i = 0; i < ARR_SIZE(slots); i++)
+    slots[i] = (http_header_t){ .key = "X-Slot", .value = NULL, .key_len = 6 };
+  const http_request_t too_many = {
+    .method = HTTP_GET,
+    .path = "/",
+    .path_len = 1,
+    .version = HTTP_1_1,
+    .headers = slots,
+    .headers_count = ARR_SIZE(slots)
+  };
+  mu_assert("error: template: too many slots not detected", http1_template_compile(&template, &too_many) == 0);
+
+  return 0;
+}
+
+static char *test_serialize_write_file(void)
+{
+  static char body[20000];
+  for (uint32_t i = 0; i < sizeof(body); i++)
+    body[i] = 'a' + i % 26;
+
+  FILE *file = tmpfile();
+  if (file == NULL)
+    return strerror(errno);
+  const int body_fd = fileno(file);
+  if (write(body_fd, "skip", 4) != 4 || write(body_fd, body, sizeof(body)) != sizeof(body))
+    return strerror(errno);
+
+  http_header_t headers[] = {
+    { .key = "Host", .value = "example.com", .key_len = 4, .value_len = 11 },
+    { .key = "Content-Length", .value = "20000", .key_len = 14, .value_len = 5 }
+  };
+  const http_request_t request = {
+    .method = HTTP_PUT,
+    .path = "/upload",
+    .path_len = 7,
+    .version = HTTP_1_1,
+    .headers = headers,
+    .headers_count = ARR_SIZE(headers)
+  };
+  const char head[] =
+    "PUT /upload HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "Content-Length: 20000\r\n"
+    "\r\n";
+
+  static char expected[STR_LEN(head) + sizeof(body)];
+  memcpy(expected, head, STR_LEN(head));
+  memcpy(expected + STR_LEN(head), body, sizeof(body));
+
+  int fds[2];
+  if (pipe(fds) == -1)
+    return strerror(errno);
+  const int64_t written = http1_serialize_write_file(fds[1], &request, body_fd, 4, sizeof(body));
+  close(fds[1]);
+  const bool match = compare_file(fds[0], expected, sizeof(expected));
+  close(fds[0]);
+  fclose(file);
+
+  mu_assert("error: serialize write file: wrong length", written == (int64_t)sizeof(expected));
+  mu_assert("error: serialize write file: wrong output", match);
+
+  return 0;
+}
+
+static char *test_serialize_response_write_file_pipe(void)
+{
+  const char body[] = "<html>static page</html>";
+  const http_response_t response = {
+    .version = HTTP_1_1,
+    .status_code = 200
+  };
+  const char expected[] =
+    "HTTP/1.1 200 OK\r\n"
+    "\r\n"
+    "<html>static page</html>";
+
+  int body_fds[2];
+  int fds[2];
+  if ((pipe(body_fds) == -1) || (pipe(fds) == -1))
+    return strerror(errno);
+  if (write(body_fds[1], body, STR_LEN(body)) != STR_LEN(body))
+    return strerror(errno);
+
+  const int64_t written = http1_serialize_response_write_file(fds[1], &response, body_fds[0], 0, STR_LEN(body));
+  close(fds[1]);
+  const bool match = compare_file(fds[0], expected, STR_LEN(expected));
+  close(fds[0]);
+
+  mu_assert("error: serialize response write file pipe: wrong length", written == STR_LEN(expected));
+  mu_assert("error: serialize response write file pipe: wrong output", match);
+
+  close(body_fds[1]);
+  if (pipe(fds) == -1)
+    return strerror(errno);
+  const int64_t truncated = http1_serialize_response_write_file(fds[1], &response, body_fds[0], 0, 1);
+  const bool no_data = (errno == ENODATA);
+  close(fds[0]);
+  close(fds[1]);
+  close(body_fds[0]);
+  mu_assert("error: serialize response write file pipe: truncated body not detected", no_data);
+  mu_assert("error: serialize response write file pipe: head of truncated body not counted", truncated == STR_LEN(expected) - STR_LEN(body));
+
+  return 0;
+}
+
+static char *test_serialize_write_zerocopy(void)
+{
+  const int listener = socket(AF_INET, SOCK_STREAM, 0);
+  struct sockaddr_in addr = { .sin_family = AF_INET, .sin_addr.s_addr = htonl(INADDR_LOOPBACK) };
+  socklen_t addr_len = sizeof(addr);
+  if ((listener == -1) || bind(listener, (struct sockaddr *)&addr, sizeof(addr)) || listen(listener, 1) || getsockname(listener, (struct sockaddr *)&addr, &addr_len))
+    return strerror(errno);
+
+  const int client = socket(AF_INET, SOCK_STREAM, 0);
+  if ((client == -1) || connect(client, (struct sockaddr *)&addr, sizeof(addr)))
+    return strerror(errno);
+  const int server = accept(listener, NULL, NULL);
+  close(listener);
+  if (server == -1)
+    return strerror(errno);
+
+  http_zerocopy_t tracker;
+  if (http_zerocopy_init(&tracker, client) == -1)
+  {
+    close(client);
+    close(server);
+    return (errno == ENOPROTOOPT || errno == EOPNOTSUPP) ? 0 : strerror(errno);
+  }
+
+  static char body[HTTP_ZEROCOPY_THRESHOLD * 2];
+  memset(body, 'z', sizeof(body));
+  const http_request_t request = {
+    .method = HTTP_POST,
+    .path = "/upload",
+    .path_len = 7,
+    .version = HTTP_1_1,
+    .body = body,
+    .body_len = sizeof(body)
+  };
+  const http_request_t small = {
+    .method = HTTP_GET,
+    .path = "/",
+    .path_len = 1,
+    .version = HTTP_1_1
+  };
+
+  static char expected[sizeof(body) + 64];
+  const uint32_t expected_len = http1_serialize(expected, &request);
+  const uint32_t small_len = http1_serialize(expected + expected_len, &small);
+
+  uint32_t handle;
+  const int64_t written = http1_serialize_write_zerocopy(&tracker, &request, &handle);
+  mu_assert("error: serialize write zerocopy: wrong length", written == expected_len);
+  uint32_t small_handle;
+  mu_assert("error: serialize write zerocopy: small message failed", http1_serialize_write_zerocopy(&tracker, &small, &small_handle) == small_len);
+  mu_assert("error: serialize write zerocopy: small message should be done", http_zerocopy_done(&tracker, small_handle));
+
+  shutdown(client, SHUT_WR);
+  const bool match = compare_file(server, expected, expected_len + small_len);
+  mu_assert("error: serialize write zerocopy: wrong output", match);
+
+  struct pollfd pfd = { .fd = client };
+  for (uint8_t i = 0; (i < 100) && !http_zerocopy_done(&tracker, handle); i++)
+  {
+    poll(&pfd, 1, 10);
+    mu_assert("error: serialize write zerocopy: reap failed", http_zerocopy_reap(&tracker) != -1);
+  }
+  mu_assert("error: serialize write zerocopy: completion not reported", http_zerocopy_done(&tracker, handle));
+
+  close(client);
+  close(server);
+
+  return 0;
+}
+
+static char *test_deserialize_iov_seams(void)
+{
+  const char message[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/html\r\n"
+    "Content-Length: 13\r\n"
+    "X-Long-Header-Name-For-The-Blocks: some value that is long enough to cross a 64 byte block\r\n"
+    "Connection: keep-alive\r\n"
+    "\r\n"
+    "Hello, World!";
+  const uint32_t head_len = STR_LEN(message) - 13;
+
+  for (uint32_t seam = 1; seam < STR_LEN(message); seam++)
+  {
+    char first[sizeof(message)];
+    char second[sizeof(message)];
+    memcpy(first, message, seam);
+    memcpy(second, message + seam, STR_LEN(message) - seam);
+    const struct iovec iov[] = {
+      { first, seam },
+      { second, STR_LEN(message) - seam }
+    };
+
+    http_header_t headers[8];
+    http_response_t response = { .headers = headers, .headers_count = ARR_SIZE(headers) };
+    char scratch[256];
+
+    const uint32_t len = http1_deserialize_iov(iov, ARR_SIZE(iov), &response, scratch, sizeof(scratch));
+    mu_assert("error: deserialize iov: wrong length", len == head_len);
+    mu_assert("error: deserialize iov: wrong status code", response.status_code == 200);
+    mu_assert("error: deserialize iov: wrong headers count", response.headers_count == 4);
+    mu_assert("error: deserialize iov: wrong header", strcmp(headers[0].key, "Content-Type") == 0 && strcmp(headers[0].value, "text/html") == 0);
+    mu_assert("error: deserialize iov: wrong header", strcmp(headers[2].value, "some value that is long enough to cross a 64 byte block") == 0);
+    mu_assert("error: deserialize iov: wrong header", strcmp(headers[3].key, "Connection") == 0 && strcmp(headers[3].value, "keep-alive") == 0);
+    mu_assert("error: deserialize iov: wrong framing", response.framing == HTTP_FRAMING_CONTENT_LENGTH && response.body_len == 13);
+    mu_assert("error: deserialize iov: wrong body", response.body == ((seam <= head_len) ? second + head_len - seam : first + head_len));
+
+    const bool in_first = (headers[1].value >= first) && (headers[1].value < first + seam);
+    const bool in_second = (headers[1].value >= second) && (headers[1].value < second + sizeof(second));
+    const bool straddles = (seam > 17 + 25) && (seam < 17 + 25 + 20);
+    mu_assert("error: deserialize iov: header not in the original memory", straddles || in_first || in_second);
+  }
+
+  return 0;
+}
+
+static char *test_deserialize_iov_incomplete(void)
+{
+  char first[] = "HTTP/1.1 204 No Content\r\nDa";
+  char second[] = "te: Tue, 15 Nov 1994 08:12:31 GMT\r";
+  char third[] = "\n\r";
+  char fourth[] = "\n";
+  const struct iovec iov[] = {
+    { first, STR_LEN(first) },
+    { second, STR_LEN(second) },
+    { third, STR_LEN(third) },
+    { fourth, STR_LEN(fourth) }
+  };
+
+  http_header_t headers[4];
+  http_response_t response = { .headers = headers, .headers_count = ARR_SIZE(headers) };
+  char scratch[64];
+
+  mu_assert("error: deserialize iov incomplete: missing data not detected", http1_deserialize_iov(iov, 3, &response, scratch, sizeof(scratch)) == HTTP_NEED_MORE);
+  mu_assert("error: deserialize iov incomplete: buffer not restored", memcmp(first, "HTTP/1.1 204 No Content\r\nDa", STR_LEN(first)) == 0);
+
+  response.headers_count = ARR_SIZE(headers);
+  const uint32_t len = http1_deserialize_iov(iov, ARR_SIZE(iov), &response, scratch, sizeof(scratch));
+  mu_assert("error: deserialize iov incomplete: wrong length", len == STR_LEN(first) + STR_LEN(second) + STR_LEN(third) + STR_LEN(fourth));
+  mu_assert("error: deserialize iov incomplete: wrong header", response.headers_count == 1 && strcmp(headers[0].key, "Date") == 0);
+  mu_assert("error: deserialize iov incomplete: wrong header", strcmp(headers[0].value, "Tue, 15 Nov 1994 08:12:31 GMT") == 0);
+  mu_assert("error: deserialize iov incomplete: wrong body", response.body == NULL && response.framing == HTTP_FRAMING_NONE);
+
+  memcpy(first, "HTTP/1.1 204 No Content\r\nDa", STR_LEN(first));
+  memcpy(second, "te: Tue, 15 Nov 1994 08:12:31 GMT\r", STR_LEN(second));
+  response.headers_count = ARR_SIZE(headers);
+  mu_assert("error: deserialize iov incomplete: small scratch not detected", http1_deserialize_iov(iov, ARR_SIZE(iov), &response, scratch, 8) == 0);
+
+  return 0;
+}
+
+static char *test_ring_wraparound(void)
+{
+  http_ring_t ring;
+  if (http_ring_init(&ring, 1000) == -1)
+    return strerror(errno);
+
+  const uint32_t size = ring.size;
+  mu_assert("error: ring: size not rounded to pages", (size >= 1000) && ((size & (size - 1)) == 0));
+
+  ring.data[0] = 'm';
+  mu_assert("error: ring: pages not mirrored", ring.data[size] == 'm');
+
+  //moves the positions close to the end, so that the next message wraps
+  http_ring_produce(&ring, size - 20);
+  http_ring_consume(&ring, size - 20);
+
+  const http_request_t request = {
+    .method = HTTP_GET,
+    .path = "/index.html",
+    .path_len = 11,
+    .version = HTTP_1_1
+  };
+  const char expected[] =
+    "GET /index.html HTTP/1.1\r\n"
+    "\r\n";
+  http_ring_produce(&ring, http1_serialize(http_ring_write_ptr(&ring), &request));
+  mu_assert("error: ring: wrong readable", http_ring_readable(&ring) == STR_LEN(expected));
+  mu_assert("error: ring: serialized message not contiguous", memcmp(http_ring_read_ptr(&ring), expected, STR_LEN(expected)) == 0);
+
+  int fds[2];
+  if (pipe(fds) == -1)
+    return strerror(errno);
+  mu_assert("error: ring: send failed", http_ring_send(&ring, fds[1]) == STR_LEN(expected));
+  mu_assert("error: ring: not drained", http_ring_readable(&ring) == 0);
+  mu_assert("error: ring: empty send should not look like a write", http_ring_send(&ring, fds[1]) == -1 && errno == ENODATA);
+
+  const char message[] =
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Length: 13\r\n"
+    "\r\n"
+    "Hello, World!";
+  if (write(fds[1], message, STR_LEN(message)) != STR_LEN(message))
+    return strerror(errno);
+  close(fds[1]);
+
+  char discard[STR_LEN(expected)];
+  mu_assert("error: ring: wrong output", read(fds[0], discard, sizeof(discard)) == sizeof(discard) && memcmp(discard, expected, sizeof(discard)) == 0);
+  mu_assert("error: ring: recv failed", http_ring_recv(&ring, fds[0]) == STR_LEN(message));
+  close(fds[0]);
+
+  http_header_t headers[4];
+  http_response_t response = { .headers = headers, .headers_count = ARR_SIZE(headers) };
+  const uint32_t len = http1_deserialize(http_ring_read_ptr(&ring), http_ring_readable(&ring), &response);
+  mu_assert("error: ring: wrapped message not parsed", len == STR_LEN(message) - 13);
+  mu_assert("error: ring: wrong body", response.body_len == 13 && memcmp(response.body, "Hello, World!", 13) == 0);
+  http_ring_consume(&ring, len + response.body_len);
+  mu_assert("error: ring: wrong writable", http_ring_writable(&ring) == size);
+
+  http_ring_produce(&ring, size);
+  mu_assert("error: ring: full recv should not look like EOF", http_ring_recv(&ring, -1) == -1 && errno == ENOBUFS);
+
+  http_ring_destroy(&ring);
+
+  return 0;
+}
+
+static char *test_deserialize_arena(void)
+{
+  static char memory[4096 + 64];
+  static char buffer[4096];
+  http_arena_t arena;
+  http_arena_init(&arena, memory + 1, sizeof(memory) - 1);
+
+  uint32_t len = 0;
+  len += sprintf(buffer + len, "HTTP/1.1 200 OK\r\n");
+  for (uint8_t i = 0; i < 70; i++)
+    len += sprintf(buffer + len, "X-Header-%u: %u\r\n", i, i);
+  len += sprintf(buffer + len, "Content-Length: 0\r\n\r\n");
+
+  http_response_t response;
+  mu_assert("error: deserialize arena: parsing failed", http1_deserialize_arena(buffer, len, &response, &arena) == len);
+  mu_assert("error: deserialize arena: wrong headers count", response.headers_count == 71);
+  mu_assert("error: deserialize arena: headers not aligned", ((uintptr_t)response.headers & (HTTP_ARENA_ALIGNMENT - 1)) == 0);
+  mu_assert("error: deserialize arena: wrong header", strcmp(response.headers[69].key, "X-Header-69") == 0 && strcmp(response.headers[69].value, "69") == 0);
+  mu_assert("error: deserialize arena: headers not committed", arena.used == 71 * sizeof(http_header_t));
+
+  char *const next = http_arena_alloc(&arena, 10);
+  mu_assert("error: deserialize arena: allocation overlaps the headers", next >= (char *)(response.headers + 71));
+  mu_assert("error: deserialize arena: allocation not aligned", ((uintptr_t)next & (HTTP_ARENA_ALIGNMENT - 1)) == 0);
+
+  http_arena_reset(&arena);
+  char request_buffer[] =
+    "GET / HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "\r\n";
+  http_request_t request;
+  mu_assert("error: deserialize arena: request parsing failed", http1_deserialize_request_arena(request_buffer, STR_LEN(request_buffer), &request, &arena) == STR_LEN(request_buffer));
+  mu_assert("error: deserialize arena: arena not reused", (void *)request.headers == (void *)response.headers);
+  mu_assert("error: deserialize arena: wrong request header", request.headers_count == 1 && strcmp(request.headers[0].value, "example.com") == 0);
+
+  http_arena_t small;
+  http_arena_init(&small, memory, 4 * sizeof(http_header_t));
+  len = sprintf(buffer, "HTTP/1.1 200 OK\r\nA: 1\r\nB: 2\r\nC: 3\r\nD: 4\r\nE: 5\r\n\r\n");
+  mu_assert("error: deserialize arena: exhausted arena not detected", http1_deserialize_arena(buffer, len, &response, &small) == 0);
+  mu_assert("error: deserialize arena: failed parse committed", small.used == 0);
+
+  return 0;
+}
+
+static char *test_deserialize_compact(void)
+{
+  static char buffer[4096];
+  char moved[4096];
+  http_compact_headers_t compact;
+  http_response_t response;
+
+  uint32_t len = sprintf(buffer,
+    "HTTP/1.1 200 OK\r\n"
+    "Content-Type: text/plain\r\n"
+    "Set-Cookie: a=1\r\n"
+    "X-Custom: custom\r\n"
+    "Set-Cookie: b=2\r\n"
+    "Content-Length: 4\r\n"
+    "\r\n"
+    "body");
+  mu_assert("error: deserialize compact: parsing failed", http1_deserialize_compact(buffer, len, &response, &compact) == len - 4);
+  mu_assert("error: deserialize compact: wrong headers count", compact.count == 5 && response.headers_count == 5);
+  mu_assert("error: deserialize compact: wrong framing", response.framing == HTTP_FRAMING_CONTENT_LENGTH && response.body_len == 4);
+  mu_assert("error: deserialize compact: wrong offsets", compact.key_offsets[0] == STR_LEN("HTTP/1.1 200 OK\r\n") && compact.value_lens[0] == STR_LEN("text/plain"));
+
+  memcpy(moved, buffer, len);
+  memset(buffer, 0, len);
+
+  const uint16_t type = http_compact_find_id(&compact, HTTP_HEADER_CONTENT_TYPE, 0);
+  mu_assert("error: deserialize compact: id not found", type == 0 && strcmp(moved + compact.value_offsets[type], "text/plain") == 0);
+  mu_assert("error: deserialize compact: missing id found", http_compact_find_id(&compact, HTTP_HEADER_LOCATION, 0) == HTTP_COMPACT_NONE);
+
+  const uint16_t first = http_compact_find(&compact, moved, "set-cookie", STR_LEN("set-cookie"), 0);
+  const uint16_t second = http_compact_find(&compact, moved, "set-cookie", STR_LEN("set-cookie"), first + 1);
+  mu_assert("error: deserialize compact: name not found after relocation", first == 1 && strcmp(moved + compact.value_offsets[first], "a=1") == 0);
+  mu_assert("error: deserialize compact: duplicate not found", second == 3 && strcmp(moved + compact.value_offsets[second], "b=2") == 0);
+  mu_assert("error: deserialize compact: search past the duplicates", http_compact_find(&compact, moved, "set-cookie", STR_LEN("set-cookie"), second + 1) == HTTP_COMPACT_NONE);
+  mu_assert("error: deserialize compact: custom name not found", http_compact_find(&compact, moved, "X-CUSTOM", STR_LEN("X-CUSTOM"), 0) == 2);
+
+  char request_buffer[] =
+    "GET / HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "\r\n";
+  http_request_t request;
+  mu_assert("error: deserialize compact: request parsing failed", http1_deserialize_request_compact(request_buffer, STR_LEN(request_buffer), &request, &compact) == STR_LEN(request_buffer));
+  mu_assert("error: deserialize compact: wrong request header", compact.count == 1 && compact.ids[0] == HTTP_HEADER_HOST && strcmp(request_buffer + compact.value_offsets[0], "example.com") == 0);
+
+  len = sprintf(buffer, "HTTP/1.1 200 OK\r\n");
+  for (uint8_t i = 0; i <= HTTP_COMPACT_MAX_HEADERS; i++)
+    len += sprintf(buffer + len, "X-Header-%u: %u\r\n", i, i);
+  len += sprintf(buffer + len, "\r\n");
+  mu_assert("error: deserialize compact: too many headers not detected", http1_deserialize_compact(buffer, len, &response, &compact) == 0);
+
+  return 0;
+}
+
+static char *test_deserialize_status_line_shapes(void)
+{
+  http_response_t response;
+  http_header_t headers[1];
+
+  char moved[] = "HTTP/1.0 301 Moved Permanently\r\nContent-Length: 0\r\n\r\n";
+  response = (http_response_t){ .headers = headers, .headers_count = 1 };
+  mu_assert("error: deserialize status line: fixed shape failed", http1_deserialize(moved, STR_LEN(moved), &response) == STR_LEN(moved));
+  mu_assert("error: deserialize status line: wrong fixed shape fields", response.status_code == 301 && response.version == HTTP_1_0 && strcmp(response.reason_phrase, "Moved Permanently") == 0);
+
+  char spaced[] = "HTTP/1.1  404 Not Found\r\nContent-Length: 0\r\n\r\n";
+  response = (http_response_t){ .headers = headers, .headers_count = 1 };
+  mu_assert("error: deserialize status line: fallback failed", http1_deserialize(spaced, STR_LEN(spaced), &response) == STR_LEN(spaced));
+  mu_assert("error: deserialize status line: wrong fallback fields", response.status_code == 404 && response.version == HTTP_1_1 && strcmp(response.reason_phrase, "Not Found") == 0);
+
+  char bad_digit[] = "HTTP/1.1 2x0 OK\r\n\r\n";
+  response = (http_response_t){ .headers = headers, .headers_count = 1 };
+  mu_assert("error: deserialize status line: bad digit accepted", http1_deserialize(bad_digit, STR_LEN(bad_digit), &response) == 0);
+
+  char bad_version[] = "HTTP/2.0 200 OK\r\n\r\n";
+  response = (http_response_t){ .headers = headers, .headers_count = 1 };
+  mu_assert("error: deserialize status line: bad version accepted", http1_deserialize(bad_version, STR_LEN(bad_version), &response) == 0);
+
+  char bad_code[] = "HTTP/1.1 099 Weird\r\n\r\n";
+  response = (http_response_t){ .headers = headers, .headers_count = 1 };
+  mu_assert("error: deserialize status line: bad status code accepted", http1_deserialize(bad_code, STR_LEN(bad_code), &response) == 0);
+
+  return 0;
+}
+
+static char *test_serialize_content_length(void)
+{
+  const uint32_t lengths[] = { 0, 7, 10, 99, 100, 12'345, 1'000'000'000, UINT32_MAX };
+  const char *const expected_digits[] = { "0", "7", "10", "99", "100", "12345", "1000000000", "4294967295" };
+  char buffer[256];
+  char expected[256];
+
+  http_header_t headers[] = {
+    { .key = "Host", .value = "example.com", .key_len = 4, .value_len = 11 }
+  };
+
+  for (uint8_t i = 0; i < ARR_SIZE(lengths); i++)
+  {
+    http_request_t request = {
+      .method = HTTP_POST,
+      .path = "/",
+      .path_len = 1,
+      .version = HTTP_1_1,
+      .headers = headers,
+      .headers_count = ARR_SIZE(headers),
+      .body_len = lengths[i],
+      .emit_content_length = true
+    };
+    const uint32_t expected_len = sprintf(expected, "POST / HTTP/1.1\r\nContent-Length: %s\r\nHost: example.com\r\n\r\n", expected_digits[i]);
+
+    mu_assert("error: serialize content length: wrong length", http1_serialize(buffer, &request) == expected_len);
+    mu_assert("error: serialize content length: wrong output", memcmp(buffer, expected, expected_len) == 0);
+  }
+
+  http_request_t request = {
+    .method = HTTP_PUT,
+    .path = "/upload",
+    .path_len = 7,
+    .version = HTTP_1_1,
+    .headers = headers,
+    .headers_count = ARR_SIZE(headers),
+    .body = "hello world",
+    .body_len = 11,
+    .emit_content_length = true
+  };
+  const uint32_t expected_len = http1_serialize(expected, &request);
+  mu_assert("error: serialize content length: missing header", memmem(expected, expected_len, "Content-Length: 11\r\n", 20) != NULL);
+
+  int fds[2];
+  if (pipe(fds) == -1)
+    return strerror(errno);
+  const int32_t written = http1_serialize_write(fds[1], &request);
+  close(fds[1]);
+  const bool match = compare_file(fds[0], expected, expected_len);
+  close(fds[0]);
+  mu_assert("error: serialize content length: wrong write length", written == (int32_t)expected_len);
+  mu_assert("error: serialize content length: wrong write output", match);
+
+  http_response_t response = {
+    .version = HTTP_1_1,
+    .status_code = 200,
+    .body = "ok",
+    .body_len = 2,
+    .emit_content_length = true
+  };
+  const char expected_response[] = "HTTP/1.1 200 OK\r\nContent-Length: 2\r\n\r\nok";
+  mu_assert("error: serialize content length: wrong response", http1_serialize_response(buffer, &response) == STR_LEN(expected_response) && memcmp(buffer, expected_response, STR_LEN(expected_response)) == 0);
+
+  if (pipe(fds) == -1)
+    return strerror(errno);
+  const int32_t response_written = http1_serialize_response_write(fds[1], &response);
+  close(fds[1]);
+  const bool response_match = compare_file(fds[0], expected_response, STR_LEN(expected_response));
+  close(fds[0]);
+  mu_assert("error: serialize content length: wrong response write", response_written == STR_LEN(expected_response) && response_match);
+
+  return 0;
+}
+
+static char *test_serialize_batch_write_content_length(void)
+{
+  char value[60];
+  memset(value, 'v', sizeof(value));
+
+  http_header_t headers[10];
+  for (uint8_t i = 0; i < ARR_SIZE(headers); i++)
+    headers[i] = (http_header_t){ .key = "X-Filler", .value = value, .key_len = 8, .value_len = sizeof(value) };
+
+  char path[63];
+  memset(path, 'p', sizeof(path));
+  path[0] = '/';
+
+  http_request_t requests[40];
+  for (uint8_t i = 0; i < ARR_SIZE(requests); i++)
+  {
+    requests[i] = (http_request_t){
+      .method = HTTP_OPTIONS,
+      .path = path,
+      .path_len = sizeof(path),
+      .version = HTTP_1_1,
+      .headers = headers,
+      .headers_count = i % ARR_SIZE(headers),
+      .body = value,
+      .body_len = i,
+      .emit_content_length = true
+    };
+  }
+
+  static char expected[ARR_SIZE(requests) * 1024];
+  const uint32_t expected_len = http1_serialize_batch(expected, requests, ARR_SIZE(requests));
+
+  int fds[2];
+  if (pipe(fds) == -1)
+    return strerror(errno);
+  const int64_t written = http1_serialize_batch_write(fds[1], requests, ARR_SIZE(requests));
+  close(fds[1]);
+  const bool match = compare_file(fds[0], expected, expected_len);
+  close(fds[0]);
+
+  mu_assert("error: serialize batch write content length: wrong length", written == (int64_t)expected_len);
+  mu_assert("error: serialize batch write content length: wrong output", match);
+
+  return 0;
+}
+
+static char *test_hpack_rfc_requests(void)
+{
+  alignas(64) static char memory[HTTP_HPACK_TABLE_MEMORY(HTTP_HPACK_DEFAULT_TABLE_SIZE)];
+  alignas(64) static char peer_memory[HTTP_HPACK_TABLE_MEMORY(HTTP_HPACK_DEFAULT_TABLE_SIZE)];
+  http_hpack_table_t encoder;
+  http_hpack_table_t decoder;
+  http_hpack_table_init(&encoder, memory, HTTP_HPACK_DEFAULT_TABLE_SIZE);
+  http_hpack_table_init(&decoder, peer_memory, HTTP_HPACK_DEFAULT_TABLE_SIZE);
+
+  //RFC 7541 C.4.1 to C.4.3
+  http_header_t requests[][5] = {
+    {
+      { .key = ":method", .key_len = 7, .value = "GET", .value_len = 3 },
+      { .key = ":scheme", .key_len = 7, .value = "http", .value_len = 4 },
+      { .key = ":path", .key_len = 5, .value = "/", .value_len = 1 },
+      { .key = ":authority", .key_len = 10, .value = "www.example.com", .value_len = 15 }
+    },
+    {
+      { .key = ":method", .key_len = 7, .value = "GET", .value_len = 3 },
+      { .key = ":scheme", .key_len = 7, .value = "http", .value_len = 4 },
+      { .key = ":path", .key_len = 5, .value = "/", .value_len = 1 },
+      { .key = ":authority", .key_len = 10, .value = "www.example.com", .value_len = 15 },
+      { .id = HTTP_HEADER_CACHE_CONTROL, .value = "no-cache", .value_len = 8 }
+    },
+    {
+      { .key = ":method", .key_len = 7, .value = "GET", .value_len = 3 },
+      { .key = ":scheme", .key_len = 7, .value = "https", .value_len = 5 },
+      { .key = ":path", .key_len = 5, .value = "/index.html", .value_len = 11 },
+      { .key = ":authority", .key_len = 10, .value = "www.example.com", .value_len = 15 },
+      { .key = "custom-key", .key_len = 10, .value = "custom-value", .value_len = 12 }
+    }
+  };
+  const uint16_t counts[] = { 4, 5, 5 };
+  const char *const expected[] = {
+    "\x82\x86\x84\x41\x8c\xf1\xe3\xc2\xe5\xf2\x3a\x6b\xa0\xab\x90\xf4\xff",
+    "\x82\x86\x84\xbe\x58\x86\xa8\xeb\x10\x64\x9c\xbf",
+    "\x82\x87\x85\xbf\x40\x88\x25\xa8\x49\xe9\x5b\xa9\x7d\x7f\x89\x25\xa8\x49\xe9\x5b\xb8\xe8\xb4\xbf"
+  };
+  const uint32_t expected_lens[] = { 17, 12, 24 };
+
+  for (uint8_t i = 0; i < ARR_SIZE(requests); i++)
+  {
+    char block[128];
+    const uint32_t len = http_hpack_encode(&encoder, block, requests[i], counts[i]);
+    mu_assert("error: hpack rfc requests: wrong encoding", len == expected_lens[i] && memcmp(block, expected[i], len) == 0);
+
+    http_header_t headers[8];
+    uint16_t headers_count = ARR_SIZE(headers);
+    char scratch[256];
+    mu_assert("error: hpack rfc requests: decoding failed", http_hpack_decode(&decoder, block, len, headers, &headers_count, scratch, sizeof(scratch)));
+    mu_assert("error: hpack rfc requests: wrong headers count", headers_count == counts[i]);
+
+    for (uint16_t j = 0; j < headers_count; j++)
+    {
+      const http_header_t *const header = &requests[i][j];
+      const char *const key = header->id ? "cache-control" : header->key;
+      mu_assert("error: hpack rfc requests: wrong key", headers[j].key_len == strlen(key) && memcmp(headers[j].key, key, headers[j].key_len) == 0);
+      mu_assert("error: hpack rfc requests: wrong value", headers[j].value_len == header->value_len && memcmp(headers[j].value, header->value, header->value_len) == 0);
+    }
+  }
+
+  mu_assert("error: hpack rfc requests: wrong table size", encoder.size == 164 && decoder.size == 164 && decoder.count == 3);
+
+  return 0;
+}
+
+static char *test_hpack_decode_raw_literals(void)
+{
+  alignas(64) static char memory[HTTP_HPACK_TABLE_MEMORY(HTTP_HPACK_DEFAULT_TABLE_SIZE)];
+  http_hpack_table_t table;
+  http_hpack_table_init(&table, memory, HTTP_HPACK_DEFAULT_TABLE_SIZE);
+
+  //RFC 7541 C.2.1 and C.3.1
+  char block[] =
+    "\x40\x0a" "custom-key" "\x0d" "custom-header"
+    "\x82\x86\x84\x41\x0f" "www.example.com";
+  http_header_t headers[8];
+  uint16_t headers_count = ARR_SIZE(headers);
+  char scratch[64];
+
+  mu_assert("error: hpack raw literals: decoding failed", http_hpack_decode(&table, block, STR_LEN(block), headers, &headers_count, scratch, sizeof(scratch)));
+  mu_assert("error: hpack raw literals: wrong headers count", headers_count == 5);
+  mu_assert("error: hpack raw literals: literal copied", headers[0].key == block + 2 && headers[0].value == block + 13 && headers[4].value == block + STR_LEN(block) - 15);
+  mu_assert("error: hpack raw literals: wrong static header", headers[1].value_len == 3 && memcmp(headers[1].value, "GET", 3) == 0);
+  mu_assert("error: hpack raw literals: wrong table", table.count == 2 && table.size == 55 + 57);
+
+  char dynamic[] = "\xbf\xbe";
+  headers_count = ARR_SIZE(headers);
+  mu_assert("error: hpack raw literals: dynamic decoding failed", http_hpack_decode(&table, dynamic, STR_LEN(dynamic), headers, &headers_count, scratch, sizeof(scratch)));
+  mu_assert("error: hpack raw literals: wrong dynamic header", headers_count == 2 && headers[0].value_len == 13 && memcmp(headers[0].value, "custom-header", 13) == 0);
+  mu_assert("error: hpack raw literals: wrong newest header", headers[1].key_len == 10 && memcmp(headers[1].key, ":authority", 10) == 0);
+
+  char invalid_index[] = "\xc0";
+  headers_count = ARR_SIZE(headers);
+  mu_assert("error: hpack raw literals: invalid index accepted", !http_hpack_decode(&table, invalid_index, STR_LEN(invalid_index), headers, &headers_count, scratch, sizeof(scratch)));
+
+  char late_update[] = "\x82\x3f\xe1\x1f";
+  headers_count = ARR_SIZE(headers);
+  mu_assert("error: hpack raw literals: late table size update accepted", !http_hpack_decode(&table, late_update, STR_LEN(late_update), headers, &headers_count, scratch, sizeof(scratch)));
+
+  char truncated[] = "\x40\x0a" "custom";
+  headers_count = ARR_SIZE(headers);
+  mu_assert("error: hpack raw literals: truncated literal accepted", !http_hpack_decode(&table, truncated, STR_LEN(truncated), headers, &headers_count, scratch, sizeof(scratch)));
+
+  return 0;
+}
+
+static char *test_hpack_eviction(void)
+{
+  alignas(64) static char memory[HTTP_HPACK_TABLE_MEMORY(256)];
+  alignas(64) static char peer_memory[HTTP_HPACK_TABLE_MEMORY(256)];
+  http_hpack_table_t encoder;
+  http_hpack_table_t decoder;
+  http_hpack_table_init(&encoder, memory, 256);
+  http_hpack_table_init(&decoder, peer_memory, 256);
+
+  char names[3][16];
+  char values[3][32];
+  for (uint8_t round = 0; round < 40; round++)
+  {
+    http_header_t headers[3];
+    for (uint8_t i = 0; i < ARR_SIZE(headers); i++)
+    {
+      const uint8_t n = (round + i) % 7;
+      headers[i] = (http_header_t){
+        .key = names[i],
+        .key_len = sprintf(names[i], "x-name-%u", n),
+        .value = values[i],
+        .value_len = sprintf(values[i], "value-%u-%u", n, round % 3)
+      };
+    }
+
+    char block[256];
+    uint32_t len = 0;
+    if (round == 20)
+      len += http_hpack_encode_table_size(&encoder, block, 100);
+    len += http_hpack_encode(&encoder, block + len, headers, ARR_SIZE(headers));
+
+    http_header_t decoded[4];
+    uint16_t decoded_count = ARR_SIZE(decoded);
+    char scratch[256];
+    mu_assert("error: hpack eviction: decoding failed", http_hpack_decode(&decoder, block, len, decoded, &decoded_count, scratch, sizeof(scratch)));
+    mu_assert("error: hpack eviction: wrong headers count", decoded_count == ARR_SIZE(headers));
+    for (uint8_t i = 0; i < ARR_SIZE(headers); i++)
+    {
+      mu_assert("error: hpack eviction: wrong key", decoded[i].key_len == headers[i].key_len && memcmp(decoded[i].key, headers[i].key, headers[i].key_len) == 0);
+      mu_assert("error: hpack eviction: wrong value", decoded[i].value_len == headers[i].value_len && memcmp(decoded[i].value, headers[i].value, headers[i].value_len) == 0);
+    }
+    mu_assert("error: hpack eviction: tables out of sync", encoder.size == decoder.size && encoder.count == decoder.count);
+    mu_assert("error: hpack eviction: table too big", decoder.size <= decoder.max_size);
+  }
+
+  mu_assert("error: hpack eviction: size update not applied", decoder.max_size == 100);
+  mu_assert("error: hpack eviction: oversized update accepted", http_hpack_encode_table_size(&encoder, (char[8]){0}, 257) == 0);
+
+  return 0;
+}
+
+static char *test_http2_control_frames(void)
+{
+  char buffer[256];
+  char *cursor = buffer;
+
+  http2_settings_t settings = HTTP2_DEFAULT_SETTINGS;
+  settings.enable_push = 0;
+  settings.max_concurrent_streams = 100;
+  settings.initial_window_size = 1 << 20;
+  cursor += http2_serialize_settings(cursor, &settings);
+  cursor += http2_serialize_settings_ack(cursor);
+  cursor += http2_serialize_ping(cursor, "12345678", true);
+  cursor += http2_serialize_window_update(cursor, 3, 4096);
+  cursor += http2_serialize_rst_stream(cursor, 5, HTTP2_CANCEL);
+  cursor += http2_serialize_goaway(cursor, 7, HTTP2_ENHANCE_YOUR_CALM, "slow down", 9);
+
+  const char expected_settings[] = "\x00\x00\x12\x04\x00\x00\x00\x00\x00"
+    "\x00\x02\x00\x00\x00\x00" "\x00\x03\x00\x00\x00\x64" "\x00\x04\x00\x10\x00\x00";
+  mu_assert("error: http2 control frames: wrong settings", memcmp(buffer, expected_settings, STR_LEN(expected_settings)) == 0);
+
+  const uint32_t buffer_len = cursor - buffer;
+  http2_frame_t frame;
+  uint32_t offset = 0;
+
+  offset += http2_deserialize_frame(buffer + offset, buffer_len - offset, &frame, HTTP2_DEFAULT_MAX_FRAME_SIZE);
+  http2_settings_t peer_settings = HTTP2_DEFAULT_SETTINGS;
+  mu_assert("error: http2 control frames: wrong settings frame", frame.type == HTTP2_SETTINGS && frame.payload_len == 18 && frame.flags == 0);
+  mu_assert("error: http2 control frames: settings not applied", http2_deserialize_settings(&frame, &peer_settings) && memcmp(&peer_settings, &settings, sizeof(settings)) == 0);
+
+  offset += http2_deserialize_frame(buffer + offset, buffer_len - offset, &frame, HTTP2_DEFAULT_MAX_FRAME_SIZE);
+  mu_assert("error: http2 control frames: wrong settings ack", frame.type == HTTP2_SETTINGS && frame.flags == HTTP2_FLAG_ACK && frame.payload_len == 0);
+
+  offset += http2_deserialize_frame(buffer + offset, buffer_len - offset, &frame, HTTP2_DEFAULT_MAX_FRAME_SIZE);
+  mu_assert("error: http2 control frames: wrong ping", frame.type == HTTP2_PING && frame.flags == HTTP2_FLAG_ACK && memcmp(frame.payload, "12345678", 8) == 0);
+
+  offset += http2_deserialize_frame(buffer + offset, buffer_len - offset, &frame, HTTP2_DEFAULT_MAX_FRAME_SIZE);
+  mu_assert("error: http2 control frames: wrong window update", frame.type == HTTP2_WINDOW_UPDATE && frame.stream_id == 3 && frame.window_increment == 4096);
+
+  offset += http2_deserialize_frame(buffer + offset, buffer_len - offset, &frame, HTTP2_DEFAULT_MAX_FRAME_SIZE);
+  mu_assert("error: http2 control frames: wrong rst stream", frame.type == HTTP2_RST_STREAM && frame.stream_id == 5 && frame.error_code == HTTP2_CANCEL);
+
+  const uint32_t goaway_len = http2_deserialize_frame(buffer + offset, buffer_len - offset, &frame, HTTP2_DEFAULT_MAX_FRAME_SIZE);
+  mu_assert("error: http2 control frames: wrong goaway", frame.type == HTTP2_GOAWAY && frame.last_stream_id == 7 && frame.error_code == HTTP2_ENHANCE_YOUR_CALM);
+  mu_assert("error: http2 control frames: wrong goaway debug data", frame.payload_len == 9 && memcmp(frame.payload, "slow down", 9) == 0);
+  mu_assert("error: http2 control frames: truncated frame", http2_deserialize_frame(buffer + offset, goaway_len - 1, &frame, HTTP2_DEFAULT_MAX_FRAME_SIZE) == HTTP_NEED_MORE);
+  mu_assert("error: http2 control frames: truncated header", http2_deserialize_frame(buffer + offset, 8, &frame, HTTP2_DEFAULT_MAX_FRAME_SIZE) == HTTP_NEED_MORE);
+  offset += goaway_len;
+  mu_assert("error: http2 control frames: wrong total length", offset == buffer_len);
+
+  char invalid[][16] = {
+    "\x00\x00\x06\x04\x00\x00\x00\x00\x01" "\x00\x02\x00\x00\x00\x00",
+    "\x00\x00\x07\x06\x00\x00\x00\x00\x00" "1234567",
+    "\x00\x00\x04\x08\x00\x00\x00\x00\x01" "\x00\x00\x00\x00",
+    "\x00\x00\x04\x03\x00\x00\x00\x00\x00" "\x00\x00\x00\x08",
+    "\x00\x40\x01\x00\x00\x00\x00\x00\x01",
+    "\x00\x00\x03\x05\x04\x00\x00\x00\x01" "\x00\x00\x02"
+  };
+  for (uint8_t i = 0; i < ARR_SIZE(invalid); i++)
+    mu_assert("error: http2 control frames: invalid frame accepted", http2_deserialize_frame(invalid[i], sizeof(invalid[i]), &frame, HTTP2_DEFAULT_MAX_FRAME_SIZE) == 0);
+
+  //the promised stream id is taken out of the payload, after the padding length
+  char push_promise[] = "\x00\x00\x08\x05\x0C\x00\x00\x00\x01" "\x01" "\x80\x00\x00\x02" "\x82\x84" "\x00";
+  mu_assert("error: http2 control frames: wrong push promise length", http2_deserialize_frame(push_promise, STR_LEN(push_promise), &frame, HTTP2_DEFAULT_MAX_FRAME_SIZE) == STR_LEN(push_promise));
+  mu_assert("error: http2 control frames: wrong promised stream", frame.type == HTTP2_PUSH_PROMISE && frame.stream_id == 1 && frame.promised_stream_id == 2);
+  mu_assert("error: http2 control frames: wrong push promise block", frame.payload_len == 2 && memcmp(frame.payload, "\x82\x84", 2) == 0);
+
+  char bad_settings[] = "\x00\x00\x06\x04\x00\x00\x00\x00\x00" "\x00\x05\x00\x00\x10\x00";
+  http2_deserialize_frame(bad_settings, STR_LEN(bad_settings), &frame, HTTP2_DEFAULT_MAX_FRAME_SIZE);
+  mu_assert("error: http2 control frames: invalid max frame size accepted", !http2_deserialize_settings(&frame, &peer_settings));
+
+  return 0;
+}
+
+static char *test_http2_padding(void)
+{
+  char buffer[64];
+  const uint32_t len = http2_serialize_data(buffer, 1, "hello", 5, 4, HTTP2_FLAG_END_STREAM);
+  mu_assert("error: http2 padding: wrong data frame", len == 9 + 1 + 5 + 4 && memcmp(buffer, "\x00\x00\x0a\x00\x09\x00\x00\x00\x01\x04hello\0\0\0\0", len) == 0);
+
+  http2_frame_t frame;
+  mu_assert("error: http2 padding: data not parsed", http2_deserialize_frame(buffer, len, &frame, HTTP2_DEFAULT_MAX_FRAME_SIZE) == len);
+  mu_assert("error: http2 padding: padding not stripped", frame.type == HTTP2_DATA && frame.payload_len == 5 && memcmp(frame.payload, "hello", 5) == 0);
+  mu_assert("error: http2 padding: wrong flags", frame.flags == (HTTP2_FLAG_END_STREAM | HTTP2_FLAG_PADDED) && frame.stream_id == 1);
+
+  //pad length, stream dependency and weight, the fragment, then the padding
+  char headers[] = "\x00\x00\x0a\x01\x2c\x00\x00\x00\x03" "\x02" "\x80\x00\x00\x01\x10" "\x82\x84" "\0\0";
+  mu_assert("error: http2 padding: headers not parsed", http2_deserialize_frame(headers, STR_LEN(headers), &frame, HTTP2_DEFAULT_MAX_FRAME_SIZE) == STR_LEN(headers));
+  mu_assert("error: http2 padding: wrong headers fragment", frame.type == HTTP2_HEADERS && frame.payload_len == 2 && memcmp(frame.payload, "\x82\x84", 2) == 0);
+
+  buffer[9] = 10;
+  mu_assert("error: http2 padding: padding longer than the frame accepted", http2_deserialize_frame(buffer, len, &frame, HTTP2_DEFAULT_MAX_FRAME_SIZE) == 0);
+
+  return 0;
+}
+
+static char *test_http2_request_response(void)
+{
+  alignas(64) static char encoder_memory[HTTP_HPACK_TABLE_MEMORY(HTTP_HPACK_DEFAULT_TABLE_SIZE)];
+  alignas(64) static char decoder_memory[HTTP_HPACK_TABLE_MEMORY(HTTP_HPACK_DEFAULT_TABLE_SIZE)];
+  http_hpack_table_t encoder;
+  http_hpack_table_t decoder;
+  http_hpack_table_init(&encoder, encoder_memory, HTTP_HPACK_DEFAULT_TABLE_SIZE);
+  http_hpack_table_init(&decoder, decoder_memory, HTTP_HPACK_DEFAULT_TABLE_SIZE);
+
+  char value[100];
+  memset(value, 'v', sizeof(value));
+  http_header_t headers[] = {
+    { .key = "Connection", .value = "keep-alive", .key_len = 10, .value_len = 10, .id = HTTP_HEADER_CONNECTION },
+    { .key = "Host", .value = "example.com", .key_len = 4, .value_len = 11, .id = HTTP_HEADER_HOST },
+    { .key = "X-Long", .value = value, .key_len = 6, .value_len = sizeof(value) }
+  };
+  http_request_t request = {
+    .method = HTTP_POST,
+    .path = "/upload",
+    .path_len = 7,
+    .version = HTTP_1_1,
+    .headers = headers,
+    .headers_count = ARR_SIZE(headers),
+    .body = "payload",
+    .body_len = 7
+  };
+
+  //a tiny frame size splits the header block into CONTINUATION frames
+  static char buffer[1024];
+  const uint32_t len = http2_serialize_request(buffer, &encoder, 1, &request, 32);
+
+  char block[256];
+  uint32_t block_len = 0;
+  http2_frame_t frame;
+  uint32_t offset = 0;
+  uint8_t frames = 0;
+  do
+  {
+    offset += http2_deserialize_frame(buffer + offset, len - offset, &frame, 32);
+    mu_assert("error: http2 request response: wrong header frame", frame.type == (frames ? HTTP2_CONTINUATION : HTTP2_HEADERS) && frame.stream_id == 1);
+    memcpy(block + block_len, frame.payload, frame.payload_len);
+    block_len += frame.payload_len;
+    frames++;
+  } while (!(frame.flags & HTTP2_FLAG_END_HEADERS));
+  mu_assert("error: http2 request response: header block not split", frames > 1);
+
+  offset += http2_deserialize_frame(buffer + offset, len - offset, &frame, 32);
+  mu_assert("error: http2 request response: wrong data frame", frame.type == HTTP2_DATA && frame.flags == HTTP2_FLAG_END_STREAM && frame.payload_len == 7 && memcmp(frame.payload, "payload", 7) == 0);
+  mu_assert("error: http2 request response: wrong length", offset == len);
+
+  http_header_t parsed_headers[8];
+  http_request_t parsed = { .headers = parsed_headers, .headers_count = ARR_SIZE(parsed_headers) };
+  char scratch[512];
+  mu_assert("error: http2 request response: request not parsed", http2_deserialize_request(&decoder, block, block_len, &parsed, scratch, sizeof(scratch)));
+  mu_assert("error: http2 request response: wrong start line", parsed.method == HTTP_POST && parsed.version == HTTP_2_0 && parsed.path_len == 7 && memcmp(parsed.path, "/upload", 7) == 0);
+  mu_assert("error: http2 request response: wrong headers count", parsed.headers_count == 2);
+  mu_assert("error: http2 request response: wrong host", parsed_headers[0].id == HTTP_HEADER_HOST && parsed_headers[0].value_len == 11 && memcmp(parsed_headers[0].value, "example.com", 11) == 0);
+  mu_assert("error: http2 request response: wrong header", parsed_headers[1].key_len == 6 && memcmp(parsed_headers[1].key, "x-long", 6) == 0 && parsed_headers[1].value_len == sizeof(value));
+
+  http_header_t response_headers[] = {
+    { .key = "Content-Type", .value = "text/plain", .key_len = 12, .value_len = 10, .id = HTTP_HEADER_CONTENT_TYPE },
+    { .key = "Content-Length", .value = "40000", .key_len = 14, .value_len = 5, .id = HTTP_HEADER_CONTENT_LENGTH }
+  };
+  static char body[40000];
+  memset(body, 'b', sizeof(body));
+  http_response_t response = {
+    .version = HTTP_1_1,
+    .status_code = 404,
+    .headers = response_headers,
+    .headers_count = ARR_SIZE(response_headers),
+    .body = body,
+    .body_len = sizeof(body)
+  };
+
+  //both encoders start from the same empty table, so they produce the same blocks
+  alignas(64) static char writer_memory[HTTP_HPACK_TABLE_MEMORY(HTTP_HPACK_DEFAULT_TABLE_SIZE)];
+  http_hpack_table_t writer;
+  http_hpack_table_init(&encoder, encoder_memory, HTTP_HPACK_DEFAULT_TABLE_SIZE);
+  http_hpack_table_init(&writer, writer_memory, HTTP_HPACK_DEFAULT_TABLE_SIZE);
+  static char expected[sizeof(body) + 1024];
+  const uint32_t expected_len = http2_serialize_response(expected, &encoder, 3, &response, HTTP2_DEFAULT_MAX_FRAME_SIZE);
+
+  int fds[2];
+  if (pipe(fds) == -1)
+    return strerror(errno);
+  uint32_t body_sent;
+  const int64_t written = http2_serialize_response_write(fds[1], &writer, 3, &response, HTTP2_DEFAULT_MAX_FRAME_SIZE, HTTP2_MAX_WINDOW_SIZE, &body_sent);
+  close(fds[1]);
+  const bool match = compare_file(fds[0], expected, expected_len);
+  close(fds[0]);
+  mu_assert("error: http2 request response: wrong written length", written == (int64_t)expected_len);
+  mu_assert("error: http2 request response: wrong written output", match);
+  mu_assert("error: http2 request response: wrong body sent", body_sent == sizeof(body));
+
+  //a window smaller than the body stops the DATA frames early and leaves the stream open
+  static char windowed[sizeof(body) + 1024];
+  if (pipe(fds) == -1)
+    return strerror(errno);
+  const int64_t windowed_written = http2_serialize_response_write(fds[1], &writer, 5, &response, HTTP2_DEFAULT_MAX_FRAME_SIZE, 20000, &body_sent);
+  close(fds[1]);
+  const ssize_t windowed_len = read(fds[0], windowed, sizeof(windowed));
+  close(fds[0]);
+  mu_assert("error: http2 request response: wrong windowed length", windowed_written == windowed_len && body_sent == 20000);
+  uint32_t windowed_offset = http2_deserialize_frame(windowed, windowed_len, &frame, HTTP2_DEFAULT_MAX_FRAME_SIZE);
+  mu_assert("error: http2 request response: wrong windowed headers", frame.type == HTTP2_HEADERS && !(frame.flags & HTTP2_FLAG_END_STREAM));
+  uint32_t windowed_body = 0;
+  while (windowed_offset < (uint32_t)windowed_len)
+  {
+    windowed_offset += http2_deserialize_frame(windowed + windowed_offset, windowed_len - windowed_offset, &frame, HTTP2_DEFAULT_MAX_FRAME_SIZE);
+    mu_assert("error: http2 request response: windowed stream ended", frame.type == HTTP2_DATA && frame.flags == 0);
+    windowed_body += frame.payload_len;
+  }
+  mu_assert("error: http2 request response: wrong windowed body", windowed_body == 20000);
+
+  //a pipe that fills up mid frame reports only the body bytes that got into it
+  if (pipe2(fds, O_NONBLOCK) == -1)
+    return strerror(errno);
+  fcntl(fds[1], F_SETPIPE_SZ, 4096);
+  const int64_t partial_written = http2_serialize_response_write(fds[1], &writer, 7, &response, HTTP2_DEFAULT_MAX_FRAME_SIZE, HTTP2_MAX_WINDOW_SIZE, &body_sent);
+  close(fds[1]);
+  const ssize_t partial_len = read(fds[0], windowed, sizeof(windowed));
+  close(fds[0]);
+  const uint32_t partial_head = http2_deserialize_frame(windowed, partial_len, &frame, HTTP2_DEFAULT_MAX_FRAME_SIZE);
+  mu_assert("error: http2 request response: wrong partial length", partial_written == partial_len && partial_len < (ssize_t)sizeof(body));
+  mu_assert("error: http2 request response: wrong partial body sent", body_sent == partial_len - partial_head - HTTP2_FRAME_HEADER_SIZE);
+
+  http_hpack_table_init(&decoder, decoder_memory, HTTP_HPACK_DEFAULT_TABLE_SIZE);
+  offset = http2_deserialize_frame(expected, expected_len, &frame, HTTP2_DEFAULT_MAX_FRAME_SIZE);
+  mu_assert("error: http2 request response: wrong response headers frame", frame.type == HTTP2_HEADERS && frame.flags == HTTP2_FLAG_END_HEADERS && frame.stream_id == 3);
+
+  http_response_t parsed_response = { .headers = parsed_headers, .headers_count = ARR_SIZE(parsed_headers) };
+  mu_assert("error: http2 request response: response not parsed", http2_deserialize_response(&decoder, frame.payload, frame.payload_len, &parsed_response, scratch, sizeof(scratch)));
+  mu_assert("error: http2 request response: wrong status", parsed_response.status_code == 404 && parsed_response.headers_count == 2);
+  mu_assert("error: http2 request response: wrong framing", parsed_response.framing == HTTP_FRAMING_CONTENT_LENGTH && parsed_response.body_len == sizeof(body));
+
+  uint32_t body_len = 0;
+  for (uint8_t i = 0; i < 3; i++)
+  {
+    offset += http2_deserialize_frame(expected + offset, expected_len - offset, &frame, HTTP2_DEFAULT_MAX_FRAME_SIZE);
+    mu_assert("error: http2 request response: wrong body frame", frame.type == HTTP2_DATA && (frame.flags == HTTP2_FLAG_END_STREAM) == (i == 2));
+    body_len += frame.payload_len;
+  }
+  mu_assert("error: http2 request response: wrong body length", body_len == sizeof(body) && offset == expected_len);
+
+  return 0;
+}
+
+static char *test_qpack_rfc_examples(void)
+{
+  alignas(64) static char memory[HTTP_QPACK_TABLE_MEMORY(220)];
+  http_qpack_decoder_t decoder;
+  http_qpack_decoder_init(&decoder, memory, 220);
+
+  http_header_t headers[4];
+  uint16_t headers_count = ARR_SIZE(headers);
+  char scratch[256];
+  char out[8];
+
+  //RFC 9204 Appendix B.1, static table only
+  char literal[] = "\x00\x00\x51\x0b" "/index.html";
+  mu_assert("error: qpack rfc examples: B.1 not decoded", http_qpack_decode(&decoder, literal, STR_LEN(literal), headers, &headers_count, scratch, sizeof(scratch)) == STR_LEN(literal));
+  mu_assert("error: qpack rfc examples: wrong B.1 header", headers_count == 1 && headers[0].key_len == 5 && memcmp(headers[0].key, ":path", 5) == 0 && headers[0].value_len == 11 && memcmp(headers[0].value, "/index.html", 11) == 0);
+  mu_assert("error: qpack rfc examples: B.1 acknowledged", http_qpack_encode_section_ack(&decoder, out, 0) == 0);
+
+  //B.2, the section is blocked until the encoder stream delivers its entries
+  char dynamic[] = "\x03\x81\x10\x11";
+  headers_count = ARR_SIZE(headers);
+  mu_assert("error: qpack rfc examples: B.2 not blocked", http_qpack_decode(&decoder, dynamic, STR_LEN(dynamic), headers, &headers_count, scratch, sizeof(scratch)) == HTTP_NEED_MORE);
+
+  char inserts[] = "\x3f\xbd\x01" "\xc0\x0f" "www.example.com" "\xc1\x0c" "/sample/path";
+  mu_assert("error: qpack rfc examples: partial instruction applied", http_qpack_decoder_receive(&decoder, inserts, 10, scratch, sizeof(scratch)) == 3);
+  mu_assert("error: qpack rfc examples: B.2 inserts not received", http_qpack_decoder_receive(&decoder, inserts + 3, STR_LEN(inserts) - 3, scratch, sizeof(scratch)) == STR_LEN(inserts) - 3);
+  mu_assert("error: qpack rfc examples: wrong capacity", decoder.table.max_size == 220 && decoder.insert_count == 2);
+
+  headers_count = ARR_SIZE(headers);
+  mu_assert("error: qpack rfc examples: B.2 not decoded", http_qpack_decode(&decoder, dynamic, STR_LEN(dynamic), headers, &headers_count, scratch, sizeof(scratch)) == STR_LEN(dynamic));
+  mu_assert("error: qpack rfc examples: wrong B.2 authority", headers_count == 2 && headers[0].key_len == 10 && memcmp(headers[0].key, ":authority", 10) == 0 && headers[0].value_len == 15 && memcmp(headers[0].value, "www.example.com", 15) == 0);
+  mu_assert("error: qpack rfc examples: wrong B.2 path", headers[1].key_len == 5 && memcmp(headers[1].key, ":path", 5) == 0 && headers[1].value_len == 12 && memcmp(headers[1].value, "/sample/path", 12) == 0);
+  mu_assert("error: qpack rfc examples: wrong B.2 acknowledgment", http_qpack_encode_section_ack(&decoder, out, 4) == 1 && out[0] == '\x84');
+  mu_assert("error: qpack rfc examples: B.2 inserts acknowledged twice", http_qpack_encode_insert_count(&decoder, out) == 0);
+
+  //B.3 and B.4, a literal name and a duplicate, referenced from a section with post-base free indices
+  char custom[] = "\x4a" "custom-key" "\x0c" "custom-value";
+  mu_assert("error: qpack rfc examples: B.3 insert not received", http_qpack_decoder_receive(&decoder, custom, STR_LEN(custom), scratch, sizeof(scratch)) == STR_LEN(custom));
+  mu_assert("error: qpack rfc examples: wrong B.3 increment", http_qpack_encode_insert_count(&decoder, out) == 1 && out[0] == '\x01');
+
+  char duplicate[] = "\x02";
+  mu_assert("error: qpack rfc examples: B.4 duplicate not received", http_qpack_decoder_receive(&decoder, duplicate, 1, scratch, sizeof(scratch)) == 1);
+  char mixed[] = "\x05\x00\x80\xc1\x81";
+  headers_count = ARR_SIZE(headers);
+  mu_assert("error: qpack rfc examples: B.4 not decoded", http_qpack_decode(&decoder, mixed, STR_LEN(mixed), headers, &headers_count, scratch, sizeof(scratch)) == STR_LEN(mixed));
+  mu_assert("error: qpack rfc examples: wrong B.4 headers", headers_count == 3 && headers[0].value_len == 15 && memcmp(headers[0].value, "www.example.com", 15) == 0 && headers[1].value_len == 1 && headers[1].value[0] == '/');
+  mu_assert("error: qpack rfc examples: wrong B.4 custom header", headers[2].key_len == 10 && memcmp(headers[2].key, "custom-key", 10) == 0 && headers[2].value_len == 12 && memcmp(headers[2].value, "custom-value", 12) == 0);
+  mu_assert("error: qpack rfc examples: wrong stream cancellation", http_qpack_encode_stream_cancel(out, 8) == 1 && out[0] == '\x48');
+
+  //B.5, a name reference to the dynamic table that evicts the oldest entry
+  char evicting[] = "\x81\x0d" "custom-value2";
+  mu_assert("error: qpack rfc examples: B.5 insert not received", http_qpack_decoder_receive(&decoder, evicting, STR_LEN(evicting), scratch, sizeof(scratch)) == STR_LEN(evicting));
+  mu_assert("error: qpack rfc examples: oldest entry not evicted", decoder.insert_count == 5 && decoder.table.count == 4 && decoder.table.size == 215);
+
+  char newest[] = "\x06\x00\x80";
+  headers_count = ARR_SIZE(headers);
+  mu_assert("error: qpack rfc examples: newest entry not decoded", http_qpack_decode(&decoder, newest, STR_LEN(newest), headers, &headers_count, scratch, sizeof(scratch)) == STR_LEN(newest));
+  mu_assert("error: qpack rfc examples: wrong newest entry", headers_count == 1 && headers[0].value_len == 13 && memcmp(headers[0].value, "custom-value2", 13) == 0);
+
+  char evicted[] = "\x06\x00\x84";
+  char wrapped[] = "\x0e\x00";
+  char loose[] = "\x06\x00\xc1";
+  headers_count = ARR_SIZE(headers);
+  mu_assert("error: qpack rfc examples: evicted entry referenced", http_qpack_decode(&decoder, evicted, STR_LEN(evicted), headers, &headers_count, scratch, sizeof(scratch)) == 0);
+  mu_assert("error: qpack rfc examples: insert count beyond the full range", http_qpack_decode(&decoder, wrapped, STR_LEN(wrapped), headers, &headers_count, scratch, sizeof(scratch)) == 0);
+  mu_assert("error: qpack rfc examples: required insert count bigger than needed", http_qpack_decode(&decoder, loose, STR_LEN(loose), headers, &headers_count, scratch, sizeof(scratch)) == 0);
+
+  char too_big[] = "\x3f\xbe\x01";
+  mu_assert("error: qpack rfc examples: capacity above the maximum", http_qpack_decoder_receive(&decoder, too_big, STR_LEN(too_big), scratch, sizeof(scratch)) == 0);
+
+  return 0;
+}
+
+static char *test_qpack_dynamic_table(void)
+{
+  alignas(64) static char encoder_memory[HTTP_QPACK_TABLE_MEMORY(4096)];
+  alignas(64) static char decoder_memory[HTTP_QPACK_TABLE_MEMORY(4096)];
+  http_qpack_encoder_t encoder;
+  http_qpack_decoder_t decoder;
+  http_qpack_encoder_init(&encoder, encoder_memory, 4096, 4096);
+  http_qpack_decoder_init(&decoder, decoder_memory, 4096);
+
+  const http_header_t headers[] = {
+    { .key = "User-Agent", .value = "flashhttp/1.0", .key_len = 10, .value_len = 13, .id = HTTP_HEADER_USER_AGENT },
+    { .key = "X-Request-Id", .value = "abc", .key_len = 12, .value_len = 3 },
+    { .key = "Content-Type", .value = "application/json", .key_len = 12, .value_len = 16, .id = HTTP_HEADER_CONTENT_TYPE }
+  };
+  http_header_t parsed[4];
+  uint16_t parsed_count = ARR_SIZE(parsed);
+  char block[256];
+  char instructions[256];
+  uint32_t instructions_len;
+  char scratch[256];
+  char out[8];
+
+  //entries are inserted right away but only referenced once the decoder acknowledges them
+  uint32_t block_len = http_qpack_encode(&encoder, 0, block, headers, ARR_SIZE(headers), instructions, &instructions_len);
+  mu_assert("error: qpack dynamic table: unacknowledged entries referenced", block[0] == 0 && block[1] == 0 && encoder.insert_count == 2 && encoder.pending_count == 0);
+  mu_assert("error: qpack dynamic table: inserts not received", http_qpack_decoder_receive(&decoder, instructions, instructions_len, scratch, sizeof(scratch)) == instructions_len);
+  mu_assert("error: qpack dynamic table: first section not decoded", http_qpack_decode(&decoder, block, block_len, parsed, &parsed_count, scratch, sizeof(scratch)) == block_len);
+  mu_assert("error: qpack dynamic table: wrong first section", parsed_count == 3 && parsed[0].id == HTTP_HEADER_USER_AGENT && parsed[1].key_len == 12 && memcmp(parsed[1].key, "x-request-id", 12) == 0 && parsed[2].id == HTTP_HEADER_CONTENT_TYPE);
+  mu_assert("error: qpack dynamic table: static section acknowledged", http_qpack_encode_section_ack(&decoder, out, 0) == 0);
+  mu_assert("error: qpack dynamic table: wrong increment", http_qpack_encode_insert_count(&decoder, out) == 1 && out[0] == '\x02');
+  mu_assert("error: qpack dynamic table: increment not received", http_qpack_encoder_receive(&encoder, out, 1) == 1 && encoder.known_received_count == 2);
+
+  block_len = http_qpack_encode(&encoder, 4, block, headers, ARR_SIZE(headers), instructions, &instructions_len);
+  mu_assert("error: qpack dynamic table: wrong indexed section", block_len == 5 && memcmp(block, "\x03\x00\x81\x80\xee", 5) == 0 && instructions_len == 0 && encoder.pending_count == 1);
+  parsed_count = ARR_SIZE(parsed);
+  mu_assert("error: qpack dynamic table: indexed section not decoded", http_qpack_decode(&decoder, block, block_len, parsed, &parsed_count, scratch, sizeof(scratch)) == block_len);
+  mu_assert("error: qpack dynamic table: wrong indexed section headers", parsed_count == 3 && parsed[0].id == HTTP_HEADER_USER_AGENT && parsed[0].value_len == 13 && memcmp(parsed[0].value, "flashhttp/1.0", 13) == 0 && parsed[1].value_len == 3 && memcmp(parsed[1].value, "abc", 3) == 0);
+  mu_assert("error: qpack dynamic table: wrong acknowledgment", http_qpack_encode_section_ack(&decoder, out, 4) == 1 && out[0] == '\x84');
+  mu_assert("error: qpack dynamic table: acknowledgment not received", http_qpack_encoder_receive(&encoder, out, 1) == 1 && encoder.pending_count == 0);
+  mu_assert("error: qpack dynamic table: unknown section acknowledged", http_qpack_encoder_receive(&encoder, out, 1) == 0);
+
+  //a table with room for a single entry cannot evict it while a section references it
+  http_qpack_encoder_init(&encoder, encoder_memory, 60, 60);
+  http_qpack_decoder_init(&decoder, decoder_memory, 60);
+  const http_header_t first = { .key = "x-request-id", .value = "abc", .key_len = 12, .value_len = 3 };
+  const http_header_t second = { .key = "x-request-id", .value = "def", .key_len = 12, .value_len = 3 };
+
+  block_len = http_qpack_encode(&encoder, 0, block, &first, 1, instructions, &instructions_len);
+  mu_assert("error: qpack dynamic table: small insert not received", http_qpack_decoder_receive(&decoder, instructions, instructions_len, scratch, sizeof(scratch)) == instructions_len);
+  http_qpack_encode_insert_count(&decoder, out);
+  http_qpack_encoder_receive(&encoder, out, 1);
+
+  block_len = http_qpack_encode(&encoder, 4, block, &first, 1, instructions, &instructions_len);
+  mu_assert("error: qpack dynamic table: entry not referenced", block_len == 3 && encoder.pending_count == 1);
+  block_len = http_qpack_encode(&encoder, 8, block, &second, 1, instructions, &instructions_len);
+  mu_assert("error: qpack dynamic table: referenced entry evicted", instructions_len == 0 && encoder.insert_count == 1);
+
+  mu_assert("error: qpack dynamic table: acknowledgments not received", http_qpack_encoder_receive(&encoder, "\x84\x88", 2) == 2 && encoder.pending_count == 0);
+  block_len = http_qpack_encode(&encoder, 12, block, &second, 1, instructions, &instructions_len);
+  mu_assert("error: qpack dynamic table: released entry not evicted", instructions_len != 0 && encoder.insert_count == 2 && encoder.table.count == 1);
+  mu_assert("error: qpack dynamic table: evicting insert not received", http_qpack_decoder_receive(&decoder, instructions, instructions_len, scratch, sizeof(scratch)) == instructions_len && decoder.table.count == 1);
+
+  //without a dynamic table nothing is sent on the encoder stream
+  http_qpack_encoder_init(&encoder, encoder_memory, 0, 0);
+  block_len = http_qpack_encode(&encoder, 0, block, headers, ARR_SIZE(headers), instructions, &instructions_len);
+  mu_assert("error: qpack dynamic table: static only encoder used the dynamic table", instructions_len == 0 && block[0] == 0 && block[1] == 0 && encoder.insert_count == 0);
+
+  //nor when the peer does not allow one, whatever capacity is asked for
+  http_qpack_encoder_init(&encoder, encoder_memory, 4096, 0);
+  block_len = http_qpack_encode(&encoder, 0, block, headers, ARR_SIZE(headers), instructions, &instructions_len);
+  mu_assert("error: qpack dynamic table: capacity not clamped to the peer", instructions_len == 0 && block[0] == 0 && block[1] == 0 && encoder.table.max_size == 0);
+
+  return 0;
+}
+
+static char *test_http3_request_response(void)
+{
+  char buffer[64];
+  uint64_t value;
+
+  //RFC 9000 Appendix A.1
+  mu_assert("error: http3 request response: wrong 8 byte varint", http3_deserialize_varint("\xc2\x19\x7c\x5e\xff\x14\xe8\x8c", 8, &value) == 8 && value == 151288809941952652ULL);
+  mu_assert("error: http3 request response: wrong 4 byte varint", http3_deserialize_varint("\x9d\x7f\x3e\x7d", 4, &value) == 4 && value == 494878333);
+  mu_assert("error: http3 request response: wrong 2 byte varint", http3_deserialize_varint("\x7b\xbd", 2, &value) == 2 && value == 15293);
+  mu_assert("error: http3 request response: wrong non minimal varint", http3_deserialize_varint("\x40\x25", 2, &value) == 2 && value == 37);
+  mu_assert("error: http3 request response: truncated varint", http3_deserialize_varint("\x7b", 1, &value) == 0);
+  mu_assert("error: http3 request response: wrong serialized varint", http3_serialize_varint(buffer, 151288809941952652ULL) == 8 && memcmp(buffer, "\xc2\x19\x7c\x5e\xff\x14\xe8\x8c", 8) == 0);
+  mu_assert("error: http3 request response: wrong short serialized varint", http3_serialize_varint(buffer, 15293) == 2 && memcmp(buffer, "\x7b\xbd", 2) == 0 && http3_serialize_varint(buffer, 37) == 1);
+
+  http3_settings_t settings = HTTP3_DEFAULT_SETTINGS;
+  settings.qpack_max_table_capacity = 4096;
+  settings.qpack_blocked_streams = 16;
+  uint32_t len = http3_serialize_settings(buffer, &settings);
+  mu_assert("error: http3 request response: wrong settings", len == 7 && memcmp(buffer, "\x04\x05\x01\x50\x00\x07\x10", 7) == 0);
+
+  http3_frame_t frame;
+  http3_settings_t parsed_settings = HTTP3_DEFAULT_SETTINGS;
+  mu_assert("error: http3 request response: settings not parsed", http3_deserialize_frame(buffer, len, &frame, 64) == len && frame.type == HTTP3_SETTINGS && http3_deserialize_settings(&frame, &parsed_settings));
+  mu_assert("error: http3 request response: wrong parsed settings", memcmp(&parsed_settings, &settings, sizeof(settings)) == 0);
+
+  char duplicate[] = "\x04\x04\x01\x00\x01\x00";
+  char reserved_setting[] = "\x04\x02\x02\x00";
+  char zero_setting[] = "\x04\x02\x00\x00";
+  mu_assert("error: http3 request response: duplicate setting accepted", http3_deserialize_frame(duplicate, 6, &frame, 64) == 6 && !http3_deserialize_settings(&frame, &parsed_settings));
+  mu_assert("error: http3 request response: HTTP/2 setting accepted", http3_deserialize_frame(reserved_setting, 4, &frame, 64) == 4 && !http3_deserialize_settings(&frame, &parsed_settings));
+  mu_assert("error: http3 request response: setting 0 accepted", http3_deserialize_frame(zero_setting, 4, &frame, 64) == 4 && !http3_deserialize_settings(&frame, &parsed_settings));
+
+  len = http3_serialize_goaway(buffer, 4);
+  mu_assert("error: http3 request response: wrong goaway", len == 3 && http3_deserialize_frame(buffer, len, &frame, 64) == 3 && frame.type == HTTP3_GOAWAY && frame.id == 4);
+
+  char reserved_frame[] = "\x06\x00";
+  char unknown_frame[] = "\x21\x00";
+  char truncated[] = "\x01\x05\x00";
+  mu_assert("error: http3 request response: HTTP/2 frame accepted", http3_deserialize_frame(reserved_frame, 2, &frame, 64) == 0);
+  mu_assert("error: http3 request response: unknown frame not skipped", http3_deserialize_frame(unknown_frame, 2, &frame, 64) == 2 && frame.type == 0x21);
+  mu_assert("error: http3 request response: truncated frame", http3_deserialize_frame(truncated, 3, &frame, 64) == HTTP_NEED_MORE);
+  mu_assert("error: http3 request response: oversized frame", http3_deserialize_frame(truncated, 3, &frame, 4) == 0);
+
+  alignas(64) static char encoder_memory[HTTP_QPACK_TABLE_MEMORY(4096)];
+  alignas(64) static char decoder_memory[HTTP_QPACK_TABLE_MEMORY(4096)];
+  http_qpack_encoder_t encoder;
+  http_qpack_decoder_t decoder;
+  http_qpack_encoder_init(&encoder, encoder_memory, 4096, 4096);
+  http_qpack_decoder_init(&decoder, decoder_memory, 4096);
+
+  http_header_t headers[] = {
+    { .key = "Connection", .value = "keep-alive", .key_len = 10, .value_len = 10, .id = HTTP_HEADER_CONNECTION },
+    { .key = "Host", .value = "example.com", .key_len = 4, .value_len = 11, .id = HTTP_HEADER_HOST },
+    { .key = "X-Trace", .value = "on", .key_len = 7, .value_len = 2 }
+  };
+  http_request_t request = {
+    .method = HTTP_POST,
+    .path = "/upload",
+    .path_len = 7,
+    .version = HTTP_1_1,
+    .headers = headers,
+    .headers_count = ARR_SIZE(headers),
+    .body = "payload",
+    .body_len = 7
+  };
+
+  char message[512];
+  char instructions[256];
+  uint32_t instructions_len;
+  len = http3_serialize_request(message, &encoder, 0, &request, instructions, &instructions_len);
+  char scratch[512];
+  mu_assert("error: http3 request response: inserts not received", http_qpack_decoder_receive(&decoder, instructions, instructions_len, scratch, sizeof(scratch)) == instructions_len);
+
+  uint32_t offset = http3_deserialize_frame(message, len, &frame, sizeof(message));
+  mu_assert("error: http3 request response: wrong headers frame", offset != 0 && offset != HTTP_NEED_MORE && frame.type == HTTP3_HEADERS);
+  http_header_t parsed_headers[8];
+  http_request_t parsed = { .headers = parsed_headers, .headers_count = ARR_SIZE(parsed_headers) };
+  mu_assert("error: http3 request response: request not parsed", http3_deserialize_request(&decoder, frame.payload, frame.payload_len, &parsed, scratch, sizeof(scratch)) == frame.payload_len);
+  mu_assert("error: http3 request response: wrong start line", parsed.method == HTTP_POST && parsed.version == HTTP_3_0 && parsed.path_len == 7 && memcmp(parsed.path, "/upload", 7) == 0);
+  mu_assert("error: http3 request response: wrong headers", parsed.headers_count == 2 && parsed_headers[0].id == HTTP_HEADER_HOST && parsed_headers[0].value_len == 11 && parsed_headers[1].key_len == 7 && memcmp(parsed_headers[1].key, "x-trace", 7) == 0);
+
+  offset += http3_deserialize_frame(message + offset, len - offset, &frame, sizeof(message));
+  mu_assert("error: http3 request response: wrong data frame", frame.type == HTTP3_DATA && frame.payload_len == 7 && memcmp(frame.payload, "payload", 7) == 0 && offset == len);
+
+  http_header_t response_headers[] = {
+    { .key = "Content-Type", .value = "text/plain", .key_len = 12, .value_len = 10, .id = HTTP_HEADER_CONTENT_TYPE },
+    { .key = "Content-Length", .value = "4", .key_len = 14, .value_len = 1, .id = HTTP_HEADER_CONTENT_LENGTH }
+  };
+  http_response_t response = {
+    .version = HTTP_1_1,
+    .status_code = 404,
+    .headers = response_headers,
+    .headers_count = ARR_SIZE(response_headers),
+    .body = "gone",
+    .body_len = 4
+  };
+  len = http3_serialize_response(message, &encoder, 0, &response, instructions, &instructions_len);
+  mu_assert("error: http3 request response: response inserts not received", http_qpack_decoder_receive(&decoder, instructions, instructions_len, scratch, sizeof(scratch)) == instructions_len || instructions_len == 0);
+
+  offset = http3_deserialize_frame(message, len, &frame, sizeof(message));
+  http_response_t parsed_response = { .headers = parsed_headers, .headers_count = ARR_SIZE(parsed_headers) };
+  mu_assert("error: http3 request response: response not parsed", frame.type == HTTP3_HEADERS && http3_deserialize_response(&decoder, frame.payload, frame.payload_len, &parsed_response, scratch, sizeof(scratch)) == frame.payload_len);
+  mu_assert("error: http3 request response: wrong status", parsed_response.status_code == 404 && parsed_response.version == HTTP_3_0 && parsed_response.headers_count == 2);
+  mu_assert("error: http3 request response: wrong framing", parsed_response.framing == HTTP_FRAMING_CONTENT_LENGTH && parsed_response.body_len == 4);
+
+  offset += http3_deserialize_frame(message + offset, len - offset, &frame, sizeof(message));
+  mu_assert("error: http3 request response: wrong response body", frame.type == HTTP3_DATA && frame.payload_len == 4 && memcmp(frame.payload, "gone", 4) == 0 && offset == len);
+
+  return 0;
+}
+
+static char *test_serialize_response_status_code_range(void)
+{
+  http_response_t response = {
+    .version = HTTP_1_1,
+    .status_code = 799
+  };
+  const char expected_buffer[] =
+    "HTTP/1.1 799 \r\n"
+    "\r\n";
+  const uint16_t expected_len = STR_LEN(expected_buffer);
+
+  char buffer[64] = {0};
+  uint32_t len = http1_serialize_response(buffer, &response);
+
+  mu_assert("error: serialize response status code range: wrong length", len == expected_len);
+  mu_assert("error: serialize response status code range: wrong buffer", memcmp(buffer, expected_buffer, len) == 0);
+
+  response.status_code = 1000;
+  mu_assert("error: serialize response status code range: accepted 1000", http1_serialize_response(buffer, &response) == 0);
+  response.status_code = 99;
+  mu_assert("error: serialize response status code range: accepted 99", http1_serialize_response(buffer, &response) == 0);
+
+  response.status_code = 65535;
+  errno = 0;
+  mu_assert("error: serialize response status code range: write accepted 65535", http1_serialize_response_write(-1, &response) == -1);
+  mu_assert("error: serialize response status code range: wrong errno", errno == EINVAL);
+
+  response.status_code = 200;
+  response.version = HTTP_2_0;
+  mu_assert("error: serialize response status code range: accepted HTTP/2", http1_serialize_response(buffer, &response) == 0);
+  errno = 0;
+  mu_assert("error: serialize response status code range: write accepted HTTP/3", http1_serialize_response_write_file(-1, &(http_response_t){ .version = HTTP_3_0, .status_code = 200 }, -1, 0, 0) == -1 && errno == EINVAL);
+
+  return 0;
+}
+
+static char *test_decode_chunked_invalid_extensions_trailers(void)
+{
+  const char *messages[] = {
+    "3;a\nb\r\nabc\r\n0\r\n\r\n",
+    "3;a\x01\r\nabc\r\n0\r\n\r\n",
+    "0\r\nBad Name: value\r\n\r\n",
+    "0\r\nName : value\r\n\r\n",
+    "0\r\n: value\r\n\r\n",
+    "0\r\nName: a\nb\r\n\r\n",
+    "0\r\nName: value\n\r\n",
+    "0\r\nName\r\n\r\n"
+  };
+
+  for (uint8_t i = 0; i < ARR_SIZE(messages); i++)
+  {
+    char buffer[64];
+    strcpy(buffer, messages[i]);
+
+    http_chunked_decoder_t decoder = {0};
+    uint32_t body_len = 0;
+    const uint32_t len = http1_decode_chunked(&decoder, buffer, strlen(buffer), &body_len);
+
+    mu_assert("error: decode chunked invalid extensions trailers: should fail", len == 0);
+  }
+
+  return 0;
+}
+
+static char *test_deserialize_header_ids_all(void)
+{
+  http_header_t headers[HTTP_HEADER_X_FORWARDED_FOR] = {0};
+  uint16_t headers_count = 0;
+
+  for (uint8_t id = HTTP_HEADER_UNKNOWN + 1; id <= HTTP_HEADER_X_FORWARDED_FOR; id++)
+  {
+    if ((id == HTTP_HEADER_CONTENT_LENGTH) | (id == HTTP_HEADER_TRANSFER_ENCODING))
+      continue;
+    headers[headers_count++] = (http_header_t){ .id = id, .value = "1", .value_len = 1 };
+  }
+
+  const http_response_t response = {
+    .version = HTTP_1_1,
+    .status_code = 200,
+    .headers = headers,
+    .headers_count = headers_count
+  };
+
+  char buffer[4096];
+  const uint32_t len = http1_serialize_response(buffer, &response);
+
+  http_header_t parsed_headers[HTTP_HEADER_X_FORWARDED_FOR] = {0};
+  http_response_t parsed = { .headers = parsed_headers, .headers_count = ARR_SIZE(parsed_headers) };
+
+  mu_assert("error: deserialize header ids all: wrong length", http1_deserialize(buffer, len, &parsed) == len);
+  mu_assert("error: deserialize header ids all: wrong headers count", parsed.headers_count == headers_count);
+  for (uint16_t i = 0; i < headers_count; i++)
+    mu_assert("error: deserialize header ids all: wrong id", parsed_headers[i].id == headers[i].id);
+
+  return 0;
+}
+
+static char *test_serialize_batch_write_partial(void)
+{
+  static char body[1 << 20];
+  const http_request_t requests[] = {
+    { .method = HTTP_POST, .path = "/a", .path_len = 2, .version = HTTP_1_1, .body = body, .body_len = sizeof(body), .emit_content_length = true },
+    { .method = HTTP_POST, .path = "/b", .path_len = 2, .version = HTTP_1_1, .body = body, .body_len = sizeof(body), .emit_content_length = true }
+  };
+
+  int fds[2];
+  if (socketpair(AF_UNIX, SOCK_STREAM, 0, fds) == -1)
+    return strerror(errno);
+  fcntl(fds[0], F_SETFL, O_NONBLOCK);
+  fcntl(fds[1], F_SETFL, O_NONBLOCK);
+
+  errno = 0;
+  const int64_t written = http1_serialize_batch_write(fds[1], requests, ARR_SIZE(requests));
+  const bool would_block = (errno == EAGAIN) | (errno == EWOULDBLOCK);
+
+  int64_t received = 0;
+  char sink[65536];
+  ssize_t len;
+  while ((len = read(fds[0], sink, sizeof(sink))) > 0)
+    received += len;
+
+  close(fds[0]);
+  close(fds[1]);
+
+  mu_assert("error: serialize batch write partial: should stop on a full socket", would_block);
+  mu_assert("error: serialize batch write partial: progress lost", written > 0 && written < 2 * (int64_t)sizeof(body));
+  mu_assert("error: serialize batch write partial: wrong progress", written == received);
+
+  return 0;
+}
+
+static char *test_deserialize_arena_full(void)
+{
+  char buffer[] =
+    "HTTP/1.1 204 No Content\r\n"
+    "\r\n";
+  char request_buffer[] =
+    "GET / HTTP/1.1\r\n"
+    "\r\n";
+  //an unaligned end leaves no room for a tail at all
+  alignas(HTTP_ARENA_ALIGNMENT) static char memory[HTTP_ARENA_ALIGNMENT + 1];
+  http_arena_t arena;
+  http_arena_init(&arena, memory, sizeof(memory));
+  mu_assert("error: deserialize arena full: alloc failed", http_arena_alloc(&arena, sizeof(memory)) != NULL);
+
+  http_response_t response = {0};
+  mu_assert("error: deserialize arena full: wrong length", http1_deserialize_arena(buffer, STR_LEN(buffer), &response, &arena) == STR_LEN(buffer));
+  mu_assert("error: deserialize arena full: wrong headers count", response.headers_count == 0);
+  mu_assert("error: deserialize arena full: arena changed", arena.used == sizeof(memory));
+
+  http_request_t request = {0};
+  mu_assert("error: deserialize arena full: wrong request length", http1_deserialize_request_arena(request_buffer, STR_LEN(request_buffer), &request, &arena) == STR_LEN(request_buffer));
+  mu_assert("error: deserialize arena full: arena changed by request", arena.used == sizeof(memory));
+
+  return 0;
+}
+
+static char *test_template_content_length(void)
+{
+  http_header_t headers[] = {
+    { .key = "Host", .value = "example.com", .key_len = 4, .value_len = 11, .id = HTTP_HEADER_HOST },
+    { .key = "X-Request-Id", .value = NULL, .key_len = 12 }
+  };
+  const http_request_t request = {
+    .method = HTTP_POST,
+    .path = "/upload",
+    .path_len = 7,
+    .version = HTTP_1_1,
+    .headers = headers,
+    .headers_count = ARR_SIZE(headers),
+    .emit_content_length = true
+  };
+  const char expected[] =
+    "POST /upload HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "X-Request-Id: 7\r\n"
+    "Content-Length: 11\r\n"
+    "\r\n"
+    "hello world";
+
+  static http_request_template_t template;
+  mu_assert("error: template content length: compile failed", http1_template_compile(&template, &request) != 0);
+
+  const struct iovec values[] = {
+    { "7", 1 }
+  };
+
+  char buffer[256];
+  const uint32_t len = http1_template_serialize(buffer, &template, values, "hello world", 11);
+  mu_assert("error: template content length: wrong length", len == STR_LEN(expected));
+  mu_assert("error: template content length: wrong output", memcmp(buffer, expected, len) == 0);
+
+  int fds[2];
+  if (pipe(fds) == -1)
+    return strerror(errno);
+  const int32_t written = http1_template_write(fds[1], &template, values, "hello world", 11);
+  close(fds[1]);
+  const bool match = compare_file(fds[0], expected, STR_LEN(expected));
+  close(fds[0]);
+
+  mu_assert("error: template content length write: wrong length", written == STR_LEN(expected));
+  mu_assert("error: template content length write: wrong output", match);
+
+  const char empty[] =
+    "POST /upload HTTP/1.1\r\n"
+    "Host: example.com\r\n"
+    "X-Request-Id: 7\r\n"
+    "Content-Length: 0\r\n"
+    "\r\n";
+  const uint32_t empty_len = http1_template_serialize(buffer, &template, values, NULL, 0);
+  mu_assert("error: template content length: wrong empty body", empty_len == STR_LEN(empty) && memcmp(buffer, empty, empty_len) == 0);
+
+  return 0;
+}
+
+static char *test_hpack_never_indexed(void)
+{
+  alignas(64) static char memory[HTTP_HPACK_TABLE_MEMORY(4096)];
+  alignas(64) static char peer_memory[HTTP_HPACK_TABLE_MEMORY(4096)];
+  http_hpack_table_t encoder;
+  http_hpack_table_t decoder;
+  http_hpack_table_init(&encoder, memory, 4096);
+  http_hpack_table_init(&decoder, peer_memory, 4096);
+
+  const http_header_t headers[] = {
+    { .key = "Authorization", .value = "Bearer secret", .key_len = 13, .value_len = 13, .id = HTTP_HEADER_AUTHORIZATION },
+    { .key = "Cookie", .value = "session=1234", .key_len = 6, .value_len = 12, .id = HTTP_HEADER_COOKIE },
+    { .key = "X-Request-Id", .value = "abc", .key_len = 12, .value_len = 3 }
+  };
+  char block[256];
+  const uint32_t len = http_hpack_encode(&encoder, block, headers, ARR_SIZE(headers));
+  //authorization is static name 23: never-indexed with a 4-bit prefix, 15 + 8
+  mu_assert("error: hpack never indexed: wrong representation", (uint8_t)block[0] == 0x1F && block[1] == 0x08);
+  mu_assert("error: hpack never indexed: credentials indexed", encoder.count == 1);
+
+  http_header_t decoded[4];
+  uint16_t decoded_count = ARR_SIZE(decoded);
+  char scratch[256];
+  mu_assert("error: hpack never indexed: decoding failed", http_hpack_decode(&decoder, block, len, decoded, &decoded_count, scratch, sizeof(scratch)));
+  mu_assert("error: hpack never indexed: wrong headers", decoded_count == 3 && decoded[0].id == HTTP_HEADER_AUTHORIZATION && decoded[0].value_len == 13 && memcmp(decoded[0].value, "Bearer secret", 13) == 0 && decoded[1].id == HTTP_HEADER_COOKIE);
+  mu_assert("error: hpack never indexed: tables out of sync", decoder.count == 1);
+
+  alignas(64) static char encoder_memory[HTTP_QPACK_TABLE_MEMORY(4096)];
+  alignas(64) static char decoder_memory[HTTP_QPACK_TABLE_MEMORY(4096)];
+  http_qpack_encoder_t qpack_encoder;
+  http_qpack_decoder_t qpack_decoder;
+  http_qpack_encoder_init(&qpack_encoder, encoder_memory, 4096, 4096);
+  http_qpack_decoder_init(&qpack_decoder, decoder_memory, 4096);
+
+  char instructions[256];
+  uint32_t instructions_len;
+  const uint32_t block_len = http_qpack_encode(&qpack_encoder, 0, block, headers, 1, instructions, &instructions_len);
+  //authorization is static name 84: the N bit is set with a 4-bit prefix, 15 + 69
+  mu_assert("error: qpack never indexed: wrong representation", (uint8_t)block[2] == 0x7F && block[3] == 0x45);
+  mu_assert("error: qpack never indexed: credentials inserted", instructions_len == 0 && qpack_encoder.insert_count == 0);
+
+  decoded_count = ARR_SIZE(decoded);
+  mu_assert("error: qpack never indexed: decoding failed", http_qpack_decode(&qpack_decoder, block, block_len, decoded, &decoded_count, scratch, sizeof(scratch)) == block_len);
+  mu_assert("error: qpack never indexed: wrong header", decoded_count == 1 && decoded[0].id == HTTP_HEADER_AUTHORIZATION && decoded[0].value_len == 13 && memcmp(decoded[0].value, "Bearer secret", 13) == 0);
+
+  return 0;
+}
+
+static char *test_http2_deserialize_invalid_fields(void)
+{
+  alignas(64) static char memory[HTTP_HPACK_TABLE_MEMORY(HTTP_HPACK_DEFAULT_TABLE_SIZE)];
+  http_hpack_table_t table;
+  http_hpack_table_init(&table, memory, HTTP_HPACK_DEFAULT_TABLE_SIZE);
+
+  http_header_t headers[8];
+  char scratch[256];
+
+  //GET https / with content-length, static name 28, sent as literals without indexing
+  char same[] = "\x82\x87\x84\x0f\x0d\x01" "5" "\x0f\x0d\x01" "5";
+  http_request_t request = { .headers = headers, .headers_count = ARR_SIZE(headers) };
+  mu_assert("error: http2 invalid fields: repeated content-length rejected", http2_deserialize_request(&table, same, STR_LEN(same), &request, scratch, sizeof(scratch)));
+  mu_assert("error: http2 invalid fields: wrong content-length", request.body_len == 5 && request.framing == HTTP_FRAMING_CONTENT_LENGTH);
+
+  char different[] = "\x82\x87\x84\x0f\x0d\x01" "5" "\x0f\x0d\x01" "6";
+  request = (http_request_t){ .headers = headers, .headers_count = ARR_SIZE(headers) };
+  mu_assert("error: http2 invalid fields: conflicting content-length accepted", !http2_deserialize_request(&table, different, STR_LEN(different), &request, scratch, sizeof(scratch)));
+
+  char lowercase[] = "\x82\x87\x84\x00\x06" "x-test" "\x01" "a";
+  request = (http_request_t){ .headers = headers, .headers_count = ARR_SIZE(headers) };
+  mu_assert("error: http2 invalid fields: lowercase name rejected", http2_deserialize_request(&table, lowercase, STR_LEN(lowercase), &request, scratch, sizeof(scratch)));
+
+  char uppercase[] = "\x82\x87\x84\x00\x06" "x-Test" "\x01" "a";
+  request = (http_request_t){ .headers = headers, .headers_count = ARR_SIZE(headers) };
+  mu_assert("error: http2 invalid fields: uppercase name accepted", !http2_deserialize_request(&table, uppercase, STR_LEN(uppercase), &request, scratch, sizeof(scratch)));
+
+  char response_different[] = "\x88\x0f\x0d\x01" "5" "\x0f\x0d\x02" "50";
+  http_response_t response = { .headers = headers, .headers_count = ARR_SIZE(headers) };
+  mu_assert("error: http2 invalid fields: conflicting response content-length accepted", !http2_deserialize_response(&table, response_different, STR_LEN(response_different), &response, scratch, sizeof(scratch)));
+
+  char response_uppercase[] = "\x88\x00\x0c" "Content-Type" "\x01" "a";
+  response = (http_response_t){ .headers = headers, .headers_count = ARR_SIZE(headers) };
+  mu_assert("error: http2 invalid fields: uppercase response name accepted", !http2_deserialize_response(&table, response_uppercase, STR_LEN(response_uppercase), &response, scratch, sizeof(scratch)));
+
+  return 0;
+}
+
+static char *test_serialize_out_of_range_id(void)
+{
+  http_header_t headers[] = {
+    { .key = "X-Test", .value = "1", .key_len = 6, .value_len = 1, .id = (http_header_id_t)200 }
+  };
+  const http_request_t request = {
+    .method = HTTP_GET,
+    .path = "/",
+    .path_len = 1,
+    .version = HTTP_1_1,
+    .headers = headers,
+    .headers_count = ARR_SIZE(headers)
+  };
+  const char expected[] =
+    "GET / HTTP/1.1\r\n"
+    "X-Test: 1\r\n"
+    "\r\n";
+
+  char buffer[64];
+  const uint32_t len = http1_serialize(buffer, &request);
+  mu_assert("error: serialize out of range id: wrong output", len == STR_LEN(expected) && memcmp(buffer, expected, len) == 0);
+
+  int fds[2];
+  if (pipe(fds) == -1)
+    return strerror(errno);
+  const int32_t written = http1_serialize_write(fds[1], &request);
+  close(fds[1]);
+  const bool match = compare_file(fds[0], expected, STR_LEN(expected));
+  close(fds[0]);
+  mu_assert("error: serialize out of range id: wrong written output", written == STR_LEN(expected) && match);
+
+  alignas(64) static char memory[HTTP_HPACK_TABLE_MEMORY(HTTP_HPACK_DEFAULT_TABLE_SIZE)];
+  http_hpack_table_t table;
+  http_hpack_table_init(&table, memory, HTTP_HPACK_DEFAULT_TABLE_SIZE);
+  char block[64];
+  const uint32_t block_len = http_hpack_encode(&table, block, headers, 1);
+  http_hpack_table_init(&table, memory, HTTP_HPACK_DEFAULT_TABLE_SIZE);
+  http_header_t decoded[1];
+  uint16_t decoded_count = ARR_SIZE(decoded);
+  char scratch[64];
+  mu_assert("error: serialize out of range id: hpack block not decoded", http_hpack_decode(&table, block, block_len, decoded, &decoded_count, scratch, sizeof(scratch)));
+  mu_assert("error: serialize out of range id: wrong hpack name", decoded_count == 1 && decoded[0].key_len == 6 && memcmp(decoded[0].key, "x-test", 6) == 0);
+
+  return 0;
+}
+
+static char *test_uring_short_write(void)
+{
+  static http_uring_slot_t slots[2];
+  http_uring_t ring;
+  if (http_uring_init(&ring, slots, ARR_SIZE(slots)) == -1)
+    return (errno == ENOSYS || errno == EPERM) ? 0 : strerror(errno);
+
+  static char body[20000];
+  memset(body, 'x', sizeof(body));
+  const http_request_t request = {
+    .method = HTTP_POST,
+    .path = "/upload",
+    .path_len = 7,
+    .version = HTTP_1_1,
+    .body = body,
+    .body_len = sizeof(body)
+  };
+
+  //a non-blocking pipe of a single page only takes part of the request per write
+  int fds[2];
+  if (pipe2(fds, O_NONBLOCK) == -1)
+    return strerror(errno);
+  fcntl(fds[1], F_SETPIPE_SZ, 4096);
+
+  const int32_t len = http1_uring_prep_write(&ring, fds[1], &request, 7, 0);
+  mu_assert("error: uring short write: prep failed", len == STR_LEN("POST /upload HTTP/1.1\r\n\r\n") + sizeof(body));
+
+  static char received[sizeof(body) + 64];
+  uint32_t received_len = 0;
+  http_uring_completion_t completion;
+  uint16_t count = 0;
+  for (uint16_t round = 0; (round < 64) && (count == 0); round++)
+  {
+    mu_assert("error: uring short write: submit failed", http_uring_submit(&ring, 1) >= 0);
+    count = http_uring_reap(&ring, &completion, 1);
+    const ssize_t bytes_read = read(fds[0], received + received_len, sizeof(received) - received_len);
+    received_len += (bytes_read > 0) ? bytes_read : 0;
+  }
+  const ssize_t bytes_read = read(fds[0], received + received_len, sizeof(received) - received_len);
+  received_len += (bytes_read > 0) ? bytes_read : 0;
+
+  mu_assert("error: uring short write: no completion", count == 1 && completion.cookie == 7);
+  mu_assert("error: uring short write: wrong result", completion.result == len && completion.length == (uint32_t)len);
+  mu_assert("error: uring short write: wrong output", received_len == (uint32_t)len && memcmp(received + len - sizeof(body), body, sizeof(body)) == 0);
+
+  close(fds[0]);
+  close(fds[1]);
+  http_uring_destroy(&ring);
+
+  return 0;
+}
+
+static char *test_http2_deserialize_literal_names(void)
+{
+  alignas(64) static char memory[HTTP_HPACK_TABLE_MEMORY(HTTP_HPACK_DEFAULT_TABLE_SIZE)];
+  http_hpack_table_t table;
+  http_hpack_table_init(&table, memory, HTTP_HPACK_DEFAULT_TABLE_SIZE);
+
+  http_header_t headers[8];
+  char scratch[256];
+
+  //GET https / then content-length sent twice as a literal name, without indexing
+  char different[] = "\x82\x87\x84\x00\x0e" "content-length" "\x01" "5" "\x00\x0e" "content-length" "\x01" "9";
+  http_request_t request = { .headers = headers, .headers_count = ARR_SIZE(headers) };
+  mu_assert("error: http2 literal names: conflicting content-length accepted", !http2_deserialize_request(&table, different, STR_LEN(different), &request, scratch, sizeof(scratch)));
+
+  char single[] = "\x82\x87\x84\x00\x0e" "content-length" "\x01" "5";
+  request = (http_request_t){ .headers = headers, .headers_count = ARR_SIZE(headers) };
+  mu_assert("error: http2 literal names: content-length rejected", http2_deserialize_request(&table, single, STR_LEN(single), &request, scratch, sizeof(scratch)));
+  mu_assert("error: http2 literal names: content-length ignored", request.framing == HTTP_FRAMING_CONTENT_LENGTH && request.body_len == 5 && headers[0].id == HTTP_HEADER_CONTENT_LENGTH);
+
+  //:authority example.com, then a literal host that must not become a second Host header
+  char host[] = "\x82\x87\x84\x01\x0b" "example.com" "\x00\x04" "host" "\x04" "evil";
+  request = (http_request_t){ .headers = headers, .headers_count = ARR_SIZE(headers) };
+  mu_assert("error: http2 literal names: request with host rejected", http2_deserialize_request(&table, host, STR_LEN(host), &request, scratch, sizeof(scratch)));
+  mu_assert("error: http2 literal names: host kept next to :authority", request.headers_count == 1 && headers[0].id == HTTP_HEADER_HOST && headers[0].value_len == 11 && memcmp(headers[0].value, "example.com", 11) == 0);
+
+  char response_different[] = "\x88\x00\x0e" "content-length" "\x01" "5" "\x00\x0e" "content-length" "\x01" "9";
+  http_response_t response = { .headers = headers, .headers_count = ARR_SIZE(headers) };
+  mu_assert("error: http2 literal names: conflicting response content-length accepted", !http2_deserialize_response(&table, response_different, STR_LEN(response_different), &response, scratch, sizeof(scratch)));
+
+  //the same request over QPACK: GET, https and / from the static table, then the literal names
+  alignas(64) static char decoder_memory[HTTP_QPACK_TABLE_MEMORY(0)];
+  http_qpack_decoder_t decoder;
+  http_qpack_decoder_init(&decoder, decoder_memory, 0);
+  char section[] = "\x00\x00\xd1\xd7\xc1\x27\x07" "content-length" "\x01" "5" "\x27\x07" "content-length" "\x01" "9";
+  request = (http_request_t){ .headers = headers, .headers_count = ARR_SIZE(headers) };
+  mu_assert("error: http3 literal names: conflicting content-length accepted", http3_deserialize_request(&decoder, section, STR_LEN(section), &request, scratch, sizeof(scratch)) == 0);
+
   return 0;
 }
\ No newline at end of file